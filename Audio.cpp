@@ -0,0 +1,544 @@
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <QDebug>
+#include <QtEndian>
+#ifdef RADIOPIXEL_ALSA
+#include <alsa/asoundlib.h>
+#endif
+#include "Audio.h"
+#include "Latency.h"
+
+
+const float LOW_HZ = 40; // bottom of the first band
+const float PEAK_HALF_LIFE = 2; // seconds for a band's peak to fall by half
+const float MIN_PEAK = 0.05f; // quieter than this is silence, not something to scale up
+const float ONSET_RATIO = 1.5f; // spectral flux over its running mean that counts as a beat
+const float ONSET_FLOOR = 1.0f; // and the least flux that does
+const float FLUX_SMOOTHING = 1.0f / 128; // per hop, about a third of a second
+const unsigned BEATS_PER_SECOND = 10; // at most
+const int READ_POLL_MS = 50; // a live source waiting on input checks for stop( ) this often
+
+
+// sleep until played samples are due, sources that aren't live run in
+// real time so frames line up with the sound
+static void pace( std::chrono::steady_clock::time_point start, uint64_t played, unsigned rate )
+{
+    std::this_thread::sleep_until( start + std::chrono::microseconds( played * 1000000 / rate ));
+}
+
+// PCM WAV, 16 bit, any number of channels mixed down
+class WavSource : public AudioSource
+{
+public:
+    WavSource( )
+        : m_file( NULL ), m_data( 0 ), m_size( 0 ), m_left( 0 ), m_channels( 1 ),
+          m_played( 0 )
+    {
+    }
+
+    ~WavSource( )
+    {
+        if ( m_file )
+        {
+            fclose( m_file );
+        }
+    }
+
+    bool open( const QString &path )
+    {
+        m_file = fopen( path.toLocal8Bit( ).constData( ), "rb" );
+        uchar riff[ 12 ];
+        if ( !m_file || fread( riff, 1, sizeof riff, m_file ) != sizeof riff ||
+             memcmp( riff, "RIFF", 4 ) || memcmp( riff + 8, "WAVE", 4 ))
+        {
+            return false;
+        }
+        bool format( false );
+        uchar chunk[ 8 ];
+        while ( fread( chunk, 1, sizeof chunk, m_file ) == sizeof chunk )
+        {
+            uint32_t size( qFromLittleEndian< quint32 >( chunk + 4 ));
+            if ( !memcmp( chunk, "fmt ", 4 ) && size >= 16 )
+            {
+                uchar fmt[ 16 ];
+                if ( fread( fmt, 1, sizeof fmt, m_file ) != sizeof fmt )
+                {
+                    return false;
+                }
+                m_channels = qFromLittleEndian< quint16 >( fmt + 2 );
+                m_rate = qFromLittleEndian< quint32 >( fmt + 4 );
+                format = qFromLittleEndian< quint16 >( fmt ) == 1 &&
+                    qFromLittleEndian< quint16 >( fmt + 14 ) == 16 && m_channels && m_rate;
+                size -= sizeof fmt;
+            }
+            else if ( !memcmp( chunk, "data", 4 ))
+            {
+                m_data = ftell( m_file );
+                m_size = m_left = size - size % ( 2 * m_channels );
+                m_start = std::chrono::steady_clock::now( );
+                return format && m_size;
+            }
+            // chunks are padded to even sizes
+            fseek( m_file, size + ( size & 1 ), SEEK_CUR );
+        }
+        return false;
+    }
+
+    virtual int read( int16_t *samples, int count )
+    {
+        m_frames.resize( count * m_channels );
+        int done( 0 );
+        while ( done < count )
+        {
+            if ( !m_left )
+            {
+                // loop
+                fseek( m_file, m_data, SEEK_SET );
+                m_left = m_size;
+            }
+            uint32_t want( ( count - done ) * m_channels * 2 );
+            want = ( want < m_left ) ? want : m_left;
+            size_t got( fread( m_frames.data( ), 2 * m_channels, want / ( 2 * m_channels ), m_file ));
+            if ( !got )
+            {
+                return 0;
+            }
+            m_left -= got * 2 * m_channels;
+            for ( size_t i = 0; i < got; ++i )
+            {
+                int sum( 0 );
+                for ( int c = 0; c < m_channels; ++c )
+                {
+                    sum += qFromLittleEndian< qint16 >( m_frames[ i * m_channels + c ] );
+                }
+                samples[ done++ ] = sum / m_channels;
+            }
+        }
+        m_played += count;
+        pace( m_start, m_played, m_rate );
+        return count;
+    }
+
+private:
+    FILE *m_file;
+    long m_data; // offset of the samples
+    uint32_t m_size; // bytes of them
+    uint32_t m_left; // until the loop
+    int m_channels;
+    std::vector< int16_t > m_frames;
+    std::chrono::steady_clock::time_point m_start;
+    uint64_t m_played;
+};
+
+// s16le mono on stdin, eg from a capture tool or a file for tests
+class RawSource : public AudioSource
+{
+public:
+    RawSource( unsigned rate )
+        : m_paced( false ), m_played( 0 )
+    {
+        m_rate = rate;
+
+        // a pipe comes in at its own pace, a file would all come at once
+        struct stat st;
+        m_paced = fstat( fileno( stdin ), &st ) == 0 && S_ISREG( st.st_mode );
+        m_start = std::chrono::steady_clock::now( );
+    }
+
+    virtual int read( int16_t *samples, int count )
+    {
+        // poll the descriptor rather than block in fread, so stop( ) isn't
+        // held up by a pipe that has gone quiet
+        int fd( fileno( stdin ));
+        size_t want( count * sizeof( int16_t )), bytes( 0 );
+        while ( bytes < want && !m_interrupted )
+        {
+            struct pollfd ready = { fd, POLLIN, 0 };
+            int polled( poll( &ready, 1, READ_POLL_MS ));
+            if ( polled < 0 && errno != EINTR )
+            {
+                break;
+            }
+            if ( polled <= 0 )
+            {
+                continue;
+            }
+            ssize_t chunk( ::read( fd, ( char *)samples + bytes, want - bytes ));
+            if ( chunk < 0 && errno == EINTR )
+            {
+                continue;
+            }
+            if ( chunk <= 0 )
+            {
+                break; // the end of the input
+            }
+            bytes += chunk;
+        }
+        if ( m_interrupted )
+        {
+            return 0;
+        }
+
+        size_t got( bytes / sizeof( int16_t ));
+        for ( size_t i = 0; i < got; ++i )
+        {
+            samples[ i ] = qFromLittleEndian( samples[ i ] );
+        }
+        if ( m_paced )
+        {
+            m_played += got;
+            pace( m_start, m_played, m_rate );
+        }
+        return got;
+    }
+
+private:
+    bool m_paced;
+    std::chrono::steady_clock::time_point m_start;
+    uint64_t m_played;
+};
+
+#ifdef RADIOPIXEL_ALSA
+// live capture, with a period of a hop so nothing waits on a big buffer
+class AlsaSource : public AudioSource
+{
+public:
+    AlsaSource( )
+        : m_pcm( NULL )
+    {
+        m_rate = 44100;
+    }
+
+    ~AlsaSource( )
+    {
+        if ( m_pcm )
+        {
+            snd_pcm_close( m_pcm );
+        }
+    }
+
+    bool open( const QString &device )
+    {
+        // non-blocking, read( ) waits in snd_pcm_wait so it can see stop( )
+        int err( snd_pcm_open( &m_pcm, device.toLocal8Bit( ).constData( ), SND_PCM_STREAM_CAPTURE,
+                               SND_PCM_NONBLOCK ));
+        if ( err >= 0 )
+        {
+            // 10 ms of buffer
+            err = snd_pcm_set_params( m_pcm, SND_PCM_FORMAT_S16, SND_PCM_ACCESS_RW_INTERLEAVED,
+                                      1, m_rate, 1, 10000 );
+        }
+        if ( err < 0 )
+        {
+            qWarning( ) << "can't capture from" << device << snd_strerror( err );
+            return false;
+        }
+        return true;
+    }
+
+    virtual int read( int16_t *samples, int count )
+    {
+        int done( 0 );
+        while ( done < count )
+        {
+            if ( m_interrupted )
+            {
+                return 0;
+            }
+            snd_pcm_sframes_t got( snd_pcm_readi( m_pcm, samples + done, count - done ));
+            if ( got == -EAGAIN )
+            {
+                snd_pcm_wait( m_pcm, READ_POLL_MS );
+                continue;
+            }
+            if ( got < 0 )
+            {
+                // overruns just lose some sound
+                if ( snd_pcm_recover( m_pcm, got, 1 ) < 0 )
+                {
+                    return 0;
+                }
+                continue;
+            }
+            done += got;
+        }
+        return done;
+    }
+
+private:
+    snd_pcm_t *m_pcm;
+};
+#endif
+
+AudioSource *AudioSource::create( const QString &spec )
+{
+    QString kind( spec.section( ':', 0, 0 ));
+    QString arg( spec.section( ':', 1 ));
+    if ( kind == "wav" )
+    {
+        WavSource *source( new WavSource( ));
+        if ( source->open( arg ))
+        {
+            return source;
+        }
+        qWarning( ) << "can't play" << arg << "as 16 bit PCM";
+        delete source;
+    }
+    else if ( kind == "raw" )
+    {
+        bool ok;
+        unsigned rate( arg.isEmpty( ) ? 44100 : arg.toUInt( &ok ));
+        if ( arg.isEmpty( ) || ( ok && rate ))
+        {
+            return new RawSource( rate );
+        }
+    }
+#ifdef RADIOPIXEL_ALSA
+    else if ( kind == "alsa" )
+    {
+        AlsaSource *source( new AlsaSource( ));
+        if ( source->open( arg.isEmpty( ) ? QString( "default" ) : arg ))
+        {
+            return source;
+        }
+        delete source;
+    }
+#endif
+    return NULL;
+}
+
+//-------------------------------------------------------------
+
+AudioAnalyzer::AudioAnalyzer( )
+    : m_source( NULL ), m_running( false ), m_seq( 0 ),
+      m_samples( WINDOW ), m_hann( WINDOW ),
+      m_twiddles( WINDOW / 2 ), m_split( WINDOW + 2 ), m_reversed( WINDOW / 2 ),
+      m_re( WINDOW / 2 ), m_im( WINDOW / 2 ),
+      m_magnitudes( WINDOW / 2 + 1 ), m_lastMagnitudes( WINDOW / 2 + 1 ),
+      m_flux( 0 ), m_sinceBeat( 0 )
+{
+    memset( &m_frame, 0, sizeof m_frame );
+    memset( &m_next, 0, sizeof m_next );
+
+    const int half( WINDOW / 2 );
+    for ( int i = 0; i < WINDOW; ++i )
+    {
+        m_hann[ i ] = 0.5f - 0.5f * cosf( 2 * M_PI * i / WINDOW );
+    }
+    for ( int k = 0; k < half / 2; ++k )
+    {
+        m_twiddles[ 2 * k ] = cosf( 2 * M_PI * k / half );
+        m_twiddles[ 2 * k + 1 ] = -sinf( 2 * M_PI * k / half );
+    }
+    for ( int k = 0; k <= half; ++k )
+    {
+        m_split[ 2 * k ] = cosf( 2 * M_PI * k / WINDOW );
+        m_split[ 2 * k + 1 ] = -sinf( 2 * M_PI * k / WINDOW );
+    }
+    int bits( 0 );
+    while ( ( 1 << bits ) < half )
+    {
+        ++bits;
+    }
+    for ( int i = 0; i < half; ++i )
+    {
+        int r( 0 );
+        for ( int b = 0; b < bits; ++b )
+        {
+            r |= ( ( i >> b ) & 1 ) << ( bits - 1 - b );
+        }
+        m_reversed[ i ] = r;
+    }
+}
+
+AudioAnalyzer::~AudioAnalyzer( )
+{
+    stop( );
+}
+
+void AudioAnalyzer::start( AudioSource *source )
+{
+    stop( );
+    if ( !source )
+    {
+        return;
+    }
+    m_source = source;
+
+    // log spaced bands, every one at least a bin wide, DC left out
+    const int half( WINDOW / 2 );
+    float top( m_source->rate( ) / 2.0f );
+    for ( int b = 0; b <= AUDIO_BANDS; ++b )
+    {
+        float hz( LOW_HZ * powf( top / LOW_HZ, ( float )b / AUDIO_BANDS ));
+        int bin( ( int )( hz * WINDOW / m_source->rate( ) + 0.5f ));
+        int least( b ? m_bandEdges[ b - 1 ] + 1 : 1 );
+        m_bandEdges[ b ] = ( bin < least ) ? least : ( bin > half + 1 ) ? half + 1 : bin;
+    }
+    for ( int b = 0; b < AUDIO_BANDS; ++b )
+    {
+        m_peaks[ b ] = MIN_PEAK;
+    }
+    m_flux = 0;
+    m_sinceBeat = 0;
+    std::fill( m_samples.begin( ), m_samples.end( ), 0 );
+    std::fill( m_lastMagnitudes.begin( ), m_lastMagnitudes.end( ), 0 );
+
+    m_running = true;
+    m_thread = std::thread( &AudioAnalyzer::run, this );
+}
+
+void AudioAnalyzer::stop( )
+{
+    if ( !m_source )
+    {
+        return;
+    }
+    m_running = false;
+    m_source->interrupt( );
+    m_thread.join( );
+    delete m_source;
+    m_source = NULL;
+}
+
+void AudioAnalyzer::publish( const AudioFrame &frame )
+{
+    uint32_t seq( m_seq.load( std::memory_order_relaxed ));
+    m_seq.store( seq + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+    m_frame = frame;
+    m_seq.store( seq + 2, std::memory_order_release );
+}
+
+void AudioAnalyzer::run( )
+{
+    int16_t hop[ HOP ];
+    while ( m_running.load( std::memory_order_relaxed ))
+    {
+        int got( m_source->read( hop, HOP ));
+        if ( got <= 0 )
+        {
+            if ( m_running.load( std::memory_order_relaxed ))
+            {
+                qWarning( ) << "audio input ended";
+            }
+            break;
+        }
+        uint64_t stamp( StampNow( ));
+
+        // slide the window on
+        memmove( m_samples.data( ), m_samples.data( ) + got, ( WINDOW - got ) * sizeof( int16_t ));
+        memcpy( m_samples.data( ) + WINDOW - got, hop, got * sizeof( int16_t ));
+        analyse( stamp );
+    }
+}
+
+void AudioAnalyzer::analyse( uint64_t stamp )
+{
+    const int half( WINDOW / 2 );
+
+    // a real FFT as a half size complex one, even samples real and odd imaginary
+    for ( int i = 0; i < half; ++i )
+    {
+        m_re[ i ] = m_samples[ 2 * i ] * m_hann[ 2 * i ] * ( 1.0f / 32768 );
+        m_im[ i ] = m_samples[ 2 * i + 1 ] * m_hann[ 2 * i + 1 ] * ( 1.0f / 32768 );
+    }
+    Fft( m_re.data( ), m_im.data( ), half, m_twiddles.data( ), m_reversed.data( ));
+
+    // then split: X[ k ] = E[ k ] + W^k O[ k ], where E and O are the even
+    // and odd samples' spectra, ( Z[ k ] ± conj Z[ half - k ] ) / 2 and / 2i
+    float flux( 0 );
+    for ( int k = 0; k <= half; ++k )
+    {
+        int a( k & ( half - 1 ));
+        int b( ( half - k ) & ( half - 1 ));
+        float er( ( m_re[ a ] + m_re[ b ] ) * 0.5f );
+        float ei( ( m_im[ a ] - m_im[ b ] ) * 0.5f );
+        float odr( ( m_im[ a ] + m_im[ b ] ) * 0.5f );
+        float odi( ( m_re[ b ] - m_re[ a ] ) * 0.5f );
+        float wr( m_split[ 2 * k ] ), wi( m_split[ 2 * k + 1 ] );
+        float xr( er + wr * odr - wi * odi );
+        float xi( ei + wr * odi + wi * odr );
+        m_magnitudes[ k ] = sqrtf( xr * xr + xi * xi );
+        float rise( m_magnitudes[ k ] - m_lastMagnitudes[ k ] );
+        flux += ( rise > 0 ) ? rise : 0;
+    }
+
+    // bands against their own recent peaks, so quiet music still moves
+    float decay( powf( 0.5f, HOP / ( PEAK_HALF_LIFE * m_source->rate( ))));
+    for ( int band = 0; band < AUDIO_BANDS; ++band )
+    {
+        float power( 0 );
+        int first( m_bandEdges[ band ] ), end( m_bandEdges[ band + 1 ] );
+        for ( int k = first; k < end; ++k )
+        {
+            power += m_magnitudes[ k ] * m_magnitudes[ k ];
+        }
+        float value( sqrtf( power / ( end - first )));
+        m_peaks[ band ] = std::max( std::max( value, m_peaks[ band ] * decay ), MIN_PEAK );
+        m_next.bands[ band ] = ( uint8_t )( 255 * value / m_peaks[ band ] );
+    }
+
+    // loudness of the newest hop, against full scale
+    float sum( 0 );
+    for ( int i = WINDOW - HOP; i < WINDOW; ++i )
+    {
+        float sample( m_samples[ i ] * ( 1.0f / 32768 ));
+        sum += sample * sample;
+    }
+    float db( 10 * log10f( sum / HOP + 1e-12f ));
+    m_next.level = ( db <= -60 ) ? 0 : ( db >= 0 ) ? 255 : ( uint8_t )( ( db + 60 ) * 255 / 60 );
+
+    // onsets: flux well over its running mean, and not too close together
+    ++m_sinceBeat;
+    if ( flux > m_flux * ONSET_RATIO && flux > ONSET_FLOOR &&
+         m_sinceBeat * HOP * BEATS_PER_SECOND >= m_source->rate( ))
+    {
+        ++m_next.beats;
+        m_next.beatStamp = stamp;
+        m_sinceBeat = 0;
+    }
+    m_flux += ( flux - m_flux ) * FLUX_SMOOTHING;
+    m_lastMagnitudes.swap( m_magnitudes );
+
+    ++m_next.hop;
+    m_next.stamp = stamp;
+    publish( m_next );
+}
+
+void AudioAnalyzer::Fft( float *re, float *im, int n, const float *twiddles, const uint16_t *reversed )
+{
+    for ( int i = 0; i < n; ++i )
+    {
+        int j( reversed[ i ] );
+        if ( i < j )
+        {
+            std::swap( re[ i ], re[ j ] );
+            std::swap( im[ i ], im[ j ] );
+        }
+    }
+    for ( int size = 2; size <= n; size <<= 1 )
+    {
+        int half( size / 2 ), stride( n / size );
+        for ( int start = 0; start < n; start += size )
+        {
+            for ( int k = 0; k < half; ++k )
+            {
+                float wr( twiddles[ 2 * k * stride ] ), wi( twiddles[ 2 * k * stride + 1 ] );
+                int a( start + k ), b( a + half );
+                float tr( re[ b ] * wr - im[ b ] * wi );
+                float ti( re[ b ] * wi + im[ b ] * wr );
+                re[ b ] = re[ a ] - tr;
+                im[ b ] = im[ a ] - ti;
+                re[ a ] += tr;
+                im[ a ] += ti;
+            }
+        }
+    }
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <QString>
+
+#include "Pattern.h"
+
+
+const int AUDIO_BANDS = 8; // log spaced, 40 Hz up to half the rate
+
+// what a Player follows, combined as a bit mask
+enum
+{
+    AUDIO_REACT_NONE       = 0x00,
+    AUDIO_REACT_BRIGHTNESS = 0x01, // loudness opens the step's brightness
+    AUDIO_REACT_SPEED      = 0x02  // bass pushes the pattern along
+};
+
+
+// The newest analysis, small enough to copy every frame
+struct AudioFrame
+{
+    uint32_t hop; // hops analysed, 0 before the first
+    uint64_t stamp; // when its newest sample came in, see StampNow( )
+    uint8_t level; // loudness, -60 dBFS to full scale as 0 - 255
+    uint8_t bands[ AUDIO_BANDS ]; // low to high, each against its own recent peak
+    uint32_t beats; // onsets so far
+    uint64_t beatStamp; // when the last one came in, 0 for none yet
+
+    //! 255 on a beat fading to 0 over decay ms, as of this analysis
+    uint8_t pulse( ms_t decay ) const
+    {
+        if ( !beatStamp || !decay )
+        {
+            return 0;
+        }
+        uint64_t age( ( stamp - beatStamp ) / 1000000 );
+        return ( age < decay ) ? 255 - age * 255 / decay : 0;
+    }
+};
+
+
+// Mono 16 bit samples from somewhere
+class AudioSource
+{
+public:
+    virtual ~AudioSource( ) {}
+
+    //! samples per second
+    unsigned rate( ) const { return m_rate; }
+
+    //! blocks until count samples are in, returns how many, 0 once there
+    // won't be any more
+    virtual int read( int16_t *samples, int count ) = 0;
+
+    //! make a read( ) waiting on input give up and return 0 soon, from
+    // another thread
+    void interrupt( ) { m_interrupted = true; }
+
+    //! "wav:path" looped in real time, "raw:rate" s16le mono on stdin, or
+    // "alsa:device" where ALSA was built in, NULL if bad
+    static AudioSource *create( const QString &spec );
+
+protected:
+    AudioSource( ) : m_rate( 0 ), m_interrupted( false ) {}
+
+    unsigned m_rate;
+    std::atomic< bool > m_interrupted; // live sources check this while they wait
+};
+
+
+// Windowed FFT of a source on a worker thread. The worker is the only
+// writer of the snapshot and guards it with a seqlock: odd while it is
+// writing, so a reader that sees the same even count either side of its
+// copy knows it isn't torn. Readers never block the worker, nor it them.
+//
+// A 512 sample window moved on 128 samples at a time keeps analysis under
+// 15 ms behind the input at 44.1 kHz, so a frame drawn from it is under
+// two 60 fps frames behind the sound.
+class AudioAnalyzer
+{
+public:
+    static const int WINDOW = 512;
+    static const int HOP = 128;
+
+    AudioAnalyzer( );
+
+    ~AudioAnalyzer( );
+
+    //! analyse source until stopped, takes ownership
+    void start( AudioSource *source );
+
+    void stop( );
+
+    bool isRunning( ) const { return m_source != NULL; }
+
+    //! copy of the newest analysis. Inline, so patterns that follow
+    // audio render without linking the analyzer.
+    AudioFrame snapshot( ) const
+    {
+        // the worker is only ever inside for a copy, so spin
+        AudioFrame frame;
+        for ( ;; )
+        {
+            uint32_t seq( m_seq.load( std::memory_order_acquire ));
+            if ( !( seq & 1 ))
+            {
+                frame = m_frame;
+                std::atomic_thread_fence( std::memory_order_acquire );
+                if ( m_seq.load( std::memory_order_relaxed ) == seq )
+                {
+                    return frame;
+                }
+            }
+        }
+    }
+
+    // kernels
+
+    //! in place radix-2 FFT of n complex values, twiddles holds n / 2
+    // e^-2πik/n as re, im pairs and reversed the bit reversal of 0 - n-1
+    static void Fft( float *re, float *im, int n, const float *twiddles, const uint16_t *reversed );
+
+private:
+    void run( );
+
+    // one hop: magnitudes of the window, then bands, level and onsets
+    void analyse( uint64_t stamp );
+
+    void publish( const AudioFrame &frame );
+
+    AudioSource *m_source;
+    std::thread m_thread;
+    std::atomic< bool > m_running;
+
+    // published
+    std::atomic< uint32_t > m_seq;
+    AudioFrame m_frame;
+
+    // worker only
+    AudioFrame m_next;
+    std::vector< int16_t > m_samples; // the window, oldest first
+    std::vector< float > m_hann;
+    std::vector< float > m_twiddles; // for the half size complex FFT
+    std::vector< float > m_split; // e^-2πik/WINDOW, to split it into the real one
+    std::vector< uint16_t > m_reversed;
+    std::vector< float > m_re, m_im;
+    std::vector< float > m_magnitudes, m_lastMagnitudes;
+    int m_bandEdges[ AUDIO_BANDS + 1 ]; // first bin of each band, then the end
+    float m_peaks[ AUDIO_BANDS ];
+    float m_flux; // running mean of spectral flux, the onset threshold
+    uint32_t m_sinceBeat; // hops
+};
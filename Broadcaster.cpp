@@ -0,0 +1,198 @@
+#include <string.h>
+#include <QTimerEvent>
+#include <QtEndian>
+#include "ClockSync.h"
+#include "DeskNode.h"
+#include "Broadcaster.h"
+
+
+const ms_t KEEPALIVE_MIN_MS = 250; // first repeat after a change
+const ms_t KEEPALIVE_MAX_MS = 16 * 1000;
+
+static_assert( BATCH_MAX >= 1 && BATCH_MAX <= 255, "a batch's count is one byte" );
+
+
+Broadcaster::Broadcaster( quint16 port, const QHostAddress &address, QObject *parent )
+    : QObject( parent ),
+      m_address( address ), m_port( port ),
+      m_sent( 0 )
+{
+}
+
+void Broadcaster::addGroup( uint8_t group, DeskNode *node )
+{
+    Group g;
+    g.group = group;
+    g.node = node;
+    g.valid = false;
+    g.due = millis( );
+    g.keepalive = KEEPALIVE_MIN_MS;
+    m_groups.append( g );
+
+    connect( node, SIGNAL( changed()),
+             this, SLOT( onChanged()));
+    send( );
+}
+
+void Broadcaster::onChanged( )
+{
+    // groups that really changed are due now; wait for the event loop so
+    // groups changing together go out in one datagram
+    ms_t now( millis( ));
+    bool due( false );
+    for ( int i = 0; i < m_groups.size( ); ++i )
+    {
+        Group &g( m_groups[ i ] );
+        RadioPixel::Command command;
+        if ( g.node->player( )->GetCommand( &command ) &&
+             ( !g.valid || memcmp( &command, &g.last, sizeof command ) != 0 ))
+        {
+            g.due = now;
+            g.keepalive = KEEPALIVE_MIN_MS;
+            due = true;
+        }
+    }
+    if ( due )
+    {
+        m_timer.start( 0, this );
+    }
+}
+
+void Broadcaster::timerEvent( QTimerEvent *event )
+{
+    if ( event->timerId( ) == m_timer.timerId( ))
+    {
+        send( );
+    }
+}
+
+void Broadcaster::send( )
+{
+    ms_t now( millis( ));
+    QByteArray batch;
+    int count( 0 );
+    QByteArray single;
+
+    for ( int i = 0; i < m_groups.size( ); ++i )
+    {
+        Group &g( m_groups[ i ] );
+        if ( ( qint32 )( g.due - now ) > 0 )
+        {
+            continue;
+        }
+        RadioPixel::Command command;
+        if ( !g.node->player( )->GetCommand( &command ))
+        {
+            continue;
+        }
+
+        // a step start only helps nodes on the same clock as us
+        ms_t epoch( g.node->sharesClock( ) ? g.node->player( )->GetStepTime( ) : 0 );
+
+        if ( m_groups.size( ) == 1 )
+        {
+            single.append( ( const char *)&command, sizeof command );
+            if ( epoch )
+            {
+                CommandEpoch trailer;
+                trailer.magic = qToLittleEndian( CommandEpoch::MAGIC );
+                trailer.epoch = qToLittleEndian( epoch );
+                single.append( ( const char *)&trailer, sizeof trailer );
+            }
+        }
+        else
+        {
+            if ( count == BATCH_MAX )
+            {
+                batch[ 4 ] = char( count );
+                m_socket.writeDatagram( batch, m_address, m_port );
+                ++m_sent;
+                batch.clear( );
+                count = 0;
+            }
+            if ( batch.isEmpty( ))
+            {
+                batch.resize( BATCH_HEADER );
+                qToLittleEndian< quint32 >( COMMAND_BATCH_MAGIC, ( uchar *)batch.data( ));
+            }
+            uchar le[ 4 ];
+            qToLittleEndian< quint32 >( epoch, le );
+            batch.append( char( g.group ));
+            batch.append( ( const char *)&command, sizeof command );
+            batch.append( ( const char *)le, sizeof le );
+            ++count;
+        }
+
+        g.last = command;
+        g.valid = true;
+        g.due = now + g.keepalive;
+        g.keepalive = qMin( g.keepalive * 2, KEEPALIVE_MAX_MS );
+    }
+
+    if ( !single.isEmpty( ))
+    {
+        m_socket.writeDatagram( single, m_address, m_port );
+        ++m_sent;
+    }
+    if ( count )
+    {
+        batch[ 4 ] = char( count );
+        m_socket.writeDatagram( batch, m_address, m_port );
+        ++m_sent;
+    }
+
+    // sleep until the next group is due
+    if ( !m_groups.isEmpty( ))
+    {
+        qint32 sleep( KEEPALIVE_MAX_MS );
+        for ( int i = 0; i < m_groups.size( ); ++i )
+        {
+            sleep = qMin( sleep, ( qint32 )( m_groups[ i ].due - now ));
+        }
+        m_timer.start( qMax( sleep, 0 ), this );
+    }
+}
+
+bool Broadcaster::parse( const char *data, qint64 size, uint8_t group,
+                         RadioPixel::Command *command, ms_t *epoch )
+{
+    *epoch = 0;
+
+    if ( size >= BATCH_HEADER &&
+         qFromLittleEndian< quint32 >( ( const uchar *)data ) == COMMAND_BATCH_MAGIC )
+    {
+        int count( ( uchar )data[ 4 ] );
+        if ( size < BATCH_HEADER + count * BATCH_ENTRY )
+        {
+            return false;
+        }
+        const char *entry( data + BATCH_HEADER );
+        for ( int i = 0; i < count; ++i, entry += BATCH_ENTRY )
+        {
+            if ( ( uchar )entry[ 0 ] == group )
+            {
+                memcpy( command, entry + 1, sizeof *command );
+                *epoch = qFromLittleEndian< quint32 >( ( const uchar *)entry + 1 + sizeof *command );
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // a plain command, maybe with a step start
+    if ( size < ( qint64 )sizeof *command )
+    {
+        return false;
+    }
+    memcpy( command, data, sizeof *command );
+    if ( size >= ( qint64 )( sizeof *command + sizeof( CommandEpoch )))
+    {
+        CommandEpoch trailer;
+        memcpy( &trailer, data + sizeof *command, sizeof trailer );
+        if ( qFromLittleEndian( trailer.magic ) == CommandEpoch::MAGIC )
+        {
+            *epoch = qFromLittleEndian( trailer.epoch );
+        }
+    }
+    return true;
+}
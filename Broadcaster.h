@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QBasicTimer>
+#include <QHostAddress>
+#include <QList>
+#include <QObject>
+#include <QUdpSocket>
+#include "Player.h"
+
+class DeskNode;
+
+
+// Several groups' commands in one datagram, little-endian:
+//   uint32 magic, uint8 count,
+//   count x ( uint8 group, RadioPixel::Command, uint32 epoch, 0 for none )
+// A lone group goes out as a plain command with a CommandEpoch trailer
+// instead, so older desk nodes still follow it.
+const uint32_t COMMAND_BATCH_MAGIC = 0x42435052; // "RPCB"
+const int BATCH_HEADER = 5; // magic, count
+const int BATCH_ENTRY = 1 + sizeof( RadioPixel::Command ) + 4;
+// a 1500 byte Ethernet frame less the IP and UDP headers, so a batch
+// never fragments or outgrows a receiver's buffer
+const int BATCH_DATAGRAM = 1472;
+const int BATCH_MAX = ( BATCH_DATAGRAM - BATCH_HEADER ) / BATCH_ENTRY; // entries
+
+
+// Sends the commands of the nodes it controls over UDP broadcast. A group
+// goes out as soon as its command changes. While nothing changes the
+// keepalive backs off from KEEPALIVE_MIN_MS to KEEPALIVE_MAX_MS, so late
+// joiners still catch up without a packet a second from every controller.
+// Groups that are due together share a datagram.
+class Broadcaster : public QObject
+{
+    Q_OBJECT
+
+public:
+    Broadcaster( quint16 port, const QHostAddress &address = QHostAddress::Broadcast,
+                 QObject *parent = nullptr );
+
+    //! control a group from a node's player
+    void addGroup( uint8_t group, DeskNode *node );
+
+    //! find a group's command in a datagram, plain or batched
+    static bool parse( const char *data, qint64 size, uint8_t group,
+                       RadioPixel::Command *command, ms_t *epoch );
+
+    //! datagrams sent so far
+    quint64 sent( ) const { return m_sent; }
+
+protected:
+    void timerEvent( QTimerEvent *event ) override;
+
+private slots:
+    void onChanged( );
+
+private:
+    struct Group
+    {
+        uint8_t group;
+        DeskNode *node;
+        RadioPixel::Command last; // as last sent
+        bool valid; // last has been sent
+        ms_t due; // next send, local ms
+        ms_t keepalive; // current keepalive interval
+    };
+
+    // send every group that's due, then sleep until the next one is
+    void send( );
+
+    QUdpSocket m_socket;
+    QHostAddress m_address;
+    quint16 m_port;
+
+    QList< Group > m_groups;
+    QBasicTimer m_timer;
+    quint64 m_sent;
+};
@@ -0,0 +1,139 @@
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <QDebug>
+#include "Checkpoint.h"
+#include "Latency.h"
+
+
+Checkpoint::Checkpoint( )
+    : m_data( nullptr ), m_header( nullptr ), m_size( 0 ), m_slotSize( 0 ),
+      m_valid( false ), m_writing( 0 ), m_pending( false ), m_stop( false ),
+      m_busy( false )
+{
+}
+
+Checkpoint::~Checkpoint( )
+{
+    if ( m_thread.joinable( ))
+    {
+        {
+            std::lock_guard< std::mutex > lock( m_mutex );
+            m_stop = true;
+        }
+        m_wake.notify_one( );
+        m_thread.join( );
+    }
+}
+
+bool Checkpoint::open( const QString &path, uint32_t zones )
+{
+    // slots stay 8 byte aligned for their stamps
+    qint64 slotSize(( sizeof( Slot ) + zones * sizeof( Zone ) + 7 ) & ~7 );
+    qint64 size( sizeof( Header ) + 2 * slotSize );
+
+    m_file.setFileName( path );
+    if ( !m_file.open( QIODevice::ReadWrite ) ||
+         ( m_file.size( ) != size && !m_file.resize( size )))
+    {
+        qWarning( ) << "can't open checkpoint" << path << m_file.errorString( );
+        return false;
+    }
+    uchar *data( m_file.map( 0, size ));
+    if ( !data )
+    {
+        qWarning( ) << "can't map checkpoint" << path << m_file.errorString( );
+        return false;
+    }
+
+    m_data = data;
+    m_header = ( Header *)data;
+    m_size = size;
+    m_slotSize = slotSize;
+
+    // the header only ever names a slot that reached the disk whole
+    m_valid = m_header->magic == MAGIC && m_header->version == VERSION &&
+        m_header->zones == zones && m_header->seq && m_header->slot < 2 &&
+        slot( m_header->slot )->seq == m_header->seq;
+    if ( !m_valid )
+    {
+        memset( data, 0, size );
+        m_header->magic = MAGIC;
+        m_header->version = VERSION;
+        m_header->zones = zones;
+    }
+
+    m_thread = std::thread( &Checkpoint::run, this );
+    return true;
+}
+
+ms_t Checkpoint::age( ) const
+{
+    stamp_t now( StampNow( ));
+    stamp_t saved( m_header ? slot( m_header->slot )->saved : 0 );
+    return ( saved && now > saved ) ? ( now - saved ) / 1000000 : 0;
+}
+
+bool Checkpoint::begin( )
+{
+    if ( m_busy.load( std::memory_order_acquire ))
+    {
+        return false;
+    }
+    m_busy.store( true, std::memory_order_relaxed );
+
+    // never the slot the header names, that one has to survive this save
+    m_writing = m_header->slot ^ 1;
+    return true;
+}
+
+void Checkpoint::commit( )
+{
+    Slot *writing( slot( m_writing ));
+    writing->seq = m_header->seq + 1;
+    writing->saved = StampNow( );
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        m_pending = true;
+    }
+    m_wake.notify_one( );
+}
+
+void Checkpoint::run( )
+{
+    std::unique_lock< std::mutex > lock( m_mutex );
+    for ( ;; )
+    {
+        m_wake.wait( lock, [ this ]( ) { return m_pending || m_stop; } );
+        if ( m_pending )
+        {
+            // MS_SYNC waits on the disk, well away from the render thread
+            m_pending = false;
+            lock.unlock( );
+            sync( );
+            m_busy.store( false, std::memory_order_release );
+            lock.lock( );
+        }
+        else
+        {
+            return;
+        }
+    }
+}
+
+void Checkpoint::sync( )
+{
+    // the slot first, then the header that points at it: until the second
+    // sync lands, the header on disk still names the other, untouched slot
+    if ( msync( m_data, m_size, MS_SYNC ) < 0 )
+    {
+        qWarning( ) << "can't sync checkpoint" << m_file.fileName( ) << strerror( errno );
+        return;
+    }
+    m_header->slot = m_writing;
+    m_header->seq = slot( m_writing )->seq;
+    if ( msync( m_data, m_size, MS_SYNC ) < 0 )
+    {
+        qWarning( ) << "can't sync checkpoint" << m_file.fileName( ) << strerror( errno );
+    }
+}
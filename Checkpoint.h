@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <QFile>
+#include <QString>
+
+#include "Player.h"
+
+
+// Player state saved every few seconds to a small mapped file, so a node
+// that restarts comes back showing what it was showing. Saves alternate
+// between two slots: a worker thread syncs the new slot to disk, then
+// points the header at it and syncs that, so a power cut at any point
+// leaves the last whole save to come back to. The frame itself isn't
+// kept: every pattern's Init redraws the whole strip.
+class Checkpoint
+{
+public:
+    static const uint32_t MAGIC = 0x4b435052; // "RPCK"
+    static const uint32_t VERSION = 3;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t zones;
+        uint32_t slot; // which slot holds the last whole save
+        uint32_t seq; // saves made, 0 before the first
+        uint32_t reserved;
+    };
+
+    struct Slot
+    {
+        uint32_t seq; // the save it holds
+        uint32_t reserved;
+        uint64_t saved; // ns since the epoch
+    };
+
+    struct Zone
+    {
+        uint8_t playing; // ZONE_IDLE or ZONE_COMMAND
+        uint8_t reserved[ 3 ];
+        uint32_t sequence; // qHash of the idle sequence's name, 0 for commands
+        int32_t step;
+        uint32_t stepAge; // ms into the step when saved
+        uint32_t position; // pattern ms into the step, see Player::GetPosition
+        RadioPixel::Command command; // last received
+    };
+
+    enum
+    {
+        ZONE_IDLE,
+        ZONE_COMMAND
+    };
+
+    Checkpoint( );
+
+    ~Checkpoint( );
+
+    //! map path sized for zones, keeping a checkpoint of the same shape
+    // already there
+    bool open( const QString &path, uint32_t zones );
+
+    bool isOpen( ) const { return m_header != nullptr; }
+
+    //! true if a whole checkpoint was found when opened
+    bool isValid( ) const { return m_valid; }
+
+    //! ms since the last whole save, by the wall clock
+    ms_t age( ) const;
+
+    //! the last whole save
+    const Zone *saved( uint32_t index ) const { return zones( m_header->slot ) + index; }
+
+    // the next save, write between begin( ) and commit( )
+
+    //! false while the last save is still syncing, skip this one
+    bool begin( );
+
+    Zone *zone( uint32_t index ) { return zones( m_writing ) + index; }
+
+    //! hand the save to the worker to sync
+    void commit( );
+
+private:
+    Slot *slot( uint32_t index ) const { return ( Slot *)( m_data + sizeof( Header ) + index * m_slotSize ); }
+
+    Zone *zones( uint32_t index ) const { return ( Zone *)( slot( index ) + 1 ); }
+
+    // the worker, syncs each committed save
+    void run( );
+
+    // both syncs, on the worker
+    void sync( );
+
+    QFile m_file;
+    uchar *m_data;
+    Header *m_header;
+    qint64 m_size;
+    qint64 m_slotSize;
+    bool m_valid;
+
+    uint32_t m_writing; // slot begin( ) handed out
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_pending; // a commit( ) waiting for the worker
+    bool m_stop;
+    std::atomic< bool > m_busy; // from commit( ) until both syncs are done
+};
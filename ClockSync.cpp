@@ -0,0 +1,126 @@
+#include <QDebug>
+#include <QtEndian>
+#include "radiopixel_protocol.h"
+#include "ClockSync.h"
+
+
+const uint32_t PING_MAGIC = 0x4b434c43; // "CLCK"
+const int FAST_PINGS = 8; // pings at FAST_PING_MS before slowing down
+const int FAST_PING_MS = 250;
+const int PING_MS = 5000;
+
+// ping / pong on the wire, little-endian
+enum
+{
+    CLOCK_MAGIC = 0, // uint32
+    CLOCK_SENT = 4, // t0, follower's clock when the ping left
+    CLOCK_RECEIVED = 8, // t1, peer's shared clock when the ping arrived
+    CLOCK_REPLIED = 12, // t2, peer's shared clock when the pong left
+    CLOCK_SIZE = 16
+};
+
+
+ClockSync::ClockSync( QObject *parent )
+    : QObject( parent ),
+      m_peerPort( 0 ),
+      m_skew( 0 ), m_offset( 0 ), m_delay( 0 ), m_synced( false ),
+      m_sampleCount( 0 ), m_nextSample( 0 ), m_pings( 0 )
+{
+    connect( &m_socket, SIGNAL( readyRead()),
+             this, SLOT( onReadyRead()));
+    connect( &m_pingTimer, SIGNAL( timeout()),
+             this, SLOT( onPing()));
+}
+
+void ClockSync::setSkew( qint32 skew )
+{
+    qint32 delta( skew - m_skew );
+    m_skew = skew;
+    if ( delta )
+    {
+        emit stepped( delta );
+    }
+}
+
+bool ClockSync::serve( quint16 port )
+{
+    return m_socket.bind( port, QAbstractSocket::ShareAddress );
+}
+
+void ClockSync::follow( const QHostAddress &peer, quint16 port )
+{
+    m_peer = peer;
+    m_peerPort = port;
+    m_pings = 0;
+    m_pingTimer.start( FAST_PING_MS );
+    onPing( );
+}
+
+void ClockSync::onPing( )
+{
+    uchar ping[ CLOCK_SIZE ] = { };
+    qToLittleEndian< quint32 >( PING_MAGIC, ping + CLOCK_MAGIC );
+    qToLittleEndian< quint32 >( local( ), ping + CLOCK_SENT );
+    m_socket.writeDatagram( ( const char *)ping, sizeof ping, m_peer, m_peerPort );
+
+    if ( ++m_pings == FAST_PINGS )
+    {
+        m_pingTimer.start( PING_MS );
+    }
+}
+
+void ClockSync::onReadyRead( )
+{
+    while ( m_socket.hasPendingDatagrams( ))
+    {
+        uchar packet[ CLOCK_SIZE ];
+        QHostAddress from;
+        quint16 fromPort;
+        qint64 size = m_socket.readDatagram( ( char *)packet, sizeof packet, &from, &fromPort );
+        ms_t arrived( local( ));
+        if ( size != CLOCK_SIZE || qFromLittleEndian< quint32 >( packet + CLOCK_MAGIC ) != PING_MAGIC )
+        {
+            continue;
+        }
+
+        ms_t t0( qFromLittleEndian< quint32 >( packet + CLOCK_SENT ));
+        ms_t t1( qFromLittleEndian< quint32 >( packet + CLOCK_RECEIVED ));
+        ms_t t2( qFromLittleEndian< quint32 >( packet + CLOCK_REPLIED ));
+
+        if ( !t1 && !t2 )
+        {
+            // a ping, answer on our shared clock
+            qToLittleEndian< quint32 >( arrived + m_offset, packet + CLOCK_RECEIVED );
+            qToLittleEndian< quint32 >( now( ), packet + CLOCK_REPLIED );
+            m_socket.writeDatagram( ( const char *)packet, sizeof packet, from, fromPort );
+            continue;
+        }
+
+        // a pong to one of our pings
+        ms_t t3( arrived );
+        Sample sample;
+        sample.delay = ( t3 - t0 ) - ( t2 - t1 );
+        sample.offset = ( ( qint32 )( t1 - t0 ) + ( qint32 )( t2 - t3 )) / 2;
+        m_samples[ m_nextSample ] = sample;
+        m_nextSample = ( m_nextSample + 1 ) % SAMPLES;
+        m_sampleCount = qMin( m_sampleCount + 1, ( int )SAMPLES );
+
+        // the shortest round trip had the least room for asymmetry
+        const Sample *best = &m_samples[ 0 ];
+        for ( int i = 1; i < m_sampleCount; ++i )
+        {
+            if ( m_samples[ i ].delay < best->delay )
+            {
+                best = &m_samples[ i ];
+            }
+        }
+        qint32 delta( best->offset - m_offset );
+        m_offset = best->offset;
+        m_delay = best->delay;
+        m_synced = true;
+        if ( delta )
+        {
+            emit stepped( delta );
+        }
+    }
+}
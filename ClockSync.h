@@ -0,0 +1,91 @@
+#pragma once
+
+#include <QHostAddress>
+#include <QObject>
+#include <QTimer>
+#include <QUdpSocket>
+#include "Player.h"
+
+
+// Optional trailer after a RadioPixel::Command in a datagram: when the
+// command's step started on the shared clock. Nodes that know the shared
+// clock run the pattern from there, so they animate in phase no matter
+// when the packet reached them. Older nodes read the command and ignore
+// the extra bytes.
+#pragma pack( push, 1 )
+struct CommandEpoch
+{
+    static const uint32_t MAGIC = 0x48435045; // "EPCH"
+
+    uint32_t magic; // little-endian, like epoch
+    uint32_t epoch; // shared clock ms
+};
+#pragma pack( pop )
+
+
+// Keeps a shared clock by pinging a peer NTP style: offset from the four
+// timestamps of an exchange, trusting the exchange with the shortest round
+// trip out of the last few. The peer answers with its own shared clock, so
+// a node can both follow one peer and serve others.
+class ClockSync : public QObject
+{
+    Q_OBJECT
+
+public:
+    ClockSync( QObject *parent = nullptr );
+
+    //! answer pings on a port
+    bool serve( quint16 port );
+
+    //! ping a peer until told otherwise
+    void follow( const QHostAddress &peer, quint16 port );
+
+    //! pretend the local clock is off by skew ms, for testing
+    void setSkew( qint32 skew );
+
+    //! shared clock ms, the local clock until synced
+    ms_t now( ) const { return local( ) + m_offset; }
+
+    bool isSynced( ) const { return m_synced; }
+
+    //! shared minus local, ms
+    qint32 offset( ) const { return m_offset; }
+
+    //! round trip of the exchange the offset came from, ms
+    ms_t delay( ) const { return m_delay; }
+
+signals:
+    //! now( ) jumped by delta ms, anything holding its times should move them
+    void stepped( qint32 delta );
+
+private slots:
+    void onPing( );
+    void onReadyRead( );
+
+private:
+    // millis( ) is monotonic, so this never steps on its own
+    ms_t local( ) const { return millis( ) + m_skew; }
+
+    enum { SAMPLES = 8 }; // exchanges the best is picked from
+
+    struct Sample
+    {
+        ms_t delay;
+        qint32 offset;
+    };
+
+    QUdpSocket m_socket;
+    QTimer m_pingTimer;
+    QHostAddress m_peer;
+    quint16 m_peerPort;
+
+    qint32 m_skew;
+    qint32 m_offset;
+    ms_t m_delay;
+    bool m_synced;
+
+    Sample m_samples[ SAMPLES ];
+    int m_sampleCount;
+    int m_nextSample;
+    int m_pings; // sent since following, pings go faster at first
+};
@@ -0,0 +1,102 @@
+#include <string.h>
+#include <QDebug>
+#include <QtEndian>
+#include "radiopixel_protocol.h"
+#include "CommandLog.h"
+
+
+const uint16_t COMMAND_LOG_VERSION = 1;
+const int LOG_HEADER = 16; // magic, version, command size, first stamp
+const int LOG_ENTRY = 4 + 1 + 1 + sizeof( RadioPixel::Command );
+
+
+CommandLog::CommandLog( )
+    : m_last( 0 ), m_count( 0 )
+{
+}
+
+CommandLog::~CommandLog( )
+{
+    if ( m_file.isOpen( ))
+    {
+        m_file.close( );
+    }
+}
+
+bool CommandLog::open( const QString &path )
+{
+    m_file.setFileName( path );
+    if ( !m_file.open( QIODevice::WriteOnly | QIODevice::Truncate ))
+    {
+        qWarning( ) << "can't write command log" << path << m_file.errorString( );
+        return false;
+    }
+    m_last = StampNow( );
+    m_count = 0;
+
+    uchar header[ LOG_HEADER ];
+    qToLittleEndian< quint32 >( COMMAND_LOG_MAGIC, header );
+    qToLittleEndian< quint16 >( COMMAND_LOG_VERSION, header + 4 );
+    qToLittleEndian< quint16 >( sizeof( RadioPixel::Command ), header + 6 );
+    qToLittleEndian< quint64 >( m_last, header + 8 );
+    m_file.write( ( const char *)header, sizeof header );
+    return true;
+}
+
+void CommandLog::add( stamp_t stamp, uint8_t source, uint8_t group, const RadioPixel::Command &command )
+{
+    if ( !m_file.isOpen( ))
+    {
+        return;
+    }
+
+    // the wall clock can step back under us, and a gap over an hour
+    // or so only loses its length
+    quint64 us( ( stamp > m_last ) ? ( stamp - m_last ) / 1000 : 0 );
+    us = qMin( us, ( quint64 )0xffffffff );
+    m_last += us * 1000;
+
+    uchar entry[ LOG_ENTRY ];
+    qToLittleEndian< quint32 >( us, entry );
+    entry[ 4 ] = source;
+    entry[ 5 ] = group;
+    memcpy( entry + 6, &command, sizeof command );
+    m_file.write( ( const char *)entry, sizeof entry );
+    ++m_count;
+}
+
+bool CommandLog::load( const QString &path, std::vector< Entry > *entries )
+{
+    QFile file( path );
+    if ( !file.open( QIODevice::ReadOnly ))
+    {
+        qWarning( ) << "can't read command log" << path << file.errorString( );
+        return false;
+    }
+    QByteArray data( file.readAll( ));
+    const uchar *bytes( ( const uchar *)data.constData( ));
+    if ( data.size( ) < LOG_HEADER ||
+         qFromLittleEndian< quint32 >( bytes ) != COMMAND_LOG_MAGIC ||
+         qFromLittleEndian< quint16 >( bytes + 4 ) != COMMAND_LOG_VERSION ||
+         qFromLittleEndian< quint16 >( bytes + 6 ) != sizeof( RadioPixel::Command ))
+    {
+        qWarning( ) << path << "isn't a command log from this version";
+        return false;
+    }
+
+    // a log cut short by a crash keeps its whole entries
+    stamp_t stamp( qFromLittleEndian< quint64 >( bytes + 8 ));
+    entries->clear( );
+    entries->reserve( ( data.size( ) - LOG_HEADER ) / LOG_ENTRY );
+    for ( int at = LOG_HEADER; at + LOG_ENTRY <= data.size( ); at += LOG_ENTRY )
+    {
+        Entry entry;
+        stamp += ( stamp_t )qFromLittleEndian< quint32 >( bytes + at ) * 1000;
+        entry.stamp = stamp;
+        entry.source = bytes[ at + 4 ];
+        entry.group = bytes[ at + 5 ];
+        memcpy( &entry.command, bytes + at + 6, sizeof entry.command );
+        entries->push_back( entry );
+    }
+    return true;
+}
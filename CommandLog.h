@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <QFile>
+#include "Latency.h"
+#include "Player.h"
+
+
+// Received commands with when they came in, little-endian:
+//   uint32 magic, uint16 version, uint16 command size, uint64 first stamp
+//   then per command: uint32 µs since the one before, uint8 source,
+//   uint8 group, RadioPixel::Command
+// 11 bytes over the command itself, so an hour of a busy LAN stays small.
+const uint32_t COMMAND_LOG_MAGIC = 0x4c435052; // "RPCL"
+
+
+class CommandLog
+{
+public:
+    enum Source
+    {
+        SOURCE_LAN = 0,
+        SOURCE_CLOUD = 1
+    };
+
+    struct Entry
+    {
+        stamp_t stamp; // arrival, see StampNow( )
+        uint8_t source;
+        uint8_t group; // the zone's that took it, 0 from the cloud
+        RadioPixel::Command command;
+    };
+
+    CommandLog( );
+    ~CommandLog( );
+
+    //! start a new log at path
+    bool open( const QString &path );
+
+    bool isOpen( ) const { return m_file.isOpen( ); }
+
+    void add( stamp_t stamp, uint8_t source, uint8_t group, const RadioPixel::Command &command );
+
+    //! commands logged so far
+    quint64 count( ) const { return m_count; }
+
+    //! every command in the log at path
+    static bool load( const QString &path, std::vector< Entry > *entries );
+
+private:
+    QFile m_file;
+    stamp_t m_last;
+    quint64 m_count;
+};
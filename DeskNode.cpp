@@ -0,0 +1,477 @@
+#include <string.h>
+#include <algorithm>
+#include <QDebug>
+#include <QHash>
+#include <QTimer>
+#include <QTimerEvent>
+#include "radiopixel_protocol.h"
+#include "Broadcaster.h"
+#include "DeskNode.h"
+
+
+DeskNode::Config::Config( )
+    : length( 92 ), port( HN_PORT ), group( 0 ),
+      cloudHost( "hats.blynch.net" ), cloudPort( 8100 ),
+      indexed( false ), statsSeconds( 0 ),
+      clockServe( 0 ), clockPeerPort( 0 ), clockSkew( 0 ),
+      transition( TRANSITION_NONE ), transitionMs( 0 ),
+      checkpointSeconds( 5 ),
+      audioReact( AUDIO_REACT_NONE )
+{
+}
+
+DeskNode::DeskNode( const Config &config, QObject *parent )
+    : QObject( parent ),
+      m_config( config ),
+      m_strip( config.length, 0, 0 ),
+      m_layout( NULL ),
+      m_zoneShown( false ), m_zoneStamp( 0 ),
+      m_rxStamps( false ),
+      m_ingested( 0 ), m_applied( 0 ), m_frames( 0 ), m_missed( 0 ), m_busy( 0 ),
+      m_statsStamp( StampNow( )), m_due( 0 )
+{
+    if ( !m_config.layout.isEmpty( ))
+    {
+        m_layout = Layout::create( m_config.layout );
+        if ( m_layout && m_layout->count( ) != m_strip.numPixels( ))
+        {
+            qWarning( ) << "layout has" << m_layout->count( ) << "pixels, strip" << m_strip.numPixels( );
+        }
+        m_strip.setLayout( m_layout );
+    }
+
+    // show sequences from a file, followed as it changes
+    if ( !m_config.library.isEmpty( ))
+    {
+        m_library.open( m_config.library );
+        connect( &m_library, SIGNAL( reloaded()),
+                 this, SLOT( onLibraryReloaded()));
+    }
+
+    // every frame the strip sends, whichever zone drew it
+    connect( &m_strip, SIGNAL( show()),
+             this, SLOT( onShow()));
+
+    // zones, or one for the whole strip on the configured group
+    QList< Zone::Config > zones( m_config.zones );
+    if ( zones.isEmpty( ))
+    {
+        Zone::Config whole;
+        whole.group = m_config.group;
+        zones.append( whole );
+    }
+    foreach ( const Zone::Config &zoneConfig, zones )
+    {
+        Zone *zone = new Zone( &m_strip, zoneConfig );
+        zone->player( )->SetIndexed( m_config.indexed );
+        zone->player( )->SetTransition( m_config.transition, m_config.transitionMs );
+        zone->setIdle( m_library.sequence( zone->idleName( )));
+        if ( zone->isView( ))
+        {
+            // views dim themselves on the way out, see StripBase::getColors
+            m_strip.setBrightness( 255 );
+            connect( zone->strip( ), SIGNAL( show()),
+                     this, SLOT( onZoneShow()));
+        }
+        m_zones.push_back( zone );
+    }
+
+    // sound, analysed on its own thread for players and patterns to follow
+    if ( !m_config.audio.isEmpty( ))
+    {
+        AudioSource *source( AudioSource::create( m_config.audio ));
+        if ( source )
+        {
+            m_audio.start( source );
+            m_strip.setAudio( &m_audio );
+            for ( size_t i = 0; i < m_zones.size( ); ++i )
+            {
+                m_zones[ i ]->strip( )->setAudio( &m_audio );
+                m_zones[ i ]->player( )->SetAudioReact( m_config.audioReact );
+            }
+        }
+        else
+        {
+            qWarning( ) << "can't open audio" << m_config.audio;
+        }
+    }
+
+    // shared clock
+    connect( &m_clock, SIGNAL( stepped( qint32 )),
+             this, SLOT( onClockStepped( qint32 )));
+    m_clock.setSkew( m_config.clockSkew );
+    if ( m_config.clockServe )
+    {
+        m_clock.serve( m_config.clockServe );
+    }
+    if ( !m_config.clockPeer.isEmpty( ))
+    {
+        m_clock.follow( QHostAddress( m_config.clockPeer ), m_config.clockPeerPort );
+    }
+
+    // every command from here on, for replaying against a node later
+    if ( !m_config.record.isEmpty( ))
+    {
+        m_record.open( m_config.record );
+    }
+
+    // connect the LAN socket
+    if ( m_config.port )
+    {
+        m_lanSocket.bind( m_config.port, QAbstractSocket::ShareAddress );
+        connect( &m_lanSocket, SIGNAL( readyRead()),
+                 this, SLOT( onLanRecv()));
+        m_rxStamps = EnableRxStamps( m_lanSocket.socketDescriptor( ));
+    }
+
+    // connect the cloud socket
+    if ( !m_config.cloudHost.isEmpty( ) )
+    {
+        connect( &m_cloudSocket, SIGNAL( readyRead()),
+                 this, SLOT( onCloudRecv()));
+        QTimer *connectTimer = new QTimer( this );
+        connect( connectTimer, SIGNAL(timeout()),
+                 this, SLOT(onCloudReconnect()));
+        connectTimer->start( 30 * 1000 );
+        onCloudReconnect();
+    }
+
+    if ( m_config.statsSeconds )
+    {
+        QTimer *statsTimer = new QTimer( this );
+        connect( statsTimer, SIGNAL(timeout()),
+                 this, SLOT(onStats()));
+        statsTimer->start( m_config.statsSeconds * 1000 );
+    }
+
+    // pick up where the last run left off, before the first frame
+    if ( !m_config.checkpoint.isEmpty( ) &&
+         m_checkpoint.open( m_config.checkpoint, m_zones.size( )))
+    {
+        if ( m_checkpoint.isValid( ))
+        {
+            restore( );
+        }
+        QTimer *checkpointTimer = new QTimer( this );
+        connect( checkpointTimer, SIGNAL(timeout()),
+                 this, SLOT(onCheckpoint()));
+        checkpointTimer->start( std::max( m_config.checkpointSeconds, 1 ) * 1000 );
+    }
+
+    // zones start on their idle pattern, or as restored
+    wake( );
+}
+
+DeskNode::~DeskNode()
+{
+    if ( m_checkpoint.isOpen( ))
+    {
+        onCheckpoint( );
+    }
+    for ( size_t i = 0; i < m_zones.size( ); ++i )
+    {
+        delete m_zones[ i ];
+    }
+    delete m_layout;
+}
+
+void DeskNode::onLanRecv()
+{
+    while ( m_lanSocket.hasPendingDatagrams())
+    {
+        // stamp from when the kernel had it, else from now
+        stamp_t received( 0 );
+        if ( !m_rxStamps || !PeekRxStamp( m_lanSocket.socketDescriptor( ), &received ))
+        {
+            received = StampNow( );
+        }
+        // each zone's group's command, maybe with when its step started
+        char datagram[ BATCH_DATAGRAM ];
+        qint64 size( m_lanSocket.readDatagram( datagram, sizeof datagram ));
+        bool played( false );
+        for ( size_t i = 0; i < m_zones.size( ); ++i )
+        {
+            RadioPixel::Command command;
+            ms_t epoch;
+            if ( Broadcaster::parse( datagram, size, m_zones[ i ]->group( ), &command, &epoch ))
+            {
+                // once per group, zones can share one
+                bool logged( false );
+                for ( size_t j = 0; j < i && !logged; ++j )
+                {
+                    logged = m_zones[ j ]->group( ) == m_zones[ i ]->group( );
+                }
+                if ( !logged )
+                {
+                    record( received, CommandLog::SOURCE_LAN, m_zones[ i ]->group( ), command );
+                }
+                play( m_zones[ i ], command, epoch, received );
+                played = true;
+            }
+        }
+        if ( played )
+        {
+            wake( );
+        }
+    }
+}
+
+void DeskNode::onCloudReconnect()
+{
+    if ( m_cloudSocket.state() == QTcpSocket::UnconnectedState )
+    {
+        // drop the tail of a command the last connection cut off, or the
+        // new stream would be read out of step
+        m_cloudSocket.readAll( );
+        m_cloudSocket.connectToHost( m_config.cloudHost, m_config.cloudPort );
+    }
+}
+
+void DeskNode::onCloudRecv()
+{
+    // a stream has no per-packet kernel stamps
+    stamp_t received( StampNow( ));
+    // TCP splits the stream where it likes; a partial command stays in
+    // the socket's buffer until the rest of it arrives
+    while ( m_cloudSocket.bytesAvailable( ) >= ( qint64 )sizeof( RadioPixel::Command ))
+    {
+        // the cloud has no groups, every zone follows it
+        RadioPixel::Command command;
+        m_cloudSocket.read( ( char *)&command, sizeof command );
+        record( received, CommandLog::SOURCE_CLOUD, 0, command );
+        for ( size_t i = 0; i < m_zones.size( ); ++i )
+        {
+            m_zones[ i ]->play( command, now( ), received );
+            ++m_ingested;
+        }
+    }
+    wake( );
+}
+
+void DeskNode::inject( const RadioPixel::Command &command, ms_t epoch, stamp_t received )
+{
+    for ( size_t i = 0; i < m_zones.size( ); ++i )
+    {
+        play( m_zones[ i ], command, epoch, received );
+    }
+    wake( );
+}
+
+void DeskNode::play( Zone *zone, const RadioPixel::Command &command, ms_t epoch, stamp_t received )
+{
+    ms_t current( now( ));
+    zone->play( command, current, received );
+    ++m_ingested;
+
+    // epochs only mean something on a clock we share, the reference or a
+    // follower that has synced. A step can't start in the future either.
+    if ( epoch && sharesClock( ) && ( qint32 )( current - epoch ) >= 0 )
+    {
+        zone->player( )->SetStepTime( epoch );
+    }
+}
+
+void DeskNode::record( stamp_t received, uint8_t source, uint8_t group, const RadioPixel::Command &command )
+{
+    if ( m_record.isOpen( ))
+    {
+        m_record.add( received, source, group, command );
+    }
+}
+
+void DeskNode::onStats()
+{
+    // rates since the last stats, how much of the time went on frames, and
+    // whether they still came when due
+    stamp_t stamp( StampNow( ));
+    double seconds( qMax( ( stamp - m_statsStamp ) / 1e9, 1e-3 ));
+    qInfo( ).noquote( ) << QString( "load ingest %1/s applied %2/s frames %3/s busy %4% missed %5" )
+        .arg( m_ingested / seconds, 0, 'f', 1 )
+        .arg( m_applied / seconds, 0, 'f', 1 )
+        .arg( m_frames / seconds, 0, 'f', 1 )
+        .arg( m_busy / 1e7 / seconds, 0, 'f', 1 )
+        .arg( m_missed );
+    qInfo( ).noquote( ) << "frame cost" << m_frameCost.summary( ) << "late" << m_frameLate.summary( );
+    m_ingested = m_applied = m_frames = m_missed = 0;
+    m_busy = 0;
+    m_statsStamp = stamp;
+
+    qInfo( ).noquote( ) << "latency" << m_latency.summary( );
+    if ( m_audio.isRunning( ))
+    {
+        qInfo( ).noquote( ) << "audio" << m_audioLatency.summary( );
+    }
+}
+
+void DeskNode::onShow()
+{
+    ++m_frames;
+}
+
+void DeskNode::onZoneShow()
+{
+    // a view drew, the strip shows once every zone has had its turn
+    m_zoneShown = true;
+    uint64_t stamp( static_cast< StripBase *>( sender( ))->getStamp( ));
+    if ( stamp )
+    {
+        m_zoneStamp = stamp;
+    }
+}
+
+void DeskNode::onLibraryReloaded()
+{
+    // steps changed in place, the next update picks up the new look
+    for ( size_t i = 0; i < m_zones.size( ); ++i )
+    {
+        m_zones[ i ]->setIdle( m_library.sequence( m_zones[ i ]->idleName( )));
+        m_zones[ i ]->player( )->SequenceChanged( );
+    }
+    wake( );
+}
+
+void DeskNode::onCheckpoint()
+{
+    // a disk too slow for the last save just means a later one
+    if ( !m_checkpoint.begin( ))
+    {
+        return;
+    }
+    ms_t current( now( ));
+    for ( size_t i = 0; i < m_zones.size( ); ++i )
+    {
+        Checkpoint::Zone *saved( m_checkpoint.zone( i ));
+        Zone *zone( m_zones[ i ] );
+        Player *player( zone->player( ));
+        bool command( zone->isPlayingCommand( ));
+        saved->playing = command ? Checkpoint::ZONE_COMMAND : Checkpoint::ZONE_IDLE;
+        saved->sequence = command ? 0 : qHash( zone->idleName( ));
+        saved->command = zone->command( );
+        saved->step = player->GetStep( );
+        saved->stepAge = current - player->GetStepTime( );
+        saved->position = player->GetPosition( current );
+    }
+    m_checkpoint.commit( );
+}
+
+void DeskNode::onClockStepped( qint32 delta )
+{
+    // the same instants now read delta later, keep every step where it was
+    for ( size_t i = 0; i < m_zones.size( ); ++i )
+    {
+        m_zones[ i ]->player( )->Rebase( delta );
+    }
+    wake( );
+}
+
+void DeskNode::restore( )
+{
+    // steps carry on as if we'd never stopped
+    ms_t current( now( ));
+    ms_t down( m_checkpoint.age( ));
+    for ( size_t i = 0; i < m_zones.size( ); ++i )
+    {
+        const Checkpoint::Zone *saved( m_checkpoint.saved( i ));
+        Zone *zone( m_zones[ i ] );
+        if ( saved->playing == Checkpoint::ZONE_COMMAND )
+        {
+            zone->play( saved->command, current, 0 );
+        }
+        else if ( saved->sequence != qHash( zone->idleName( )))
+        {
+            // configured onto another sequence since, its steps aren't ours
+            continue;
+        }
+        Player *player( zone->player( ));
+        if ( saved->step >= 0 && saved->step < player->GetSequence( )->GetStepCount( ))
+        {
+            // the pattern picks up where it was, audio warp and all, and
+            // runs on through the time we were down
+            player->SetStep( saved->step, current - saved->stepAge - down );
+            ms_t position( saved->position + down * player->GetSequence( )->GetSpeed( saved->step ) / 100 );
+            player->SetPosition( position, current );
+        }
+    }
+    qInfo( ) << "restored checkpoint from" << down << "ms ago";
+}
+
+void DeskNode::timerEvent(QTimerEvent *event)
+{
+    if ( event->timerId( ) == m_frameTimer.timerId( ) )
+    {
+        // an animation frame the timer brought over a tick late missed
+        // its deadline, long sleeps have nothing waiting on them
+        if ( m_due )
+        {
+            stamp_t stamp( StampNow( ));
+            m_frameLate.add( m_due, stamp );
+            if ( stamp > m_due + TICK_MS * 1000000ull )
+            {
+                ++m_missed;
+            }
+        }
+        wake( );
+    }
+}
+
+void DeskNode::wake( )
+{
+    stamp_t woke( StampNow( ));
+    ms_t now( this->now( ));
+
+    // every zone on the same tick, into its span of the one buffer
+    bool moved( false );
+    uint64_t heard( m_audio.isRunning( ) ? m_audio.snapshot( ).stamp : 0 );
+    m_zoneShown = false;
+    m_zoneStamp = 0;
+    for ( size_t i = 0; i < m_zones.size( ); ++i )
+    {
+        Player *player( m_zones[ i ]->player( ));
+        if ( player->UpdatePattern( now, m_zones[ i ]->strip( )))
+        {
+            moved = true;
+        }
+        player->UpdateStrip( now, m_zones[ i ]->strip( ));
+    }
+    if ( m_zoneShown )
+    {
+        m_strip.setStamp( m_zoneStamp );
+        m_strip.show( );
+        m_strip.setStamp( 0 );
+    }
+    if ( moved )
+    {
+        emit changed( );
+    }
+    if ( heard )
+    {
+        m_audioLatency.add( heard, StampNow( ));
+    }
+
+    // show( ) has returned, so every sink has the frame. Sleep until the
+    // output can change, network data wakes us early.
+    ms_t next( STATIC_MS );
+    for ( size_t i = 0; i < m_zones.size( ); ++i )
+    {
+        Player *player( m_zones[ i ]->player( ));
+        stamp_t shown( player->TakeShown( ));
+        if ( shown )
+        {
+            m_latency.add( shown, StampNow( ));
+            ++m_applied;
+        }
+        ms_t zoneNext( player->GetNextUpdate( now, m_zones[ i ]->strip( )));
+        next = ( zoneNext < next ) ? zoneNext : next;
+    }
+    int sleep( SLEEP_MS );
+    if ( next != STATIC_MS && ( next - now ) < ( ms_t )SLEEP_MS )
+    {
+        sleep = std::max( ( int )( next - now ), m_audio.isRunning( ) ? AUDIO_TICK_MS : TICK_MS );
+    }
+    m_frameTimer.start( sleep, this );
+
+    stamp_t done( StampNow( ));
+    m_due = ( sleep <= TICK_MS ) ? done + sleep * 1000000ull : 0;
+    m_frameCost.add( woke, done );
+    m_busy += done - woke;
+}
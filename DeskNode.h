@@ -0,0 +1,160 @@
+#pragma once
+
+#include <vector>
+#include <QBasicTimer>
+#include <QList>
+#include <QString>
+#include <QUdpSocket>
+#include <QTcpSocket>
+
+#include "Audio.h"
+#include "Checkpoint.h"
+#include "ClockSync.h"
+#include "CommandLog.h"
+#include "Latency.h"
+#include "Layout.h"
+#include "Player.h"
+#include "SequenceLibrary.h"
+#include "Zone.h"
+
+
+// One strip with its zones, each a player and sequences, and the network
+// receivers. Needs only QtCore and QtNetwork, so both the desktop app and
+// the headless daemon run on it.
+class DeskNode : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Config
+    {
+        Config( );
+
+        pixel_t length;
+        quint16 port; // LAN commands, 0 for none
+        uint8_t group; // which command to follow in batched datagrams
+        QString cloudHost; // empty for none
+        quint16 cloudPort;
+        bool indexed; // palette mode for patterns that can
+        int statsSeconds; // log latency this often, 0 for never
+        quint16 clockServe; // answer clock pings on this port, 0 for none
+        QString clockPeer; // follow this peer's clock, empty for none
+        quint16 clockPeerPort;
+        qint32 clockSkew; // pretend the local clock is off, for testing
+        uint8_t transition; // how patterns change, TRANSITION_NONE to swap
+        ms_t transitionMs;
+        QList< Zone::Config > zones; // empty for one zone over the whole strip
+        QString layout; // 2D geometry, see Layout::create, empty for none
+        QString library; // sequence library file, empty for the built-in ones
+        QString checkpoint; // state file to restart from, empty for none
+        int checkpointSeconds; // save this often
+        QString audio; // sound to follow, see AudioSource::create, empty for none
+        uint8_t audioReact; // AUDIO_REACT_* for every player
+        QString record; // log every command received here, empty for none
+    };
+
+    DeskNode( const Config &config, QObject *parent = NULL );
+    ~DeskNode();
+
+    Stripper *strip( ) { return &m_strip; }
+
+    //! the first zone's player, the whole strip's when not zoned
+    Player *player( ) { return m_zones.front( )->player( ); }
+
+    const std::vector< Zone * > &zones( ) const { return m_zones; }
+
+    //! command-to-frame latency, received to show( ) returning
+    LatencyStats &latency( ) { return m_latency; }
+
+    //! time each wake( ) takes, and how far past due the timed ones ran
+    LatencyStats &frameCost( ) { return m_frameCost; }
+    LatencyStats &frameLate( ) { return m_frameLate; }
+
+    //! shared clock, local millis( ) unless following a peer
+    ms_t now( ) const { return m_clock.now( ); }
+
+    ClockSync *clock( ) { return &m_clock; }
+
+    //! true if now( ) is a clock other nodes share, so epochs mean something
+    bool sharesClock( ) const { return m_clock.isSynced( ) || m_config.clockServe; }
+
+    //! play a command now in every zone as if it had just been received,
+    // epoch is when its step started on the shared clock or 0 to start it now
+    void inject( const RadioPixel::Command &command, ms_t epoch = 0, stamp_t received = 0 );
+
+signals:
+    //! the player moved to a new pattern or control setting
+    void changed();
+
+protected:
+    void timerEvent(QTimerEvent *event) override;
+
+private slots:
+    void onLanRecv();
+    void onCloudReconnect();
+    void onCloudRecv();
+    void onStats();
+    void onShow();
+    void onZoneShow();
+    void onLibraryReloaded();
+    void onCheckpoint();
+    void onClockStepped( qint32 delta );
+
+private:
+    // start a command in one zone
+    void play( Zone *zone, const RadioPixel::Command &command, ms_t epoch, stamp_t received );
+
+    // log a command as it comes in
+    void record( stamp_t received, uint8_t source, uint8_t group, const RadioPixel::Command &command );
+
+    // carry on from the checkpoint
+    void restore( );
+
+    // run every zone now, then sleep until one next has work
+    void wake( );
+
+    const int TICK_MS = 25; // fastest frame rate we schedule
+    const int SLEEP_MS = 60 * 1000; // longest sleep, even when static
+    const int AUDIO_TICK_MS = 1000 / 60; // fastest while following audio
+
+    Config m_config;
+
+    Stripper m_strip;
+    Layout *m_layout; // NULL for a plain strip
+
+    QBasicTimer m_frameTimer;
+
+    // patterns
+
+    std::vector< Zone * > m_zones;
+    bool m_zoneShown; // a zone drew this tick
+    stamp_t m_zoneStamp; // command a zone's frame is the first to show
+
+    SequenceLibrary m_library;
+
+    Checkpoint m_checkpoint;
+
+    AudioAnalyzer m_audio;
+    LatencyStats m_audioLatency; // analysed to drawn
+
+    QUdpSocket m_lanSocket;
+
+    QTcpSocket m_cloudSocket;
+
+    ClockSync m_clock;
+
+    bool m_rxStamps; // kernel stamps datagrams on the LAN socket
+    LatencyStats m_latency;
+
+    // load, counted between stats
+    CommandLog m_record;
+    quint64 m_ingested; // zone commands received
+    quint64 m_applied; // of those, shown before the next replaced them
+    quint64 m_frames;
+    quint64 m_missed; // timed wakes over a tick late
+    stamp_t m_busy; // ns spent in wake( )
+    stamp_t m_statsStamp;
+    stamp_t m_due; // when the next animation frame is due, 0 while static
+    LatencyStats m_frameCost;
+    LatencyStats m_frameLate;
+};
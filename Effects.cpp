@@ -0,0 +1,343 @@
+
+#include <string.h>
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "Effects.h"
+
+
+const uint8_t PERTURB_AMOUNT = 12; // max jitter per channel
+const uint8_t DECAY_KEEP = 224; // trail brightness kept per frame (/256)
+const uint32_t CHANNEL_MASK = 0x00ffffff; // leave alpha alone
+
+
+EffectChain::EffectChain( )
+    : m_effects( EFFECT_NONE ), m_historyValid( false ),
+      m_scratch( NULL ), m_history( NULL ), m_capacity( 0 )
+{
+    for ( int i = 0; i < 4; ++i )
+    {
+        m_seeds[ i ] = random( 0x7fff ) + 1; // xorshift seeds must be non-zero
+    }
+}
+
+EffectChain::~EffectChain( )
+{
+    delete [] m_scratch;
+    m_scratch = NULL;
+    delete [] m_history;
+    m_history = NULL;
+}
+
+void EffectChain::SetEffects( uint8_t effects )
+{
+    // start trails from the next frame rather than stale history
+    if ( ( effects & EFFECT_DECAY ) && !( m_effects & EFFECT_DECAY ) )
+    {
+        m_historyValid = false;
+    }
+    m_effects = effects;
+}
+
+void EffectChain::Reserve( pixel_t count )
+{
+    if ( count <= m_capacity && m_scratch && m_history )
+    {
+        return;
+    }
+
+    delete [] m_scratch;
+    delete [] m_history;
+    m_scratch = new uint32_t[ count + 2 ];
+    m_history = new uint32_t[ count ];
+    m_capacity = count;
+    m_historyValid = false;
+}
+
+void EffectChain::Apply( Stripper *strip )
+{
+    if ( !strip || !strip->numPixels( ) )
+    {
+        return;
+    }
+
+#ifndef ARDUINO
+    // the node's NeoPixel buffer is packed bytes, and there's no RAM
+    // for the work buffers anyway
+    pixel_t count( strip->numPixels( ) );
+    const uint32_t *frame( strip->getPixels( ) );
+    if ( m_effects && frame )
+    {
+        Reserve( count );
+    }
+    if ( !m_effects || !frame || !m_scratch || !m_history )
+    {
+        // indexed strips have no colors to work on
+        strip->setProcessed( false );
+        return;
+    }
+
+    // work on a copy, the pattern reads back its own frame and effects
+    // like Reverse would otherwise stack up frame after frame
+    uint32_t *pixels( strip->getOutput( ) );
+    memcpy( pixels, frame, count * sizeof( uint32_t ) );
+
+    if ( m_effects & EFFECT_SMEAR )
+    {
+        Smear( pixels, m_scratch, count );
+    }
+    if ( m_effects & EFFECT_PERTURB )
+    {
+        Perturb( pixels, count, m_seeds, PERTURB_AMOUNT );
+    }
+    if ( m_effects & EFFECT_DECAY )
+    {
+        if ( !m_historyValid )
+        {
+            memcpy( m_history, pixels, count * sizeof( uint32_t ) );
+            m_historyValid = true;
+        }
+        Decay( pixels, m_history, count, DECAY_KEEP );
+    }
+    if ( m_effects & EFFECT_MIRROR )
+    {
+        Mirror( pixels, count );
+    }
+    if ( m_effects & EFFECT_REVERSE )
+    {
+        Reverse( pixels, count );
+    }
+    strip->setProcessed( true );
+#endif
+}
+
+//-------------------------------------------------------------
+
+// per byte average, rounding up like _mm_avg_epu8
+static inline uint32_t average( uint32_t a, uint32_t b )
+{
+    return ( a | b ) - ( ( ( a ^ b ) & 0xfefefefe ) >> 1 );
+}
+
+// pad both ends so the edges blur with themselves
+static inline void pad( const uint32_t *pixels, uint32_t *scratch, pixel_t count )
+{
+    scratch[ 0 ] = pixels[ 0 ];
+    memcpy( scratch + 1, pixels, count * sizeof( uint32_t ) );
+    scratch[ count + 1 ] = pixels[ count - 1 ];
+}
+
+// pixels from i on out of the padded copy
+static inline void smear( uint32_t *pixels, const uint32_t *scratch, pixel_t i, pixel_t count )
+{
+    for ( ; i < count; ++i )
+    {
+        pixels[ i ] = average( average( scratch[ i ], scratch[ i + 2 ] ), scratch[ i + 1 ] );
+    }
+}
+
+void EffectChain::Smear( uint32_t *pixels, uint32_t *scratch, pixel_t count )
+{
+    if ( count < 2 )
+    {
+        return;
+    }
+    pad( pixels, scratch, count );
+
+    pixel_t i = 0;
+#ifdef __SSE2__
+    for ( ; i + 4 <= count; i += 4 )
+    {
+        __m128i l = _mm_loadu_si128( ( const __m128i * )( scratch + i ) );
+        __m128i c = _mm_loadu_si128( ( const __m128i * )( scratch + i + 1 ) );
+        __m128i r = _mm_loadu_si128( ( const __m128i * )( scratch + i + 2 ) );
+        _mm_storeu_si128( ( __m128i * )( pixels + i ), _mm_avg_epu8( _mm_avg_epu8( l, r ), c ) );
+    }
+#endif
+    smear( pixels, scratch, i, count );
+}
+
+void EffectChain::SmearReference( uint32_t *pixels, uint32_t *scratch, pixel_t count )
+{
+    if ( count < 2 )
+    {
+        return;
+    }
+    pad( pixels, scratch, count );
+    smear( pixels, scratch, 0, count );
+}
+
+//-------------------------------------------------------------
+
+static inline uint32_t xorshift( uint32_t x )
+{
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+// jitter one pixel by up to amount, add and sub are raw random words
+static inline uint32_t perturb( uint32_t c, uint32_t add, uint32_t sub, uint8_t mask, uint8_t amount )
+{
+    uint32_t out = c & ~CHANNEL_MASK;
+    for ( int shift = 0; shift < 24; shift += 8 )
+    {
+        int a = std::min( ( add >> shift ) & mask, ( uint32_t )amount );
+        int s = std::min( ( sub >> shift ) & mask, ( uint32_t )amount );
+        int v = ( int )( ( c >> shift ) & 0xff ) + a;
+        v = std::max( std::min( v, 255 ) - s, 0 );
+        out |= ( uint32_t )v << shift;
+    }
+    return out;
+}
+
+// smallest all-ones mask covering amount, keeps the jitter roughly uniform
+static inline uint8_t jitterMask( uint8_t amount )
+{
+    uint8_t mask = 0;
+    while ( mask < amount )
+    {
+        mask = ( mask << 1 ) | 1;
+    }
+    return mask;
+}
+
+void EffectChain::Perturb( uint32_t *pixels, pixel_t count, uint32_t *seeds, uint8_t amount )
+{
+    // four xorshift lanes, stepped twice per block of four pixels
+    pixel_t i = 0;
+#ifdef __SSE2__
+    uint8_t mask = jitterMask( amount );
+    __m128i x = _mm_loadu_si128( ( const __m128i * )seeds );
+    const __m128i channels = _mm_set1_epi32( CHANNEL_MASK );
+    const __m128i masks = _mm_and_si128( _mm_set1_epi8( ( char )mask ), channels );
+    const __m128i amounts = _mm_set1_epi8( ( char )amount );
+    for ( ; i + 4 <= count; i += 4 )
+    {
+        x = _mm_xor_si128( x, _mm_slli_epi32( x, 13 ) );
+        x = _mm_xor_si128( x, _mm_srli_epi32( x, 17 ) );
+        x = _mm_xor_si128( x, _mm_slli_epi32( x, 5 ) );
+        __m128i add = _mm_min_epu8( _mm_and_si128( x, masks ), amounts );
+        x = _mm_xor_si128( x, _mm_slli_epi32( x, 13 ) );
+        x = _mm_xor_si128( x, _mm_srli_epi32( x, 17 ) );
+        x = _mm_xor_si128( x, _mm_slli_epi32( x, 5 ) );
+        __m128i sub = _mm_min_epu8( _mm_and_si128( x, masks ), amounts );
+
+        __m128i p = _mm_loadu_si128( ( const __m128i * )( pixels + i ) );
+        p = _mm_subs_epu8( _mm_adds_epu8( p, add ), sub );
+        _mm_storeu_si128( ( __m128i * )( pixels + i ), p );
+    }
+    _mm_storeu_si128( ( __m128i * )seeds, x );
+#endif
+    PerturbReference( pixels + i, count - i, seeds, amount );
+}
+
+void EffectChain::PerturbReference( uint32_t *pixels, pixel_t count, uint32_t *seeds, uint8_t amount )
+{
+    uint8_t mask = jitterMask( amount );
+    pixel_t i = 0;
+    while ( i < count )
+    {
+        uint32_t add[ 4 ], sub[ 4 ];
+        for ( int lane = 0; lane < 4; ++lane )
+        {
+            add[ lane ] = seeds[ lane ] = xorshift( seeds[ lane ] );
+        }
+        for ( int lane = 0; lane < 4; ++lane )
+        {
+            sub[ lane ] = seeds[ lane ] = xorshift( seeds[ lane ] );
+        }
+        for ( int lane = 0; lane < 4 && i < count; ++lane, ++i )
+        {
+            pixels[ i ] = perturb( pixels[ i ], add[ lane ], sub[ lane ], mask, amount );
+        }
+    }
+}
+
+//-------------------------------------------------------------
+
+void EffectChain::Decay( uint32_t *pixels, uint32_t *history, pixel_t count, uint8_t keep )
+{
+    pixel_t i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128( );
+    const __m128i k = _mm_set1_epi16( keep );
+    for ( ; i + 4 <= count; i += 4 )
+    {
+        __m128i h = _mm_loadu_si128( ( const __m128i * )( history + i ) );
+        __m128i lo = _mm_srli_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( h, zero ), k ), 8 );
+        __m128i hi = _mm_srli_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( h, zero ), k ), 8 );
+        __m128i p = _mm_loadu_si128( ( const __m128i * )( pixels + i ) );
+        p = _mm_max_epu8( p, _mm_packus_epi16( lo, hi ) );
+        _mm_storeu_si128( ( __m128i * )( pixels + i ), p );
+        _mm_storeu_si128( ( __m128i * )( history + i ), p );
+    }
+#endif
+    DecayReference( pixels + i, history + i, count - i, keep );
+}
+
+void EffectChain::DecayReference( uint32_t *pixels, uint32_t *history, pixel_t count, uint8_t keep )
+{
+    for ( pixel_t i = 0; i < count; ++i )
+    {
+        uint32_t p = pixels[ i ], h = history[ i ], out = 0;
+        for ( int shift = 0; shift < 32; shift += 8 )
+        {
+            uint32_t a = ( p >> shift ) & 0xff;
+            uint32_t b = ( ( ( h >> shift ) & 0xff ) * keep ) >> 8;
+            out |= std::max( a, b ) << shift;
+        }
+        pixels[ i ] = history[ i ] = out;
+    }
+}
+
+//-------------------------------------------------------------
+
+void EffectChain::Mirror( uint32_t *pixels, pixel_t count )
+{
+    pixel_t i = 0;
+#ifdef __SSE2__
+    pixel_t half = count / 2;
+    for ( ; i + 4 <= half; i += 4 )
+    {
+        __m128i v = _mm_loadu_si128( ( const __m128i * )( pixels + i ) );
+        v = _mm_shuffle_epi32( v, _MM_SHUFFLE( 0, 1, 2, 3 ) );
+        _mm_storeu_si128( ( __m128i * )( pixels + count - i - 4 ), v );
+    }
+#endif
+    // the middle that's left mirrors the same way
+    MirrorReference( pixels + i, count - 2 * i );
+}
+
+void EffectChain::MirrorReference( uint32_t *pixels, pixel_t count )
+{
+    for ( pixel_t i = 0; i < count / 2; ++i )
+    {
+        pixels[ count - i - 1 ] = pixels[ i ];
+    }
+}
+
+void EffectChain::Reverse( uint32_t *pixels, pixel_t count )
+{
+    pixel_t i = 0, j = count;
+#ifdef __SSE2__
+    for ( ; j - i >= 8; i += 4, j -= 4 )
+    {
+        __m128i a = _mm_loadu_si128( ( const __m128i * )( pixels + i ) );
+        __m128i b = _mm_loadu_si128( ( const __m128i * )( pixels + j - 4 ) );
+        _mm_storeu_si128( ( __m128i * )( pixels + i ), _mm_shuffle_epi32( b, _MM_SHUFFLE( 0, 1, 2, 3 ) ) );
+        _mm_storeu_si128( ( __m128i * )( pixels + j - 4 ), _mm_shuffle_epi32( a, _MM_SHUFFLE( 0, 1, 2, 3 ) ) );
+    }
+#endif
+    ReverseReference( pixels + i, j - i );
+}
+
+void EffectChain::ReverseReference( uint32_t *pixels, pixel_t count )
+{
+    for ( pixel_t i = 0, j = count; j - i >= 2; ++i, --j )
+    {
+        std::swap( pixels[ i ], pixels[ j - 1 ] );
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Stripper.h"
+
+
+// post-processing effects, combined as a bit mask and applied to the
+// whole frame in this order after the pattern update and before show( )
+enum
+{
+    EFFECT_NONE    = 0x00,
+    EFFECT_SMEAR   = 0x01, // 3-tap blur
+    EFFECT_PERTURB = 0x02, // random jitter per channel
+    EFFECT_DECAY   = 0x04, // exponential trails
+    EFFECT_MIRROR  = 0x08, // reflect the first half onto the second
+    EFFECT_REVERSE = 0x10  // flip the strip end to end
+};
+
+
+class EffectChain
+{
+public:
+    EffectChain( );
+
+    ~EffectChain( );
+
+    //! select the effect stack
+    void SetEffects( uint8_t effects );
+
+    //! returns the effect stack
+    uint8_t GetEffects( ) const { return m_effects; }
+
+    //! true if the stack changes the frame every time it runs, even over
+    // a pattern that holds still
+    bool IsAnimated( ) const { return m_effects & ( EFFECT_PERTURB | EFFECT_DECAY ); }
+
+    //! run the effect stack over a copy of the strip's frame into its
+    // output, the frame itself stays as the pattern left it
+    void Apply( Stripper *strip );
+
+    // kernels, all work in place on count pixels
+
+    // [ 1 2 1 ] / 4 blur, scratch holds count + 2 pixels
+    static void Smear( uint32_t *pixels, uint32_t *scratch, pixel_t count );
+
+    // add and subtract up to amount per channel, seeds holds 4 lanes
+    static void Perturb( uint32_t *pixels, pixel_t count, uint32_t *seeds, uint8_t amount );
+
+    // keep the brighter of pixels and history faded by keep / 256
+    static void Decay( uint32_t *pixels, uint32_t *history, pixel_t count, uint8_t keep );
+
+    static void Mirror( uint32_t *pixels, pixel_t count );
+
+    static void Reverse( uint32_t *pixels, pixel_t count );
+
+    // the scalar loops alone, for checking the kernels against
+
+    static void SmearReference( uint32_t *pixels, uint32_t *scratch, pixel_t count );
+
+    static void PerturbReference( uint32_t *pixels, pixel_t count, uint32_t *seeds, uint8_t amount );
+
+    static void DecayReference( uint32_t *pixels, uint32_t *history, pixel_t count, uint8_t keep );
+
+    static void MirrorReference( uint32_t *pixels, pixel_t count );
+
+    static void ReverseReference( uint32_t *pixels, pixel_t count );
+
+private:
+    // grow the work buffers, only when the strip gets longer
+    void Reserve( pixel_t count );
+
+    uint8_t m_effects;
+    bool m_historyValid;
+
+    uint32_t *m_scratch;
+    uint32_t *m_history;
+    pixel_t m_capacity;
+
+    uint32_t m_seeds[ 4 ];
+};
@@ -0,0 +1,274 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "FrameRing.h"
+
+
+// readers in another process need the counters to be real atomics
+static_assert( ATOMIC_INT_LOCK_FREE == 2, "FrameRing needs lock-free 32 bit atomics" );
+static_assert( sizeof( FrameRing::Header ) <= 64, "FrameRing header outgrew its cache line" );
+
+// attempts before readLatest gives up on a writer that keeps lapping it
+const int READ_RETRIES = 4;
+
+
+FrameRing::FrameRing( )
+    : m_header( NULL ), m_size( 0 ), m_slotCount( 0 ), m_capacity( 0 ), m_slotBytes( 0 ),
+      m_writer( false ), m_name( NULL ), m_inode( 0 )
+{
+}
+
+FrameRing::~FrameRing( )
+{
+    close( );
+}
+
+bool FrameRing::map( int fd, size_t size, bool writable )
+{
+    void *base = mmap( NULL, size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                       MAP_SHARED, fd, 0 );
+    ::close( fd );
+    if ( base == MAP_FAILED )
+    {
+        return false;
+    }
+    m_header = ( Header *)base;
+    m_size = size;
+    return true;
+}
+
+bool FrameRing::create( const char *name, uint32_t capacity, uint32_t slotCount )
+{
+    close( );
+    if ( !capacity || !slotCount )
+    {
+        return false;
+    }
+
+    // keep slots cache line aligned so readers don't share lines with
+    // the slot being written
+    size_t slotBytes = ( sizeof( Slot ) + capacity * sizeof( uint32_t ) + 63 ) & ~( size_t )63;
+    size_t size = 64 + slotBytes * slotCount;
+
+    // a fresh segment, never the old one resized under its readers: they
+    // keep their mapping of it until they notice and open( ) again
+    shm_unlink( name );
+    int fd = shm_open( name, O_RDWR | O_CREAT | O_EXCL, 0644 );
+    if ( fd < 0 )
+    {
+        return false;
+    }
+    struct stat st;
+    if ( ftruncate( fd, size ) < 0 || fstat( fd, &st ) < 0 )
+    {
+        ::close( fd );
+        shm_unlink( name );
+        return false;
+    }
+    if ( !map( fd, size, true ))
+    {
+        shm_unlink( name );
+        return false;
+    }
+    m_writer = true;
+    m_name = strdup( name );
+    m_inode = st.st_ino;
+    m_slotCount = slotCount;
+    m_capacity = capacity;
+    m_slotBytes = slotBytes;
+
+    // readers check the magic last, so fill everything in first
+    memset( ( void *)m_header, 0, size );
+    m_header->version = VERSION;
+    m_header->slotCount = slotCount;
+    m_header->capacity = capacity;
+    m_header->slotBytes = slotBytes;
+    m_header->head.store( 0, std::memory_order_relaxed );
+    m_header->magic.store( MAGIC, std::memory_order_release );
+    return true;
+}
+
+bool FrameRing::open( const char *name )
+{
+    close( );
+
+    int fd = shm_open( name, O_RDONLY, 0 );
+    if ( fd < 0 )
+    {
+        return false;
+    }
+    struct stat st;
+    if ( fstat( fd, &st ) < 0 || ( size_t )st.st_size < 64 )
+    {
+        ::close( fd );
+        return false;
+    }
+    if ( !map( fd, st.st_size, false ))
+    {
+        return false;
+    }
+
+    const Header *header = m_header;
+    if ( header->magic.load( std::memory_order_acquire ) != MAGIC || header->version != VERSION || !header->slotCount ||
+         ( size_t )header->slotBytes < sizeof( Slot ) + ( size_t )header->capacity * sizeof( uint32_t ) ||
+         64 + ( size_t )header->slotBytes * header->slotCount > m_size )
+    {
+        close( );
+        return false;
+    }
+    m_slotCount = header->slotCount;
+    m_capacity = header->capacity;
+    m_slotBytes = header->slotBytes;
+    return true;
+}
+
+void FrameRing::close( )
+{
+    if ( m_header )
+    {
+        if ( m_writer )
+        {
+            // readers still mapping it see the writer has gone
+            m_header->magic.store( 0, std::memory_order_release );
+        }
+        munmap( ( void *)m_header, m_size );
+        m_header = NULL;
+        m_size = 0;
+    }
+    if ( m_name )
+    {
+        int fd = shm_open( m_name, O_RDONLY, 0 );
+        struct stat st;
+        if ( fd >= 0 && fstat( fd, &st ) == 0 && ( uint64_t )st.st_ino == m_inode )
+        {
+            shm_unlink( m_name );
+        }
+        if ( fd >= 0 )
+        {
+            ::close( fd );
+        }
+        free( m_name );
+        m_name = NULL;
+    }
+    m_writer = false;
+    m_slotCount = 0;
+    m_capacity = 0;
+    m_slotBytes = 0;
+}
+
+bool FrameRing::stale( ) const
+{
+    return !m_header || m_header->magic.load( std::memory_order_acquire ) != MAGIC;
+}
+
+FrameRing::Slot *FrameRing::slot( uint32_t frame ) const
+{
+    return ( Slot *)( ( char *)m_header + 64 + ( size_t )( frame % m_slotCount ) * m_slotBytes );
+}
+
+//-------------------------------------------------------------
+
+void FrameRing::publish( const uint32_t *pixels, uint32_t count, uint32_t time, uint8_t brightness )
+{
+    if ( !m_writer )
+    {
+        return;
+    }
+
+    uint32_t frame = m_header->head.load( std::memory_order_relaxed ) + 1;
+    if ( !frame )
+    {
+        frame = 1; // 0 means nothing yet
+    }
+    Slot *s = slot( frame );
+
+    // odd: readers of the frame that used this slot before will see it changing
+    s->seq.store( 2 * frame - 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+
+    count = ( count < m_capacity ) ? count : m_capacity;
+    s->frame = frame;
+    s->count = count;
+    s->time = time;
+    s->brightness = brightness;
+    memcpy( ( void *)( s + 1 ), pixels, count * sizeof( uint32_t ));
+
+    s->seq.store( 2 * frame, std::memory_order_release );
+    m_header->head.store( frame, std::memory_order_release );
+}
+
+//-------------------------------------------------------------
+
+uint32_t FrameRing::head( ) const
+{
+    return stale( ) ? 0 : m_header->head.load( std::memory_order_acquire );
+}
+
+bool FrameRing::valid( uint32_t frame ) const
+{
+    if ( stale( ) || !frame )
+    {
+        return false;
+    }
+    std::atomic_thread_fence( std::memory_order_acquire );
+    return slot( frame )->seq.load( std::memory_order_relaxed ) == 2 * frame;
+}
+
+const uint32_t *FrameRing::peek( uint32_t frame, Info *info ) const
+{
+    if ( stale( ) || !frame )
+    {
+        return NULL;
+    }
+    Slot *s = slot( frame );
+    if ( s->seq.load( std::memory_order_acquire ) != 2 * frame )
+    {
+        return NULL;
+    }
+    if ( info )
+    {
+        info->frame = frame;
+        uint32_t count = s->count;
+        info->count = ( count < m_capacity ) ? count : m_capacity;
+        info->time = s->time;
+        info->brightness = s->brightness;
+    }
+    return ( const uint32_t *)( s + 1 );
+}
+
+bool FrameRing::read( uint32_t frame, uint32_t *pixels, uint32_t capacity, Info *info ) const
+{
+    Info local;
+    const uint32_t *src = peek( frame, &local );
+    if ( !src )
+    {
+        return false;
+    }
+    uint32_t count = ( local.count < capacity ) ? local.count : capacity;
+    memcpy( pixels, src, count * sizeof( uint32_t ));
+    if ( !valid( frame ))
+    {
+        return false;
+    }
+    local.count = count;
+    if ( info )
+    {
+        *info = local;
+    }
+    return true;
+}
+
+bool FrameRing::readLatest( uint32_t *pixels, uint32_t capacity, Info *info ) const
+{
+    for ( int i = 0; i < READ_RETRIES; ++i )
+    {
+        if ( read( head( ), pixels, capacity, info ))
+        {
+            return true;
+        }
+    }
+    return false;
+}
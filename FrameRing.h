@@ -0,0 +1,115 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+
+// A ring of rendered frames in POSIX shared memory. One writer publishes
+// each frame into the next slot, any number of local readers map the same
+// segment read-only and never block it. Every slot carries a seqlock: odd
+// while the writer is inside it, 2 * frame once the frame is complete, so a
+// reader that sees the same even value before and after looking at the
+// pixels knows they weren't torn.
+//
+// A reader keeps the geometry it found at open( ), and a writer never
+// reshapes a segment in place: create( ) replaces the name with a fresh
+// segment and close( ) clears the magic in the old one. Once reads start
+// failing with stale( ), open( ) again to follow a restarted writer; one
+// that died without closing just stops moving head( ).
+//
+// Only needs libc, so drivers and recorders outside the app can link it.
+class FrameRing
+{
+public:
+    static const uint32_t MAGIC = 0x52504652; // "RPFR"
+    static const uint32_t VERSION = 1;
+
+    struct Header
+    {
+        std::atomic<uint32_t> magic; // written last, cleared when the writer closes
+        uint32_t version;
+        uint32_t slotCount;
+        uint32_t capacity; // pixels per slot
+        uint32_t slotBytes; // stride from one slot to the next
+        std::atomic<uint32_t> head; // last complete frame number, 0 for none
+    };
+
+    struct Slot
+    {
+        std::atomic<uint32_t> seq; // 2 * frame, odd while writing
+        uint32_t frame;
+        uint32_t count; // pixels in this frame
+        uint32_t time; // renderer millis( )
+        uint8_t brightness;
+        uint8_t reserved[ 3 ];
+        // uint32_t pixels[ capacity ] follow, 0xAARRGGBB with alpha unused
+    };
+
+    // what a reader gets back with a frame
+    struct Info
+    {
+        uint32_t frame;
+        uint32_t count;
+        uint32_t time;
+        uint8_t brightness;
+    };
+
+    FrameRing( );
+
+    ~FrameRing( );
+
+    //! create ( or take over ) the named segment as the writer
+    bool create( const char *name, uint32_t capacity, uint32_t slotCount = 8 );
+
+    //! map an existing segment read-only
+    bool open( const char *name );
+
+    void close( );
+
+    bool isOpen( ) const { return m_header != NULL; }
+
+    //! true once the writer of this segment has gone away
+    bool stale( ) const;
+
+    uint32_t capacity( ) const { return m_capacity; }
+
+    // writer
+
+    //! publish a frame, count is clipped to the capacity
+    void publish( const uint32_t *pixels, uint32_t count, uint32_t time, uint8_t brightness );
+
+    // reader
+
+    //! newest complete frame number, 0 before the first
+    uint32_t head( ) const;
+
+    //! zero-copy access to a frame, NULL once it has been overwritten.
+    // The pixels may be overwritten while you look at them, so check
+    // valid( ) afterwards before trusting what you read.
+    const uint32_t *peek( uint32_t frame, Info *info ) const;
+
+    //! true if frame still hasn't been overwritten
+    bool valid( uint32_t frame ) const;
+
+    //! copy a frame out, false if it has gone or never existed
+    bool read( uint32_t frame, uint32_t *pixels, uint32_t capacity, Info *info ) const;
+
+    //! copy the newest frame out, retrying if the writer laps us
+    bool readLatest( uint32_t *pixels, uint32_t capacity, Info *info ) const;
+
+private:
+    Slot *slot( uint32_t frame ) const;
+
+    bool map( int fd, size_t size, bool writable );
+
+    Header *m_header;
+    size_t m_size;
+    // copied at open( ) so nothing in shared memory can move a reader out of bounds
+    uint32_t m_slotCount;
+    uint32_t m_capacity;
+    size_t m_slotBytes;
+    bool m_writer;
+    char *m_name; // unlinked again when the writer closes
+    uint64_t m_inode; // unless a newer writer has taken the name since
+};
@@ -64,80 +64,3 @@ uint32_t Gradient::getColor( uint8_t pos )
         return Stripper::ColorBlend( m_steps[ i ].color, m_steps[ i + 1 ].color, f );
     }
 }
-
-/*
-
-void Gradient::smear()
-{
-    uint8_t prevVal, savePixel;
-    uint16_t _numPixels = strip->numPixels();
-    if (!strip || !strip->numPixels( ) || !_pixels)
-    {
-        return;
-    }
-    _pixels[0] = (uint8_t)((int)(_pixels[0] + _pixels[1])/3);
-    prevVal = _pixels[0];
-    for (int i=1; i < _numPixels - 1; i++)
-    {
-        savePixel = _pixels[i];
-        _pixels[i] = (uint8_t)((int)(_pixels[i] + _pixels[i+1] + prevVal)/3);
-        prevVal = savePixel;
-    }
-    _pixels[_numPixels-1] = (uint8_t)((int)(_pixels[_numPixels] + _pixels[prevVal])/3);
-    updateStrip();
-}
-
-void Gradient::randomize()
-{
-    for (int i=0; i < strip->numPixels( ); i++)
-    {
-        _pixels[i] = random(255);
-    }
-    updateStrip();
-}
-
-void Gradient::randomize(int low, int high)
-{
-    for (int i=0; i < strip->numPixels( ); i++)
-    {
-        _pixels[i] = random(low, high);
-    }
-    updateStrip();
-}
-
-void Gradient::peturb(int low, int high)
-{
-    int temp;
-    for (int i=0; i < strip->numPixels( ); i++)
-    {
-        temp = _pixels[i] + (random(low, high));
-        if (temp < 0) temp = 0;
-        if (temp > 255) temp = 255;
-        _pixels[i] = temp;
-    }
-    updateStrip();
-}
-
-void Gradient::fade()
-{
-    for (int i=0; i < strip->numPixels( ); i++)
-    {
-        if (_pixels[i] < 4)
-            _pixels[i] = 0;
-        else
-            _pixels[i] -= 4;
-    }
-    updateStrip();
-}
-
-void Gradient::wipe(byte level)
-{
-    for (int i=0; i < strip->numPixels( ); i++)
-    {
-        _pixels[i] = level;
-    }
-    updateStrip();
-}
-
-*/
-
@@ -22,15 +22,6 @@ public:
 
   uint32_t getColor( uint8_t pos );
 
-/*  
-  void smear();
-  void randomize();
-  void randomize(int, int); // set low and high range
-  void peturb(int, int); 
-  void fade();
-  void wipe(byte level);
-*/
-    
 private:
   Step m_steps[ 10 ];
   uint8_t m_stepCount;
@@ -0,0 +1,113 @@
+#include <string.h>
+#include <algorithm>
+#include <QDateTime>
+#include <QDebug>
+#ifdef Q_OS_UNIX
+#include <time.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#endif
+#include "Latency.h"
+
+
+const int LATENCY_WINDOW = 4096; // samples kept for the percentiles
+
+
+stamp_t StampNow( )
+{
+#ifdef Q_OS_UNIX
+    struct timespec ts;
+    clock_gettime( CLOCK_REALTIME, &ts );
+    return ( stamp_t )ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+    return ( stamp_t )QDateTime::currentMSecsSinceEpoch( ) * 1000000;
+#endif
+}
+
+bool EnableRxStamps( int fd )
+{
+#ifdef SO_TIMESTAMPNS
+    int on = 1;
+    return setsockopt( fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof on ) == 0;
+#else
+    Q_UNUSED( fd );
+    return false;
+#endif
+}
+
+bool PeekRxStamp( int fd, stamp_t *stamp )
+{
+#ifdef SO_TIMESTAMPNS
+    char control[ CMSG_SPACE( sizeof( struct timespec )) ];
+    char byte;
+    struct iovec iov = { &byte, sizeof byte };
+    struct msghdr msg = { };
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof control;
+
+    // leave the datagram for the socket to read as usual
+    if ( recvmsg( fd, &msg, MSG_PEEK | MSG_DONTWAIT ) < 0 )
+    {
+        return false;
+    }
+    for ( struct cmsghdr *c = CMSG_FIRSTHDR( &msg ); c; c = CMSG_NXTHDR( &msg, c ))
+    {
+        if ( c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS )
+        {
+            struct timespec ts;
+            memcpy( &ts, CMSG_DATA( c ), sizeof ts );
+            *stamp = ( stamp_t )ts.tv_sec * 1000000000 + ts.tv_nsec;
+            return true;
+        }
+    }
+#else
+    Q_UNUSED( fd );
+    Q_UNUSED( stamp );
+#endif
+    return false;
+}
+
+//-------------------------------------------------------------
+
+LatencyStats::LatencyStats( )
+    : m_samples( LATENCY_WINDOW ), m_next( 0 ), m_count( 0 )
+{
+}
+
+void LatencyStats::add( stamp_t received, stamp_t shown )
+{
+    // the wall clock can step back under us
+    m_samples[ m_next ] = ( shown > received ) ? shown - received : 0;
+    m_next = ( m_next + 1 ) % LATENCY_WINDOW;
+    m_count = std::min( m_count + 1, LATENCY_WINDOW );
+}
+
+quint64 LatencyStats::percentile( double p ) const
+{
+    if ( !m_count )
+    {
+        return 0;
+    }
+    std::vector< quint64 > sorted( m_samples.begin( ), m_samples.begin( ) + m_count );
+    size_t rank = std::min( ( size_t )( p / 100 * m_count ), sorted.size( ) - 1 );
+    std::nth_element( sorted.begin( ), sorted.begin( ) + rank, sorted.end( ));
+    return sorted[ rank ];
+}
+
+QString LatencyStats::summary( ) const
+{
+    return QString( "n %1 p50 %2 ms p99 %3 ms max %4 ms" )
+        .arg( m_count )
+        .arg( percentile( 50 ) / 1e6, 0, 'f', 2 )
+        .arg( percentile( 99 ) / 1e6, 0, 'f', 2 )
+        .arg( percentile( 100 ) / 1e6, 0, 'f', 2 );
+}
+
+void LatencyStats::clear( )
+{
+    m_next = 0;
+    m_count = 0;
+}
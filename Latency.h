@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <QString>
+#include "Player.h"
+
+
+//! wall clock in the same units and epoch as kernel receive stamps
+stamp_t StampNow( );
+
+//! ask the kernel to stamp datagrams as they arrive ( SO_TIMESTAMPNS )
+bool EnableRxStamps( int fd );
+
+//! kernel receive stamp of the next pending datagram, without reading it
+bool PeekRxStamp( int fd, stamp_t *stamp );
+
+
+// The last few thousand command-to-frame latencies, in ns
+class LatencyStats
+{
+public:
+    LatencyStats( );
+
+    void add( stamp_t received, stamp_t shown );
+
+    int count( ) const { return m_count; }
+
+    //! latency at a percentile ( 0 - 100 ) of the window, 0 if empty
+    quint64 percentile( double p ) const;
+
+    //! "n 123 p50 0.41 ms p99 1.20 ms max 2.02 ms"
+    QString summary( ) const;
+
+    void clear( );
+
+private:
+    std::vector< quint64 > m_samples; // ring
+    int m_next;
+    int m_count;
+};
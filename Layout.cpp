@@ -0,0 +1,183 @@
+#include <math.h>
+#include <algorithm>
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+#include "Layout.h"
+
+
+// sanity limit, the cell maps are uint16_t
+const int MAX_SIDE = 4096;
+
+const pixel_t Layout::NONE;
+
+Layout::Layout( )
+    : m_count( 0 ), m_width( 0 ), m_height( 0 )
+{
+}
+
+Layout *Layout::rows( int width, int height, bool serpentine )
+{
+    std::vector< int > xs, ys;
+    for ( int y = 0; y < height; ++y )
+    {
+        for ( int x = 0; x < width; ++x )
+        {
+            xs.push_back( ( serpentine && ( y & 1 )) ? width - 1 - x : x );
+            ys.push_back( y );
+        }
+    }
+    return points( xs, ys );
+}
+
+Layout *Layout::columns( int width, int height, bool serpentine )
+{
+    std::vector< int > xs, ys;
+    for ( int x = 0; x < width; ++x )
+    {
+        for ( int y = 0; y < height; ++y )
+        {
+            xs.push_back( x );
+            ys.push_back( ( serpentine && ( x & 1 )) ? height - 1 - y : y );
+        }
+    }
+    return points( xs, ys );
+}
+
+Layout *Layout::line( pixel_t count )
+{
+    std::vector< int > xs, ys;
+    for ( pixel_t i = 0; i < count; ++i )
+    {
+        xs.push_back( i % MAX_SIDE );
+        ys.push_back( i / MAX_SIDE );
+    }
+    return points( xs, ys );
+}
+
+Layout *Layout::points( const std::vector< int > &xs, const std::vector< int > &ys )
+{
+    if ( xs.empty( ) || xs.size( ) != ys.size( ))
+    {
+        return NULL;
+    }
+
+    // grid from the bounding box
+    int left( *std::min_element( xs.begin( ), xs.end( )));
+    int top( *std::min_element( ys.begin( ), ys.end( )));
+    int width( *std::max_element( xs.begin( ), xs.end( )) - left + 1 );
+    int height( *std::max_element( ys.begin( ), ys.end( )) - top + 1 );
+    if ( width > MAX_SIDE || height > MAX_SIDE )
+    {
+        return NULL;
+    }
+
+    Layout *layout = new Layout;
+    layout->m_count = xs.size( );
+    layout->m_width = width;
+    layout->m_height = height;
+    for ( size_t i = 0; i < xs.size( ); ++i )
+    {
+        layout->m_x.push_back( xs[ i ] - left );
+        layout->m_y.push_back( ys[ i ] - top );
+    }
+    layout->build( );
+    return layout;
+}
+
+Layout *Layout::create( const QString &spec )
+{
+    QString kind( spec.section( ':', 0, 0 ));
+    QString args( spec.section( ':', 1 ));
+
+    if ( kind == "points" )
+    {
+        QFile file( args );
+        if ( !file.open( QIODevice::ReadOnly | QIODevice::Text ))
+        {
+            qWarning( ) << "can't open layout" << args << file.errorString( );
+            return NULL;
+        }
+        std::vector< int > xs, ys;
+        QTextStream in( &file );
+        while ( !in.atEnd( ))
+        {
+            QString line( in.readLine( ).section( '#', 0, 0 ).trimmed( ));
+            if ( line.isEmpty( ))
+            {
+                continue;
+            }
+            bool okX, okY;
+            xs.push_back( line.section( ' ', 0, 0, QString::SectionSkipEmpty ).toInt( &okX ));
+            ys.push_back( line.section( ' ', 1, 1, QString::SectionSkipEmpty ).toInt( &okY ));
+            if ( !okX || !okY )
+            {
+                qWarning( ) << "bad layout point" << line;
+                return NULL;
+            }
+        }
+        return points( xs, ys );
+    }
+
+    bool okW, okH;
+    int width( args.section( 'x', 0, 0 ).toInt( &okW ));
+    int height( args.section( 'x', 1 ).toInt( &okH ));
+    if ( !okW || !okH || width < 1 || height < 1 )
+    {
+        qWarning( ) << "bad layout size" << spec;
+        return NULL;
+    }
+
+    if ( kind == "rows" )
+    {
+        return rows( width, height, false );
+    }
+    else if ( kind == "serpentine" )
+    {
+        return rows( width, height, true );
+    }
+    else if ( kind == "columns" )
+    {
+        return columns( width, height, false );
+    }
+    else if ( kind == "serpentine-columns" )
+    {
+        return columns( width, height, true );
+    }
+    qWarning( ) << "unknown layout" << spec;
+    return NULL;
+}
+
+void Layout::build( )
+{
+    // forward map, the first pixel wins a shared cell
+    m_grid.assign( m_width * m_height, NONE );
+    for ( pixel_t i = m_count; i-- > 0; )
+    {
+        m_grid[ m_y[ i ] * m_width + m_x[ i ]] = i;
+    }
+
+    // pattern coordinates about the middle of the grid
+    double cx( ( m_width - 1 ) / 2.0 );
+    double cy( ( m_height - 1 ) / 2.0 );
+    double farthest( 0 );
+    for ( pixel_t i = 0; i < m_count; ++i )
+    {
+        farthest = std::max( farthest, hypot( m_x[ i ] - cx, m_y[ i ] - cy ));
+    }
+
+    m_u.resize( m_count );
+    m_v.resize( m_count );
+    m_angle.resize( m_count );
+    m_radius.resize( m_count );
+    for ( pixel_t i = 0; i < m_count; ++i )
+    {
+        m_u[ i ] = ( m_width > 1 ) ? m_x[ i ] * 255 / ( m_width - 1 ) : 0;
+        m_v[ i ] = ( m_height > 1 ) ? m_y[ i ] * 255 / ( m_height - 1 ) : 0;
+
+        double dx( m_x[ i ] - cx ), dy( m_y[ i ] - cy );
+        double turn( atan2( dy, dx ) / ( 2 * M_PI ));
+        m_angle[ i ] = ( int )floor( ( turn < 0 ? turn + 1 : turn ) * 256 ) & 0xff;
+        m_radius[ i ] = ( farthest > 0 ) ? ( int )( hypot( dx, dy ) * 255 / farthest ) : 0;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include <QString>
+
+#include "StripBase.h"
+
+
+// Where each pixel of a strip sits on a 2D grid. Everything patterns and
+// outputs need is worked out once here, so nothing does coordinate math
+// per pixel per frame.
+class Layout
+{
+public:
+    static const pixel_t NONE = 0xffffffff; // grid cell with no pixel
+
+    //! a width x height matrix wired a row at a time, every other row
+    // running back when serpentine
+    static Layout *rows( int width, int height, bool serpentine );
+
+    //! the same wired a column at a time
+    static Layout *columns( int width, int height, bool serpentine );
+
+    //! a plain strip of count pixels, one row, or rows of the widest grid
+    // allowed once it is longer than that
+    static Layout *line( pixel_t count );
+
+    //! any shape, the cell of each pixel in wiring order
+    static Layout *points( const std::vector< int > &xs, const std::vector< int > &ys );
+
+    //! "rows:16x16", "columns:WxH", "serpentine:WxH", "serpentine-columns:WxH"
+    // or "points:path" for a file of "x y" lines, NULL if bad
+    static Layout *create( const QString &spec );
+
+    pixel_t count( ) const { return m_count; }
+
+    int width( ) const { return m_width; }
+
+    int height( ) const { return m_height; }
+
+    //! forward map, the pixel at a cell or NONE
+    pixel_t pixelAt( int x, int y ) const { return m_grid[ y * m_width + x ]; }
+
+    //! the whole forward map, row after row, width * height cells
+    const pixel_t *grid( ) const { return m_grid.data( ); }
+
+    //! inverse map, the cell of a pixel
+    int x( pixel_t pixel ) const { return m_x[ pixel ]; }
+
+    int y( pixel_t pixel ) const { return m_y[ pixel ]; }
+
+    // per pixel for patterns, 0 - 255 across the grid
+    const uint8_t *u( ) const { return m_u.data( ); }
+    const uint8_t *v( ) const { return m_v.data( ); }
+
+    // per pixel around the centre, angle a full turn and radius out to
+    // the farthest pixel, both 0 - 255
+    const uint8_t *angle( ) const { return m_angle.data( ); }
+    const uint8_t *radius( ) const { return m_radius.data( ); }
+
+private:
+    Layout( );
+
+    // build every map from the inverse one
+    void build( );
+
+    pixel_t m_count;
+    int m_width;
+    int m_height;
+
+    std::vector< pixel_t > m_grid;
+    std::vector< uint16_t > m_x;
+    std::vector< uint16_t > m_y;
+
+    std::vector< uint8_t > m_u;
+    std::vector< uint8_t > m_v;
+    std::vector< uint8_t > m_angle;
+    std::vector< uint8_t > m_radius;
+};
@@ -0,0 +1,357 @@
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include "MeshSim.h"
+
+
+const ms_t PHASE_SAMPLE_MS = 100; // how often converged phases are compared
+const uint64_t WORKER_PIXELS = 64 * 1024; // less than this isn't worth a thread
+
+
+// one firmware node, minus the buttons and serial port
+struct MeshSim::Node
+{
+    Node( pixel_t length )
+        : strip( length, 0, 0 ),
+          recvSequence( &recvPacket ),
+          lastTransmit( 0 )
+    {
+        memset( &recvPacket, 0, sizeof recvPacket );
+        strip.setBrightness( 255 );
+    }
+
+    Stripper strip;
+    Player player;
+    IdleSequence idle;
+    RadioPixel::Command recvPacket;
+    PacketSequence recvSequence;
+    ms_t lastTransmit;
+};
+
+
+void RandomCommand( std::mt19937 &random, RadioPixel::Command *command, uint8_t minBrightness )
+{
+    memset( command, 0, sizeof *command );
+    command->command = HC_PATTERN;
+    command->brightness = ( minBrightness < 255 ) ? minBrightness + random( ) % ( 256 - minBrightness ) : 255;
+    command->speed = 50 + random( ) % 100;
+    command->pattern = RadioPixel::Command::MiniTwinkle +
+                       random( ) % ( RadioPixel::Command::CandyCane - RadioPixel::Command::MiniTwinkle + 1 );
+    for ( int i = 0; i < 3; ++i )
+    {
+        command->color[ i ] = random( ) & 0xffffff;
+        command->level[ i ] = random( );
+    }
+}
+
+
+MeshSim::Config::Config( )
+    : nodes( 32 ), length( 92 ),
+      loss( 0.05 ), latency( 3 ), jitter( 2 ),
+      duration( 60 * 1000 ), changeMs( 5000 ), transmitMs( 1000 ),
+      seed( 1 ), threads( 0 ), epochs( false )
+{
+}
+
+MeshSim::MeshSim( const Config &config )
+    : m_config( config ),
+      m_random( config.seed ),
+      m_workers( 1 ), m_frame( 0 ), m_renderAt( 0 ), m_pending( 0 ), m_stopping( false ),
+      m_sent( 0 ), m_delivered( 0 ), m_unconverged( 0 ), m_frames( 0 )
+{
+    if ( m_config.nodes < 1 )
+    {
+        m_config.nodes = 1;
+    }
+    if ( m_config.threads <= 0 )
+    {
+        m_config.threads = std::max( 1u, std::thread::hardware_concurrency( ) );
+    }
+    for ( int i = 0; i < m_config.nodes; ++i )
+    {
+        m_nodes.push_back( new Node( m_config.length ));
+    }
+
+    // nodes share nothing, so contiguous runs of them render in parallel
+    uint64_t pixels = ( uint64_t )m_nodes.size( ) * m_config.length;
+    m_workers = std::min( ( uint64_t )m_config.threads, pixels / WORKER_PIXELS + 1 );
+    for ( int w = 1; w < m_workers; ++w )
+    {
+        m_pool.push_back( std::thread( &MeshSim::Work, this, w ));
+    }
+}
+
+MeshSim::~MeshSim( )
+{
+    {
+        std::lock_guard< std::mutex > lock( m_lock );
+        m_stopping = true;
+    }
+    m_wake.notify_all( );
+    for ( size_t i = 0; i < m_pool.size( ); ++i )
+    {
+        m_pool[ i ].join( );
+    }
+    for ( size_t i = 0; i < m_nodes.size( ); ++i )
+    {
+        delete m_nodes[ i ];
+    }
+}
+
+void MeshSim::Broadcast( int from, ms_t now, const RadioPixel::Command &command, ms_t epoch )
+{
+    ++m_sent;
+    std::uniform_real_distribution< double > chance( 0, 1 );
+    for ( int to = 0; to < ( int )m_nodes.size( ); ++to )
+    {
+        if ( to == from || chance( m_random ) < m_config.loss )
+        {
+            continue;
+        }
+        Packet packet;
+        packet.deliverAt = now + m_config.latency +
+                           ( m_config.jitter ? m_random( ) % ( m_config.jitter + 1 ) : 0 );
+        packet.to = to;
+        packet.command = command;
+        packet.epoch = epoch;
+        m_air.push_back( packet );
+        std::push_heap( m_air.begin( ), m_air.end( ), std::greater< Packet >( ));
+    }
+}
+
+uint32_t MeshSim::WorkerSeed( int worker ) const
+{
+    return m_config.seed + worker * 2654435761u;
+}
+
+void MeshSim::RenderShare( int worker, ms_t now )
+{
+    size_t first = m_nodes.size( ) * worker / m_workers;
+    size_t last = m_nodes.size( ) * ( worker + 1 ) / m_workers;
+    for ( size_t i = first; i < last; ++i )
+    {
+        m_nodes[ i ]->player.UpdateStrip( now, &m_nodes[ i ]->strip );
+    }
+}
+
+void MeshSim::Work( int worker )
+{
+    randomSeed( WorkerSeed( worker ));
+    uint64_t seen( 0 );
+    for ( ;; )
+    {
+        ms_t now;
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            m_wake.wait( lock, [ this, seen ]( ) { return m_stopping || m_frame != seen; } );
+            if ( m_stopping )
+            {
+                return;
+            }
+            seen = m_frame;
+            now = m_renderAt;
+        }
+        RenderShare( worker, now );
+        std::lock_guard< std::mutex > lock( m_lock );
+        if ( !--m_pending )
+        {
+            m_done.notify_one( );
+        }
+    }
+}
+
+void MeshSim::RenderAll( ms_t now )
+{
+    if ( m_workers > 1 )
+    {
+        {
+            std::lock_guard< std::mutex > lock( m_lock );
+            m_renderAt = now;
+            m_pending = m_workers - 1;
+            ++m_frame;
+        }
+        m_wake.notify_all( );
+    }
+    RenderShare( 0, now );
+    if ( m_workers > 1 )
+    {
+        std::unique_lock< std::mutex > lock( m_lock );
+        m_done.wait( lock, [ this ]( ) { return !m_pending; } );
+    }
+    m_frames += m_nodes.size( );
+}
+
+bool MeshSim::Converged( )
+{
+    RadioPixel::Command want, have;
+    m_nodes[ 0 ]->player.GetCommand( &want );
+    for ( size_t i = 1; i < m_nodes.size( ); ++i )
+    {
+        if ( m_nodes[ i ]->player.GetSequence( ) != &m_nodes[ i ]->recvSequence ||
+             !m_nodes[ i ]->player.GetCommand( &have ) ||
+             memcmp( &want, &have, sizeof want ) != 0 )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+ms_t MeshSim::PhaseSpread( ms_t now )
+{
+    ms_t duration( 0 );
+    std::vector< ms_t > phases;
+    for ( size_t i = 0; i < m_nodes.size( ); ++i )
+    {
+        phases.push_back( m_nodes[ i ]->player.GetPhase( now, &m_nodes[ i ]->strip, &duration ));
+    }
+    if ( !duration )
+    {
+        return 0;
+    }
+    std::sort( phases.begin( ), phases.end( ));
+
+    // phases wrap, so the spread is the loop minus the biggest empty gap
+    ms_t gap = phases.front( ) + duration - phases.back( );
+    for ( size_t i = 1; i < phases.size( ); ++i )
+    {
+        gap = std::max( gap, phases[ i ] - phases[ i - 1 ] );
+    }
+    return duration - gap;
+}
+
+bool MeshSim::Run( )
+{
+    // worker 0's random( ) stream, the others seed theirs as they start
+    randomSeed( WorkerSeed( 0 ));
+
+    // everyone powers up idle, the controller's first command comes at once
+    for ( size_t i = 0; i < m_nodes.size( ); ++i )
+    {
+        m_nodes[ i ]->player.SetSequence( &m_nodes[ i ]->idle, 0 );
+    }
+
+    Node *controller = m_nodes[ 0 ];
+    ms_t changedAt = 0;
+    bool converged = true;
+    ms_t nextRender = 0;
+    ms_t nextSample = 0;
+
+    for ( ms_t now = 0; now < m_config.duration; ++now )
+    {
+        // controller input, like a serial command on the firmware
+        if ( now % m_config.changeMs == 0 )
+        {
+            if ( !converged )
+            {
+                ++m_unconverged;
+            }
+            RandomCommand( m_random, &controller->recvPacket );
+            controller->player.SetSequence( &controller->recvSequence, now );
+            if ( m_config.epochs )
+            {
+                controller->player.SetStepTime( now );
+            }
+            changedAt = now;
+            converged = false;
+        }
+
+        // radio
+        while ( !m_air.empty( ) && m_air.front( ).deliverAt <= now )
+        {
+            std::pop_heap( m_air.begin( ), m_air.end( ), std::greater< Packet >( ));
+            Packet packet( m_air.back( ));
+            m_air.pop_back( );
+
+            Node *node = m_nodes[ packet.to ];
+            node->recvPacket = packet.command;
+            node->player.SetSequence( &node->recvSequence, now );
+            if ( m_config.epochs )
+            {
+                // virtual clocks agree, so the epoch can be used as is
+                node->player.SetStepTime( packet.epoch );
+            }
+            ++m_delivered;
+        }
+
+        // the firmware loop, minus rendering
+        for ( size_t i = 0; i < m_nodes.size( ); ++i )
+        {
+            Node *node = m_nodes[ i ];
+            if ( node->player.UpdatePattern( now, &node->strip ))
+            {
+                node->lastTransmit = 0;
+            }
+        }
+        if ( now >= nextRender )
+        {
+            RenderAll( now );
+            nextRender = now + FRAME_MS + 1;
+        }
+        if ( ( now - controller->lastTransmit ) > m_config.transmitMs )
+        {
+            RadioPixel::Command command;
+            if ( controller->player.GetCommand( &command ))
+            {
+                Broadcast( 0, now, command, changedAt );
+            }
+            controller->lastTransmit = now;
+        }
+
+        if ( !converged && Converged( ))
+        {
+            m_convergence.push_back( now - changedAt );
+            converged = true;
+        }
+        if ( converged && now >= nextSample )
+        {
+            m_spread.push_back( PhaseSpread( now ));
+            nextSample = now + PHASE_SAMPLE_MS;
+        }
+    }
+    if ( !converged )
+    {
+        ++m_unconverged;
+    }
+    return !m_unconverged;
+}
+
+//-------------------------------------------------------------
+
+// p50, p99 and max of some samples
+static void percentiles( std::vector< ms_t > samples, std::ostream &out )
+{
+    if ( samples.empty( ))
+    {
+        out << "none";
+        return;
+    }
+    std::sort( samples.begin( ), samples.end( ));
+    out << "p50 " << samples[ samples.size( ) / 2 ]
+        << " p99 " << samples[ std::min( samples.size( ) - 1, samples.size( ) * 99 / 100 ) ]
+        << " max " << samples.back( ) << " ms";
+}
+
+std::string MeshSim::Report( ) const
+{
+    std::ostringstream out;
+    out << m_config.nodes << " nodes, " << m_config.length << " pixels, "
+        << m_config.duration / 1000.0 << " s virtual, loss " << m_config.loss * 100 << "%, latency "
+        << m_config.latency << "+" << m_config.jitter << " ms"
+        << ( m_config.epochs ? ", epochs" : "" ) << "\n";
+    out << "packets sent " << m_sent << ", delivered " << m_delivered
+        << ", frames rendered " << m_frames << "\n";
+    out << "convergence over " << m_convergence.size( ) << " commands: ";
+    percentiles( m_convergence, out );
+    out << ", never converged " << m_unconverged << "\n";
+    out << "phase spread once converged: ";
+    percentiles( m_spread, out );
+    if ( !m_spread.empty( ))
+    {
+        out << " ( " << *std::max_element( m_spread.begin( ), m_spread.end( )) / ( double )FRAME_MS
+            << " frames )";
+    }
+    out << "\n";
+    return out.str( );
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stdint.h>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Player.h"
+
+
+//! a controller's random look, the same draws for the simulator, the
+// golden runs and command storms; brightness is drawn from minBrightness up
+void RandomCommand( std::mt19937 &random, RadioPixel::Command *command, uint8_t minBrightness = 255 );
+
+// Runs many virtual nodes with the firmware's controller / follower logic
+// on a simulated broadcast radio, in virtual time. Node 0 is the
+// controller; it takes a new random command every so often, sends it at
+// once and then retransmits every TRANSMIT_MS like the firmware. Reports
+// how long the followers take to converge on each command and how far
+// apart their pattern phases are once they have.
+class MeshSim
+{
+public:
+    struct Config
+    {
+        Config( );
+
+        int nodes;
+        pixel_t length;
+        double loss; // chance each receiver misses a packet, 0 - 1
+        ms_t latency; // air time plus radio handling
+        ms_t jitter; // added uniformly, 0 - jitter
+        ms_t duration; // virtual time to run for
+        ms_t changeMs; // controller picks a new command this often
+        ms_t transmitMs; // controller retransmit interval
+        uint32_t seed;
+        int threads; // render workers, 0 for one per core
+        bool epochs; // commands carry their step start, see CommandEpoch
+    };
+
+    MeshSim( const Config &config );
+
+    ~MeshSim( );
+
+    //! run the whole simulation, returns false if some command never converged
+    bool Run( );
+
+    //! human readable results
+    std::string Report( ) const;
+
+private:
+    struct Node;
+
+    struct Packet
+    {
+        ms_t deliverAt;
+        int to;
+        RadioPixel::Command command;
+        ms_t epoch;
+
+        bool operator>( const Packet &other ) const { return deliverAt > other.deliverAt; }
+    };
+
+    void Broadcast( int from, ms_t now, const RadioPixel::Command &command, ms_t epoch );
+
+    // render every node's frame, spread over the workers
+    void RenderAll( ms_t now );
+
+    // a worker's share of the nodes, worker 0 is the thread calling Run( )
+    void RenderShare( int worker, ms_t now );
+
+    // the other workers wait here for each frame
+    void Work( int worker );
+
+    // each worker's random( ) stream, from the config's seed
+    uint32_t WorkerSeed( int worker ) const;
+
+    bool Converged( );
+
+    // spread of the pattern phases, in wall clock ms
+    ms_t PhaseSpread( ms_t now );
+
+    Config m_config;
+    std::vector< Node * > m_nodes;
+    std::vector< Packet > m_air; // heap, soonest first
+    std::mt19937 m_random;
+
+    // render workers, started once and kept for every frame
+    int m_workers;
+    std::vector< std::thread > m_pool;
+    std::mutex m_lock;
+    std::condition_variable m_wake; // a frame to render, or stop
+    std::condition_variable m_done; // the last worker finished it
+    uint64_t m_frame; // bumped for each frame handed out
+    ms_t m_renderAt;
+    int m_pending; // workers still rendering it
+    bool m_stopping;
+
+    // results
+    uint64_t m_sent;
+    uint64_t m_delivered;
+    std::vector< ms_t > m_convergence; // per command
+    int m_unconverged;
+    std::vector< ms_t > m_spread; // sampled after convergence
+    uint64_t m_frames;
+};
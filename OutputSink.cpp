@@ -0,0 +1,167 @@
+#include <QDebug>
+#ifdef Q_OS_LINUX
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+#endif
+#include "Layout.h"
+#include "OutputSink.h"
+#include "Player.h"
+
+
+// spidev rejects single transfers larger than its bufsiz module parameter
+const size_t SPIDEV_BUFSIZ = 4096;
+
+
+OutputSink::OutputSink( StripBase *strip, QObject *parent )
+    : QObject( parent ),
+      m_strip( strip )
+{
+    connect( m_strip, SIGNAL( show()),
+             this, SLOT( onShow()));
+}
+
+OutputSink *OutputSink::create( const QString &spec, StripBase *strip,
+                                PixelFormat format, QObject *parent )
+{
+    QString kind( spec.section( ':', 0, 0 ));
+    QString path( spec.section( ':', 1 ));
+
+    if ( kind == "spi" )
+    {
+        SpiSink *sink = new SpiSink( strip, parent );
+        if ( sink->open( path ))
+        {
+            return sink;
+        }
+        delete sink;
+    }
+    else if ( kind == "file" )
+    {
+        FileSink *sink = new FileSink( strip, format, parent );
+        if ( sink->open( path ))
+        {
+            return sink;
+        }
+        delete sink;
+    }
+    else if ( kind == "ring" )
+    {
+        RingSink *sink = new RingSink( strip, parent );
+        if ( sink->open( path ))
+        {
+            return sink;
+        }
+        delete sink;
+    }
+    else
+    {
+        qWarning( ) << "unknown sink" << spec;
+    }
+    return nullptr;
+}
+
+//-------------------------------------------------------------
+
+SpiSink::SpiSink( StripBase *strip, QObject *parent )
+    : OutputSink( strip, parent )
+{
+    m_encoder.reserve( strip->numPixels( ));
+}
+
+bool SpiSink::open( const QString &device )
+{
+    m_device.setFileName( device );
+    if ( !m_device.open( QIODevice::WriteOnly | QIODevice::Unbuffered ))
+    {
+        qWarning( ) << "can't open" << device << m_device.errorString( );
+        return false;
+    }
+
+#ifdef Q_OS_LINUX
+    uint32_t hz( m_encoder.spiHz( ));
+    uint8_t bits( 8 );
+    int fd( m_device.handle( ));
+    if ( ioctl( fd, SPI_IOC_WR_MAX_SPEED_HZ, &hz ) < 0 ||
+         ioctl( fd, SPI_IOC_WR_BITS_PER_WORD, &bits ) < 0 )
+    {
+        qWarning( ) << device << "is not a spidev device";
+        return false;
+    }
+#endif
+
+    // the whole frame has to go in one transfer, a gap between
+    // transfers would latch the pixels part way down the strip
+    if ( m_encoder.streamSize( m_strip->numPixels( )) > SPIDEV_BUFSIZ )
+    {
+        qWarning( ) << "frame is" << m_encoder.streamSize( m_strip->numPixels( ))
+                    << "bytes, raise spidev.bufsiz to match";
+    }
+    return true;
+}
+
+void SpiSink::onShow( )
+{
+    const uint8_t *stream( m_encoder.encode( m_strip ));
+    m_device.write( ( const char *)stream, m_encoder.size( ));
+}
+
+//-------------------------------------------------------------
+
+FileSink::FileSink( StripBase *strip, PixelFormat format, QObject *parent )
+    : OutputSink( strip, parent ),
+      m_packer( format )
+{
+    // strips laid out in 2D go out as raster frames, row after row
+    const Layout *layout( strip->getLayout( ));
+    if ( layout )
+    {
+        m_packer.setOrder( layout->grid( ), layout->width( ) * layout->height( ));
+    }
+    m_frame.resize( m_packer.packedSize( strip->numPixels( )));
+}
+
+bool FileSink::open( const QString &path )
+{
+    m_file.setFileName( path );
+    if ( !m_file.open( QIODevice::WriteOnly | QIODevice::Unbuffered ))
+    {
+        qWarning( ) << "can't open" << path << m_file.errorString( );
+        return false;
+    }
+    return true;
+}
+
+void FileSink::onShow( )
+{
+    size_t size( m_packer.pack( m_strip, ( uint8_t *)m_frame.data( ), m_frame.size( )));
+    m_file.write( m_frame.constData( ), size );
+}
+
+//-------------------------------------------------------------
+
+RingSink::RingSink( StripBase *strip, QObject *parent )
+    : OutputSink( strip, parent )
+{
+}
+
+bool RingSink::open( const QString &name )
+{
+    if ( !m_ring.create( name.toLocal8Bit( ).constData( ), m_strip->numPixels( )))
+    {
+        qWarning( ) << "can't create frame ring" << name;
+        return false;
+    }
+    return true;
+}
+
+void RingSink::onShow( )
+{
+    pixel_t count( m_strip->numPixels( ));
+    // indexed, reversed and dimmed views all expand into it
+    if ( m_scratch.size( ) < count )
+    {
+        m_scratch.resize( count );
+    }
+    const uint32_t *pixels( m_strip->getColors( 0, count, m_scratch.data( )));
+    m_ring.publish( pixels, count, millis( ), m_strip->getBrightness( ));
+}
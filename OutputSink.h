@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QFile>
+#include <QObject>
+#include <QString>
+#include <vector>
+#include "FrameRing.h"
+#include "PixelFormat.h"
+#include "Ws2812Encoder.h"
+
+
+// Writes every frame a strip shows to some hardware or file. Sinks hang
+// off the strip's show( ) signal, so the player never knows about them.
+class OutputSink : public QObject
+{
+    Q_OBJECT
+
+public:
+    OutputSink( StripBase *strip, QObject *parent = nullptr );
+
+    //! build a sink from "spi:/dev/spidev0.0", "file:/path", "ring:/name" or "none",
+    // returns nullptr for a bad spec or a device that won't open
+    static OutputSink *create( const QString &spec, StripBase *strip,
+                               PixelFormat format, QObject *parent = nullptr );
+
+protected slots:
+    virtual void onShow( ) = 0;
+
+protected:
+    StripBase *m_strip;
+};
+
+
+// WS2812 on a spidev MOSI line
+class SpiSink : public OutputSink
+{
+    Q_OBJECT
+
+public:
+    SpiSink( StripBase *strip, QObject *parent = nullptr );
+
+    bool open( const QString &device );
+
+protected slots:
+    void onShow( ) override;
+
+private:
+    QFile m_device;
+    Ws2812Encoder m_encoder;
+};
+
+
+// packed frames appended to a file or fifo, for bridges and capture,
+// raster frames of the grid for strips with a Layout
+class FileSink : public OutputSink
+{
+    Q_OBJECT
+
+public:
+    FileSink( StripBase *strip, PixelFormat format, QObject *parent = nullptr );
+
+    bool open( const QString &path );
+
+protected slots:
+    void onShow( ) override;
+
+private:
+    QFile m_file;
+    PixelPacker m_packer;
+    QByteArray m_frame;
+};
+
+
+// frames published to a shared memory FrameRing for local readers
+class RingSink : public OutputSink
+{
+    Q_OBJECT
+
+public:
+    RingSink( StripBase *strip, QObject *parent = nullptr );
+
+    bool open( const QString &name );
+
+protected slots:
+    void onShow( ) override;
+
+private:
+    FrameRing m_ring;
+    std::vector<uint32_t> m_scratch; // getColors( ) expands views into this
+};
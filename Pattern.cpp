@@ -1,9 +1,16 @@
 #include <math.h>
 #include <radiopixel_protocol.h>
 #include "Pattern.h"
+#include "PatternRegistry.h"
+#ifndef ARDUINO
+#include <string.h>
+#include "Audio.h"
+#include "Layout.h"
+#endif
 
 
 Pattern::Pattern( )
+    : m_scratch( NULL )
 {
     m_color[ 0 ] = RED;
     m_color[ 1 ] = WHITE;
@@ -22,6 +29,16 @@ void Pattern::Init( Stripper *strip, const uint32_t *colors, const uint8_t *leve
     m_level[ 1 ] = levels[ 1 ];
     m_level[ 2 ] = levels[ 2 ];
 
+    if ( strip->isIndexed( ) )
+    {
+        strip->clearPalette( );
+        for ( int i = 0; i < 3; ++i )
+        {
+            strip->setPaletteColor( i, m_color[ i ] );
+        }
+        strip->setPaletteColor( PALETTE_BLACK, BLACK );
+    }
+
     Init( strip, offset );
 }
 
@@ -29,45 +46,21 @@ void Pattern::Init( Stripper *strip, const uint32_t *colors, const uint8_t *leve
 
 Pattern *CreatePattern( uint8_t pattern )
 {
-    switch ( pattern )
-    {
-    case RadioPixel::Command::MiniTwinkle:
-        return new MiniTwinklePattern( );
-    case RadioPixel::Command::MiniSparkle:
-        return new MiniSparklePattern( );
-    case RadioPixel::Command::Sparkle:
-        return new SparklePattern( );
-    case RadioPixel::Command::Rainbow:
-        return new RainbowPattern( );
-    case RadioPixel::Command::Flash:
-        return new FlashPattern( );
-    case RadioPixel::Command::March:
-        return new MarchPattern( );
-    case RadioPixel::Command::Wipe:
-        return new WipePattern( );
-    case RadioPixel::Command::Gradient:
-        return new GradientPattern( );
-    case RadioPixel::Command::Fixed:
-        return new FixedPattern( );
-    case RadioPixel::Command::Strobe:
-        return new StrobePattern( );
-    case RadioPixel::Command::CandyCane:
-        return new CandyCanePattern( );
-    default:
-        return new DiagnosticPattern( 1 );
-    }
+    Pattern *created( Patterns::Create( pattern ));
+    return created ? created : new DiagnosticPattern( 1 );
 }
 
-//-------------------------------------------------------------
-
-ms_t FlashPattern::GetDuration( Stripper *strip )
+Pattern *CreatePattern( uint8_t pattern, PatternStorage *storage )
 {
-    return 4000;
+    Pattern *created( Patterns::Create( pattern, storage ));
+    return created ? created : new ( storage ) DiagnosticPattern( 1 );
 }
 
+//-------------------------------------------------------------
+
 void FlashPattern::Update( Stripper *strip, ms_t offset )
 {
-    uint16_t t = offset * 300 / GetDuration( strip );
+    uint16_t t = offset * 300 / DURATION;
     uint16_t o = t % 100;
     uint32_t col = color( t / 100 );
     if ( ( o >= 0 && o <= 10 ) || ( o >= 20 && o <= 30 ) )
@@ -87,38 +80,66 @@ void FlashPattern::Update( Stripper *strip, ms_t offset )
 
 //-------------------------------------------------------------
 
-ms_t RainbowPattern::GetDuration( Stripper *strip )
-{
-    return 2000;
-}
-
 void RainbowPattern::Update( Stripper *strip, ms_t offset )
 {
-    for ( int i = 0; i < strip->numPixels( ); i++ ) 
+    for ( pixel_t i = 0; i < strip->numPixels( ); i++ ) 
     {
-        uint8_t t = 255 - offset * 255 / GetDuration( strip );
-        uint8_t p = i * 255 / strip->numPixels( );
+        uint8_t t = 255 - offset * 255 / DURATION;
+        uint8_t p = ( uint64_t )i * 255 / strip->numPixels( );
         strip->setPixelColor( i, strip->ColorWheel( ( p + t ) % 255 ) );
     }
 }
 
 //-------------------------------------------------------------
 
-ms_t SparklePattern::GetDuration( Stripper *strip )
+SparklePattern::SparklePattern( )
+    : m_lit( NULL ), m_litCount( 0 ), m_litSize( 0 )
+{
+}
+
+SparklePattern::~SparklePattern( )
+{
+    Release( m_lit );
+}
+
+void SparklePattern::Init( Stripper *strip, ms_t offset )
+{
+    // whatever the last pattern left behind, then only our own pixels
+    strip->setAllColor( 0 );
+
+    Release( m_lit );
+    size_t used( 0 );
+    m_litSize = fade( 1, strip->numPixels( ), m_level[ 0 ] );
+    m_lit = Claim< pixel_t >( m_litSize, &used );
+    m_litCount = 0;
+
+    Loop( strip, offset );
+}
+
+void SparklePattern::Clear( Stripper *strip )
 {
-    return 100;
+    for ( pixel_t i = 0; i < m_litCount; ++i )
+    {
+        strip->setPixelColor( m_lit[ i ], 0 );
+    }
+    m_litCount = 0;
 }
 
 void SparklePattern::Loop( Stripper *strip, ms_t offset )
 {
     // strobe - new pixels each loop
-    strip->setAllColor( 0 );
+    Clear( strip );
     for ( int c = fade( 1, strip->numPixels( ), m_level[ 0 ] ); c; c-- )
     {
         uint32_t col = color( random( 3 ) );
         if ( col == 0 )
             col = strip->ColorRandom( );
-        strip->setPixelColor( random( strip->numPixels( ) ), col );
+        pixel_t pixel = random( strip->numPixels( ) );
+        strip->setPixelColor( pixel, col );
+        if ( m_litCount < m_litSize )
+        {
+            m_lit[ m_litCount++ ] = pixel;
+        }
     }
 
     Update( strip, offset );
@@ -129,63 +150,179 @@ void SparklePattern::Loop( Stripper *strip, ms_t offset )
 void MiniSparklePattern::Update( Stripper *strip, ms_t offset )
 {
     // 25% duty cycle
-    if ( offset > GetDuration( strip ) / 4 )
+    if ( offset > DURATION / 4 )
     {
-        strip->setAllColor( 0 );
+        Clear( strip );
     }
 }
 
 //-------------------------------------------------------------
 
+// a pixel fades out within about three loops at the usual frame rates,
+// so the list starts with room for four loops of new pixels and grows
+// if slower frames keep them lit for longer
+const uint8_t TWINKLE_LOOPS = 4;
+
 MiniTwinklePattern::MiniTwinklePattern()
+    : m_lit( NULL ), m_litCount( 0 ), m_litSize( 0 )
+#ifndef ARDUINO
+    , m_slot( NULL )
+#endif
 {
 }
 
-void MiniTwinklePattern::Init( Stripper *strip, ms_t offset )
+MiniTwinklePattern::~MiniTwinklePattern()
 {
-    m_lastDim = m_lastLit = offset;
-    Loop( strip, offset );
+    Release( m_lit );
+#ifndef ARDUINO
+    Release( m_slot );
+#endif
 }
 
-ms_t MiniTwinklePattern::GetDuration( Stripper *strip )
+void MiniTwinklePattern::Init( Stripper *strip, ms_t offset )
 {
-    return 1000;
+    m_lastDim = m_lastLit = offset;
+
+    Release( m_lit );
+    size_t used( 0 );
+    uint32_t most( fade( 1, strip->numPixels( ), m_level[ 0 ] ) * TWINKLE_LOOPS );
+    m_litSize = ( most < strip->numPixels( ) && !m_scratch ) ? most : strip->numPixels( );
+    m_lit = Claim< Lit >( m_litSize, &used );
+    m_litSize = m_lit ? m_litSize : 0;
+    m_litCount = 0;
+#ifndef ARDUINO
+    Release( m_slot );
+    m_slot = Claim< pixel_t >( strip->numPixels( ), &used );
+    memset( m_slot, 0, strip->numPixels( ) * sizeof( pixel_t ) );
+#endif
+
+    // track whatever the last pattern left lit so it fades out as before
+    for ( pixel_t i = 0; i < strip->numPixels( ); ++i )
+    {
+        uint32_t col = strip->getPixelColor( i );
+        if ( ( col & 0xffffff ) && !Light( strip, i, col ) )
+        {
+            strip->setPixelColor( i, 0 );
+        }
+    }
+
+    Loop( strip, offset );
 }
 
 void MiniTwinklePattern::Update( Stripper *strip, ms_t offset )
 {
-    int duration( GetDuration( strip ) );
+    int duration( DURATION );
 
     // dim down all pixels
     ms_t dimDelta( delta( m_lastDim, offset, duration ) );
     int dim( 255 - ( dimDelta * 255 / duration ) );
     if ( dim < 255 )
     {
-        for ( int i = 0; i < strip->numPixels( ); ++i )
+        for ( pixel_t n = 0; n < m_litCount; )
         {
-            uint32_t col = strip->getPixelColor( i );
-            col = strip->ColorFade( col, dim );
-            strip->setPixelColor( i, col );
+            Lit &lit( m_lit[ n ] );
+            lit.color = strip->ColorFade( lit.color, dim );
+            strip->setPixelColor( lit.pixel, lit.color );
+            if ( lit.color & 0xffffff )
+            {
+                ++n;
+            }
+            else
+            {
+                Unlight( n );
+            }
         }
         m_lastDim = offset;
     }
     
     // add any new pixels as needed
-    long total( fade( 1, strip->numPixels( ), m_level[ 0 ] ) );
+    uint64_t total( fade( 1, strip->numPixels( ), m_level[ 0 ] ) );
     ms_t litDelta( delta( m_lastLit, offset, duration ) );
-    long todo( litDelta * total / duration );
+    uint64_t todo( litDelta * total / duration );
     if ( todo > 0 )
     {
         for ( ; todo > 0; todo-- )
         {
-            int i = random( strip->numPixels( ) );
+            pixel_t i = random( strip->numPixels( ) );
             uint32_t col( color( random( 3 ) ) );
-            strip->setPixelColor( i, col );
+            Light( strip, i, col );
         }
         m_lastLit = offset; // only update if we lit something!
     }
 }
 
+bool MiniTwinklePattern::Light( Stripper *strip, pixel_t pixel, uint32_t color )
+{
+    pixel_t index( Find( pixel ) );
+    if ( index == m_litCount )
+    {
+        if ( m_litCount == m_litSize && !Grow( strip->numPixels( ) ) )
+        {
+            return false;
+        }
+        m_lit[ index ].pixel = pixel;
+        ++m_litCount;
+#ifndef ARDUINO
+        m_slot[ pixel ] = m_litCount;
+#endif
+    }
+    m_lit[ index ].color = color;
+    strip->setPixelColor( pixel, color );
+    return true;
+}
+
+bool MiniTwinklePattern::Grow( pixel_t most )
+{
+    // the scratch already has room for every pixel
+    if ( m_scratch || m_litSize >= most )
+    {
+        return false;
+    }
+    pixel_t size( ( m_litSize && m_litSize < most / 2 ) ? m_litSize * 2 : most );
+    Lit *lit( new Lit[ size ] );
+    if ( !lit )
+    {
+        return false;
+    }
+    for ( pixel_t i = 0; i < m_litCount; ++i )
+    {
+        lit[ i ] = m_lit[ i ];
+    }
+    delete [] m_lit;
+    m_lit = lit;
+    m_litSize = size;
+    return true;
+}
+
+void MiniTwinklePattern::Unlight( pixel_t index )
+{
+#ifndef ARDUINO
+    m_slot[ m_lit[ index ].pixel ] = 0;
+#endif
+    if ( index != --m_litCount )
+    {
+        m_lit[ index ] = m_lit[ m_litCount ];
+#ifndef ARDUINO
+        m_slot[ m_lit[ index ].pixel ] = index + 1;
+#endif
+    }
+}
+
+pixel_t MiniTwinklePattern::Find( pixel_t pixel ) const
+{
+#ifndef ARDUINO
+    return m_slot[ pixel ] ? m_slot[ pixel ] - 1 : m_litCount;
+#else
+    // the list is short on the node, scanning it beats a per pixel map
+    pixel_t index( 0 );
+    while ( index < m_litCount && m_lit[ index ].pixel != pixel )
+    {
+        ++index;
+    }
+    return index;
+#endif
+}
+
 ms_t MiniTwinklePattern::delta( ms_t previous, ms_t next, ms_t duration )
 {
     if ( next >= previous )
@@ -200,9 +337,24 @@ ms_t MiniTwinklePattern::delta( ms_t previous, ms_t next, ms_t duration )
 
 //-------------------------------------------------------------
 
-ms_t MarchPattern::GetDuration( Stripper *strip )
+// each segment color at every fade step Update can produce
+const uint8_t MARCH_FADES = 64;
+
+void MarchPattern::Init( Stripper *strip, ms_t offset )
 {
-    return 1000;
+    if ( strip->isIndexed( ) )
+    {
+        uint8_t length = SegmentLength( );
+        for ( int c = 0; c < 3; ++c )
+        {
+            for ( int e = 0; e < MARCH_FADES; ++e )
+            {
+                uint8_t f = e * 255 / ( length / 2 );
+                strip->setPaletteColor( PALETTE_SIZE + c * MARCH_FADES + e, strip->ColorFade( color( c ), f ) );
+            }
+        }
+    }
+    Pattern::Init( strip, offset );
 }
 
 void MarchPattern::Update( Stripper *strip, ms_t offset )
@@ -210,19 +362,20 @@ void MarchPattern::Update( Stripper *strip, ms_t offset )
     // a segment is one color, there are three segments in a loop
 
     // duration of a loop
-    uint32_t duration = GetDuration( strip );
+    uint32_t duration = DURATION;
+    uint32_t length = SegmentLength( );
     // how far are we through all three segments
-    uint32_t o = ( m_level[ 0 ] * 3 ) - ( offset * m_level[ 0 ] * 3 / duration );
+    uint32_t o = ( length * 3 ) - ( offset * length * 3 / duration );
     
-    for ( int i = 0; i < strip->numPixels( ); i++ ) 
+    for ( pixel_t i = 0; i < strip->numPixels( ); i++ ) 
     {
         // fade level based on position within segment
-        uint32_t e = ( i + o ) % m_level[ 0 ];
-        if ( e > ( m_level[ 0 ] / 2 ) )
+        uint32_t e = ( i + o ) % length;
+        if ( e > ( length / 2 ) )
         {
-            e = m_level[ 0 ] - e;
+            e = length - e;
         }
-        if ( e > ( m_level[ 0 ] / 4 ) )
+        if ( e > ( length / 4 ) )
         {
             e = e / 2;
         }
@@ -230,10 +383,17 @@ void MarchPattern::Update( Stripper *strip, ms_t offset )
         {
             e = 0;
         }
-        uint8_t f = e * 255 / ( m_level[ 0 ] / 2 );
-
         // color based on segment
-        uint32_t c = color( ( ( i + o ) / m_level[ 0 ] ) % 3 );
+        int segment = ( ( i + o ) / length ) % 3;
+        if ( strip->isIndexed( ) )
+        {
+            // e is at most a quarter of a segment
+            strip->setPixelIndex( i, PALETTE_SIZE + segment * MARCH_FADES + e );
+            continue;
+        }
+
+        uint8_t f = e * 255 / ( length / 2 );
+        uint32_t c = color( segment );
 
         strip->setPixelColor( i, strip->ColorFade( c, f ) );
     }
@@ -241,23 +401,19 @@ void MarchPattern::Update( Stripper *strip, ms_t offset )
 
 //-------------------------------------------------------------
 
-ms_t WipePattern::GetDuration( Stripper *strip )
-{
-    return 3000;
-}
-
 void WipePattern::Update( Stripper *strip, ms_t offset )
 {
-    for ( int i = 0; i < strip->numPixels( ); i++ )
+    for ( pixel_t i = 0; i < strip->numPixels( ); i++ )
     {
-        int d = GetDuration( strip );
-        int t = offset * ( strip->numPixels( ) * 3 ) / d;
-        t = ( strip->numPixels( ) * 3 ) - t; // offset due to time
-        int c = ( i + t ) / strip->numPixels( );
-        int e = ( i + t ) % strip->numPixels( );
+        // 64 bit, offset * pixels overflows on long strips
+        uint64_t d = DURATION;
+        uint64_t t = offset * ( ( uint64_t )strip->numPixels( ) * 3 ) / d;
+        t = ( ( uint64_t )strip->numPixels( ) * 3 ) - t; // offset due to time
+        uint64_t c = ( i + t ) / strip->numPixels( );
+        uint64_t e = ( i + t ) % strip->numPixels( );
         uint8_t f = e * 255 / strip->numPixels( );
         f = ( f < 128 ) ? 0 : ( ( f - 128 ) * 2 );
-        strip->setPixelColor( i, strip->ColorFade( color( c ), f ) );
+        strip->setPixelColor( i, strip->ColorFade( color( ( int )c ), f ) );
     }
 }
 
@@ -271,11 +427,6 @@ GradientPattern::GradientPattern( )
     mp1 = mp2 = NULL;
 }
 
-ms_t GradientPattern::GetDuration( Stripper *strip )
-{
-    return 1000;
-}
-
 void GradientPattern::Init( Stripper *strip, ms_t offset )
 {
     // setup gradient
@@ -298,11 +449,14 @@ void GradientPattern::Init( Stripper *strip, ms_t offset )
     }
 
     // setup maps
-    mp1 = new uint8_t[ strip->numPixels( ) ];
-    mp2 = new uint8_t[ strip->numPixels( ) ];
+    Release( mp1 );
+    Release( mp2 );
+    size_t used( 0 );
+    mp1 = Claim< pixel_t >( strip->numPixels( ), &used );
+    mp2 = Claim< pixel_t >( strip->numPixels( ), &used );
     if ( mp1 && mp2 )
     {
-        for ( int i = 0; i < strip->numPixels( ); i++ )
+        for ( pixel_t i = 0; i < strip->numPixels( ); i++ )
         {
             mp1[ i ] = mp2[ i ] = i;
         }
@@ -315,7 +469,7 @@ void GradientPattern::Loop( Stripper *strip, ms_t offset )
     // create a new random map
     if ( mp1 && mp2 )
     {
-        for ( int i = 0; i < strip->numPixels( ); i++ )
+        for ( pixel_t i = 0; i < strip->numPixels( ); i++ )
         {
             mp1[ i ] = mp2[ i ];
             mp2[ i ] = random( strip->numPixels( ) );
@@ -326,36 +480,29 @@ void GradientPattern::Loop( Stripper *strip, ms_t offset )
 
 void GradientPattern::Update( Stripper *strip, ms_t offset )
 {
-    for ( int i = 0; i < strip->numPixels( ); i++ )
+    for ( pixel_t i = 0; i < strip->numPixels( ); i++ )
     {
         uint32_t c1 = 0xff0000, c2 = 0xff0000;
         if ( mp1 && mp2 )
         {
-            c1 = grad.getColor( ( int )mp1[ i ] * 255 / strip->numPixels( ) );
-            c2 = grad.getColor( ( int )mp2[ i ] * 255 / strip->numPixels( ) );
+            c1 = grad.getColor( ( uint64_t )mp1[ i ] * 255 / strip->numPixels( ) );
+            c2 = grad.getColor( ( uint64_t )mp2[ i ] * 255 / strip->numPixels( ) );
         }
-        strip->setPixelColor( i, Stripper::ColorBlend( c1, c2, offset * 255 / GetDuration( strip ) ) );
+        strip->setPixelColor( i, Stripper::ColorBlend( c1, c2, offset * 255 / DURATION ) );
     }
 }
 
 GradientPattern::~GradientPattern( )
 {
-    delete [] mp1;
-    mp1 = NULL;
-    delete [] mp2;
-    mp2 = NULL;
+    Release( mp1 );
+    Release( mp2 );
 }
 
 //-------------------------------------------------------------
 
-ms_t StrobePattern::GetDuration( Stripper *strip )
-{
-    return 750; // 4Hz at 100% spped, 10Hz at 250% speed
-}
-
 void StrobePattern::Update( Stripper *strip, ms_t offset )
 {
-    ms_t third( GetDuration( strip ) / 3 );
+    ms_t third( DURATION / 3 );
     if ( ( offset / third ) != ( m_lastOffset / third ) )
     {
         strip->setAllColor( color( offset / third ) );
@@ -369,34 +516,39 @@ void StrobePattern::Update( Stripper *strip, ms_t offset )
 
 //-------------------------------------------------------------
 
-ms_t CandyCanePattern::GetDuration( Stripper *strip )
-{
-    return 200;
-}
-
 void CandyCanePattern::Update( Stripper *strip, ms_t offset )
 {
     int c = 0;
-    if ( offset < ( GetDuration( strip ) / 2 ) )
+    if ( offset < ( DURATION / 2 ) )
         c = 1;
-    for ( int i = 0; i < strip->numPixels( ); i++ )
+    if ( strip->isIndexed( ) )
+    {
+        for ( pixel_t i = 0; i < strip->numPixels( ); i++ )
+        {
+            strip->setPixelIndex( i, c + ( i % 2 ) );
+        }
+        return;
+    }
+    for ( pixel_t i = 0; i < strip->numPixels( ); i++ )
     {
         strip->setPixelColor( i, color( c + ( i % 2 ) ) );
     }
 }
 
-//-------------------------------------------------------------
-
-ms_t TestPattern::GetDuration( Stripper *strip )
+ms_t CandyCanePattern::GetNextChange( Stripper *strip, ms_t offset )
 {
-    return 1000;
+    // flips half way through and again at the loop
+    ms_t half( DURATION / 2 );
+    return ( offset < half ) ? half - offset : DURATION - offset;
 }
 
+//-------------------------------------------------------------
+
 void TestPattern::Update( Stripper *strip, ms_t offset )
 {
 /*  
     // test intensity scale
-    for ( int i = 0; i < strip->numPixels( ); i++ )
+    for ( pixel_t i = 0; i < strip->numPixels( ); i++ )
     {
         uint8_t f = i * 255 / strip->numPixels( );
         strip->setPixelColor( i, strip->ColorFade( 0xffffff, f ) );
@@ -410,38 +562,230 @@ void TestPattern::Update( Stripper *strip, ms_t offset )
     grad.addStep( 85, m_color[ 1 ] );
     grad.addStep( 170, m_color[ 2 ] );
     grad.addStep( 255, m_color[ 0 ] );
-    for ( int i = 0; i < strip->numPixels( ); i++ )
+    if ( strip->isIndexed( ) )
+    {
+        // the whole gradient is the palette
+        for ( int pos = 0; pos < 256; ++pos )
+        {
+            strip->setPaletteColor( pos, grad.getColor( pos ) );
+        }
+        for ( pixel_t i = 0; i < strip->numPixels( ); i++ )
+        {
+            strip->setPixelIndex( i, ( uint64_t )i * 255 / strip->numPixels( ) );
+        }
+        return;
+    }
+    for ( pixel_t i = 0; i < strip->numPixels( ); i++ )
     {
-        strip->setPixelColor( i, grad.getColor( i * 255 / strip->numPixels( ) ) );
+        strip->setPixelColor( i, grad.getColor( ( uint64_t )i * 255 / strip->numPixels( ) ) );
     }
 }
 
 //-------------------------------------------------------------
 
-ms_t FixedPattern::GetDuration( Stripper *strip )
-{
-    return 750;
-}
-
 void FixedPattern::Update( Stripper *strip, ms_t offset )
 {
-    int step = 3 * offset / GetDuration( strip );
+    pixel_t step = 3 * offset / DURATION;
+    if ( strip->isIndexed( ) )
+    {
+        for ( pixel_t i = 0; i < strip->numPixels( ); i++ )
+        {
+            strip->setPixelIndex( i, ( i % 3 == step ) ? step % 3 : PALETTE_BLACK );
+        }
+        return;
+    }
     uint32_t col( color( step ) );
-    for ( int i = 0; i < strip->numPixels( ); i++ )
+    for ( pixel_t i = 0; i < strip->numPixels( ); i++ )
     {
         strip->setPixelColor( i, ( i % 3 == step ) ? col : 0 );
     }
 }
 
+ms_t FixedPattern::GetNextChange( Stripper *strip, ms_t offset )
+{
+    // first offset of the next third, the last third runs to the loop
+    ms_t duration( DURATION );
+    ms_t step( 3 * offset / duration );
+    ms_t next( ( ( step + 1 ) * duration + 2 ) / 3 );
+    return ( ( next < duration ) ? next : duration ) - offset;
+}
+
 //-------------------------------------------------------------
 
 void DiagnosticPattern::Update( Stripper *strip, ms_t offset )
 {
-    const int space = 3;
-    for ( int i = 0; i < strip->numPixels( ); i++ )
+    const pixel_t space = 3;
+    for ( pixel_t i = 0; i < strip->numPixels( ); i++ )
     {
-        bool on( ( i % ( m_code + space ) ) < m_code );
+        bool on( ( i % ( m_code + space ) ) < ( pixel_t )m_code );
         strip->setPixelColor( i, on ? WHITE : BLACK );
     }
 }
 
+
+#ifndef ARDUINO
+//-------------------------------------------------------------
+
+LayoutPattern::LayoutPattern( )
+    : m_line( NULL )
+{
+}
+
+LayoutPattern::~LayoutPattern( )
+{
+    delete m_line;
+}
+
+const Layout *LayoutPattern::GetLayout( Stripper *strip )
+{
+    const Layout *layout( strip->getLayout( ));
+    if ( layout && layout->count( ) >= strip->numPixels( ))
+    {
+        return layout;
+    }
+    if ( !m_line || m_line->count( ) != strip->numPixels( ))
+    {
+        delete m_line;
+        m_line = Layout::line( strip->numPixels( ) ? strip->numPixels( ) : 1 );
+    }
+    return m_line;
+}
+
+//-------------------------------------------------------------
+
+// sin( i / 256 turn ) as 0 - 255
+struct Sin8Table
+{
+    Sin8Table( )
+    {
+        for ( int t = 0; t < 256; ++t )
+        {
+            values[ t ] = 128 + ( int )( 127 * sin( t * 2 * M_PI / 256 ));
+        }
+    }
+
+    uint8_t values[ 256 ];
+};
+
+static uint8_t sin8( uint8_t i )
+{
+    static const Sin8Table table;
+    return table.values[ i ];
+}
+
+void RadialRainbowPattern::Update( Stripper *strip, ms_t offset )
+{
+    const Layout *layout( GetLayout( strip ));
+    const uint8_t *radius( layout->radius( ));
+    const uint8_t *angle( layout->angle( ));
+    uint8_t t = 255 - offset * 255 / DURATION;
+    for ( pixel_t i = 0; i < strip->numPixels( ); i++ )
+    {
+        uint8_t p = radius[ i ] + ( angle[ i ] * m_level[ 0 ] >> 8 );
+        strip->setPixelColor( i, strip->ColorWheel( ( uint8_t )( p + t ) % 255 ) );
+    }
+}
+
+//-------------------------------------------------------------
+
+void PlasmaPattern::Init( Stripper *strip, ms_t offset )
+{
+    Gradient grad;
+    grad.addStep( 0, m_color[ 0 ] );
+    grad.addStep( 85, m_color[ 1 ] );
+    grad.addStep( 170, m_color[ 2 ] );
+    grad.addStep( 255, m_color[ 0 ] );
+    for ( int i = 0; i < 256; ++i )
+    {
+        m_colors[ i ] = grad.getColor( i );
+    }
+    Update( strip, offset );
+}
+
+void PlasmaPattern::Update( Stripper *strip, ms_t offset )
+{
+    const Layout *layout( GetLayout( strip ));
+    const uint8_t *u( layout->u( ));
+    const uint8_t *v( layout->v( ));
+    const uint8_t *radius( layout->radius( ));
+
+    // whole turns of every term per loop, so it loops without a seam
+    uint8_t t = offset * 256 / DURATION;
+    for ( pixel_t i = 0; i < strip->numPixels( ); i++ )
+    {
+        int sum = sin8( u[ i ] + t ) + sin8( v[ i ] - 2 * t ) +
+            sin8( ( ( u[ i ] + v[ i ] ) >> 1 ) + 3 * t ) + sin8( radius[ i ] - t );
+        strip->setPixelColor( i, m_colors[ sum >> 2 ] );
+    }
+}
+
+//-------------------------------------------------------------
+
+// the strip's newest audio, silence without any
+static AudioFrame Listen( Stripper *strip )
+{
+    const AudioAnalyzer *audio( strip->getAudio( ));
+    if ( audio )
+    {
+        return audio->snapshot( );
+    }
+    AudioFrame silence;
+    memset( &silence, 0, sizeof silence );
+    return silence;
+}
+
+void SpectrumPattern::Init( Stripper *strip, ms_t offset )
+{
+    Gradient grad;
+    grad.addStep( 0, m_color[ 0 ] );
+    grad.addStep( 255, m_color[ 1 ] );
+    for ( int i = 0; i < 256; ++i )
+    {
+        m_colors[ i ] = grad.getColor( i );
+    }
+    Update( strip, offset );
+}
+
+void SpectrumPattern::Update( Stripper *strip, ms_t offset )
+{
+    AudioFrame frame( Listen( strip ));
+    int heights[ AUDIO_BANDS ];
+    for ( int band = 0; band < AUDIO_BANDS; ++band )
+    {
+        int height( frame.bands[ band ] * m_level[ 0 ] / 0x80 );
+        heights[ band ] = ( height < 256 ) ? height : 256;
+    }
+
+    const Layout *layout( GetLayout( strip ));
+    const uint8_t *u( layout->u( ));
+    const uint8_t *v( layout->v( ));
+    bool tall( layout->height( ) > 1 );
+    for ( pixel_t i = 0; i < strip->numPixels( ); i++ )
+    {
+        int band( u[ i ] * AUDIO_BANDS >> 8 );
+        int position( tall ? 255 - v[ i ] : ( u[ i ] * AUDIO_BANDS ) & 255 );
+        strip->setPixelColor( i, ( position < heights[ band ] ) ?
+                              m_colors[ band * 255 / ( AUDIO_BANDS - 1 ) ] : 0 );
+    }
+}
+
+ms_t SpectrumPattern::GetNextChange( Stripper *strip, ms_t offset )
+{
+    return strip->getAudio( ) ? 0 : STATIC_MS;
+}
+
+//-------------------------------------------------------------
+
+void BeatPattern::Update( Stripper *strip, ms_t offset )
+{
+    AudioFrame frame( Listen( strip ));
+    uint8_t flash( frame.pulse( m_level[ 1 ] * 4 ));
+    uint8_t glow( frame.level / 4 );
+    strip->setAllColor( Stripper::ColorFade( color( frame.beats ), ( flash > glow ) ? flash : glow ));
+}
+
+ms_t BeatPattern::GetNextChange( Stripper *strip, ms_t offset )
+{
+    return strip->getAudio( ) ? 0 : STATIC_MS;
+}
+#endif
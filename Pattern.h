@@ -6,16 +6,42 @@
 
 typedef uint32_t ms_t; // duration in milliseconds
 
+const ms_t STATIC_MS = 0xffffffff; // output only changes with new parameters
 
+// palette every pattern starts with on an indexed strip, m_color then black
+const uint8_t PALETTE_BLACK = 3;
+const uint8_t PALETTE_SIZE = 4;
+
+
+// Every pattern class states these at compile time, hiding the ones it
+// differs on, so PatternRegistry.h can look them up by id
 class Pattern
 {
 public:
+    // loop length, time offset never goes above this
+    static const ms_t DURATION = 40;
+
+    // frames build on earlier ones or on random draws, so a frame can't be
+    // drawn again from its offset alone
+    static const bool STATEFUL = false;
+
+    // a pixel only depends on its index, the strip and the offset, so any
+    // span of the strip could be drawn on its own
+    static const bool TILE_SAFE = true;
+
+    // GetNextChange can say the output holds still for a while; Player
+    // doesn't ask patterns that change every frame
+    static const bool STATIC_BETWEEN_CHANGES = false;
+
+    // bytes Init claims per pixel, at most, see Claim
+    static const uint8_t SCRATCH_PER_PIXEL = 0;
+
     Pattern( );
 
     virtual ~Pattern() {}
     
     // returns loop duration, time offset never goes above this
-    virtual ms_t GetDuration( Stripper *strip ) { return 40; }
+    virtual ms_t GetDuration( Stripper *strip ) { return DURATION; }
 
     // assume nothing, setup all pixels
     virtual void Init( Stripper *strip, const uint32_t *colors, const uint8_t *levels, ms_t offset );
@@ -29,6 +55,13 @@ public:
     // update pixels as needed
     virtual void Update( Stripper *strip, ms_t offset ) { }
 
+    // returns pattern time from offset until the output changes, 0 if it
+    // changes every frame or STATIC_MS if it never will
+    virtual ms_t GetNextChange( Stripper *strip, ms_t offset ) { return 0; }
+
+    // true if Update writes palette indices when the strip is indexed
+    virtual bool CanIndex( ) const { return false; }
+
     // returns color
     uint32_t color( int index ) const
     {
@@ -41,13 +74,42 @@ public:
         return m_level[ index % 3 ];
     }
 
+    //! take per pixel buffers from scratch, which holds the class's
+    // SCRATCH_PER_PIXEL bytes a pixel, instead of the heap. Not owned.
+    void SetScratch( uint8_t *scratch ) { m_scratch = scratch; }
+
 protected:
+    // count Ts for Init, from the scratch past the used bytes so far or
+    // else the heap. Give them back with Release before claiming again.
+    template< class T >
+    T *Claim( pixel_t count, size_t *used )
+    {
+        if ( !m_scratch )
+        {
+            return new T[ count ];
+        }
+        size_t at( ( *used + alignof( T ) - 1 ) / alignof( T ) * alignof( T ) );
+        *used = at + count * sizeof( T );
+        return ( T *)( m_scratch + at );
+    }
+
+    template< class T >
+    void Release( T *&buffer )
+    {
+        if ( !m_scratch )
+        {
+            delete [] buffer;
+        }
+        buffer = NULL;
+    }
+
     uint32_t m_color[ 3 ];
     uint8_t m_level[ 3 ];
+    uint8_t *m_scratch;
 };
 
 
-// Pattern factory
+// Pattern factory, PatternRegistry.h has which class plays each id
 Pattern *CreatePattern( uint8_t pattern );
 
 
@@ -55,8 +117,10 @@ Pattern *CreatePattern( uint8_t pattern );
 class FlashPattern : public Pattern
 {
 public:
+    static const ms_t DURATION = 4000;
+
     // returns loop duration, time offset never goes above this
-    virtual ms_t GetDuration( Stripper *strip );
+    virtual ms_t GetDuration( Stripper *strip ) { return DURATION; }
 
     // update pixels as needed
     virtual void Update( Stripper *strip, ms_t offset );
@@ -66,8 +130,10 @@ public:
 class RainbowPattern : public Pattern
 {
 public:
+    static const ms_t DURATION = 2000;
+
     // returns loop duration, time offset never goes above this
-    virtual ms_t GetDuration( Stripper *strip );
+    virtual ms_t GetDuration( Stripper *strip ) { return DURATION; }
 
     // update pixels as needed
     virtual void Update( Stripper *strip, ms_t offset );
@@ -76,11 +142,31 @@ public:
 class SparklePattern : public Pattern
 {
 public:
+    static const ms_t DURATION = 100;
+    static const bool STATEFUL = true;
+    static const bool TILE_SAFE = false;
+    static const uint8_t SCRATCH_PER_PIXEL = sizeof( pixel_t );
+
+    SparklePattern( );
+
+    ~SparklePattern( );
+
     // returns loop duration, time offset never goes above this
-    virtual ms_t GetDuration( Stripper *strip );
+    virtual ms_t GetDuration( Stripper *strip ) { return DURATION; }
+
+    // assume nothing, setup all pixels
+    virtual void Init( Stripper *strip, ms_t offset );
 
     // update pixels as needed
     virtual void Loop( Stripper *strip, ms_t offset );
+
+protected:
+    // turn off only the pixels lit by the last loop
+    void Clear( Stripper *strip );
+
+    pixel_t *m_lit;
+    pixel_t m_litCount;
+    pixel_t m_litSize;
 };
 
 class MiniSparklePattern : public SparklePattern
@@ -93,13 +179,21 @@ public:
 class MiniTwinklePattern : public Pattern
 {
 public:
+    static const ms_t DURATION = 1000;
+    static const bool STATEFUL = true;
+    static const bool TILE_SAFE = false;
+    // the lit list, and on the desk the slot map
+    static const uint8_t SCRATCH_PER_PIXEL = sizeof( pixel_t ) * 2 + sizeof( uint32_t );
+
     MiniTwinklePattern();
+
+    ~MiniTwinklePattern();
     
     // assume nothing, setup all pixels
     virtual void Init( Stripper *strip, ms_t offset );
 
     // returns loop duration, time offset never goes above this
-    virtual ms_t GetDuration( Stripper *strip );
+    virtual ms_t GetDuration( Stripper *strip ) { return DURATION; }
     
     // update pixels as needed
     virtual void Update( Stripper *strip, ms_t offset );
@@ -107,25 +201,66 @@ public:
 protected:
     ms_t delta( ms_t previous, ms_t next, ms_t duration );
 
+    // start or restart a pixel at full color, false only if there was no
+    // memory to track another and the pixel was left alone
+    bool Light( Stripper *strip, pixel_t pixel, uint32_t color );
+
+    // make room in m_lit for more pixels, up to most
+    bool Grow( pixel_t most );
+
+    // forget the lit entry at index, the last entry takes its place
+    void Unlight( pixel_t index );
+
+    // index into m_lit of a pixel, m_litCount if it's dark
+    pixel_t Find( pixel_t pixel ) const;
+
     ms_t m_lastDim;
     ms_t m_lastLit;
+
+    // pixels still fading, so the work follows the lit count, not the
+    // strip, and the room for them follows the level until it grows
+    struct Lit
+    {
+        pixel_t pixel;
+        uint32_t color;
+    };
+    Lit *m_lit;
+    pixel_t m_litCount;
+    pixel_t m_litSize;
+#ifndef ARDUINO
+    pixel_t *m_slot; // per pixel, 1 + index into m_lit or 0 if dark
+#endif
 };
 
 class MarchPattern : public Pattern
 {
 public:
+    static const ms_t DURATION = 1000;
+
     // returns loop duration, time offset never goes above this
-    virtual ms_t GetDuration( Stripper *strip );
+    virtual ms_t GetDuration( Stripper *strip ) { return DURATION; }
+
+    // assume nothing, setup all pixels
+    virtual void Init( Stripper *strip, ms_t offset );
     
     // update pixels as needed
     virtual void Update( Stripper *strip, ms_t offset );
+
+    // writes palette indices on indexed strips
+    virtual bool CanIndex( ) const { return true; }
+
+private:
+    // pixels in a segment, level 0, but never less than the 2 the fades divide by
+    uint8_t SegmentLength( ) const { return ( m_level[ 0 ] < 2 ) ? 2 : m_level[ 0 ]; }
 };
 
 class WipePattern : public Pattern
 {
 public:
+    static const ms_t DURATION = 3000;
+
     // returns loop duration, time offset never goes above this
-    virtual ms_t GetDuration( Stripper *strip );
+    virtual ms_t GetDuration( Stripper *strip ) { return DURATION; }
 
     // update pixels as needed
     virtual void Update( Stripper *strip, ms_t offset );
@@ -134,12 +269,17 @@ public:
 class GradientPattern : public Pattern
 {
 public:
+    static const ms_t DURATION = 1000;
+    static const bool STATEFUL = true;
+    static const bool TILE_SAFE = false;
+    static const uint8_t SCRATCH_PER_PIXEL = sizeof( pixel_t ) * 2;
+
     GradientPattern( );
 
     ~GradientPattern( );
     
     // returns loop duration, time offset never goes above this
-    virtual ms_t GetDuration( Stripper *strip );
+    virtual ms_t GetDuration( Stripper *strip ) { return DURATION; }
 
     // assume nothing, setup all pixels
     virtual void Init( Stripper *strip, ms_t offset );
@@ -152,15 +292,19 @@ public:
         
 private:
     Gradient grad;
-    uint8_t *mp1, *mp2;
+    pixel_t *mp1, *mp2;
 };
 
 // Strobe the entire strip
 class StrobePattern : public Pattern
 {
 public:
+    static const ms_t DURATION = 750; // 4Hz at 100% speed, 10Hz at 250% speed
+    static const bool STATEFUL = true;
+    static const bool TILE_SAFE = false;
+
     // returns loop duration, time offset never goes above this
-    virtual ms_t GetDuration( Stripper *strip );
+    virtual ms_t GetDuration( Stripper *strip ) { return DURATION; }
 
     // update pixels as needed
     virtual void Update( Stripper *strip, ms_t offset );
@@ -171,42 +315,160 @@ public:
 class FixedPattern : public Pattern
 {
 public:
+    static const ms_t DURATION = 750;
+    static const bool STATIC_BETWEEN_CHANGES = true;
+
     // returns loop duration, time offset never goes above this
-    virtual ms_t GetDuration( Stripper *strip );
+    virtual ms_t GetDuration( Stripper *strip ) { return DURATION; }
 
     // update pixels as needed
     virtual void Update( Stripper *strip, ms_t offset );
+
+    // writes palette indices on indexed strips
+    virtual bool CanIndex( ) const { return true; }
+    // returns time until the output changes
+    virtual ms_t GetNextChange( Stripper *strip, ms_t offset );
 };
 
 class CandyCanePattern : public Pattern
 {
 public:
+    static const ms_t DURATION = 200;
+    static const bool STATIC_BETWEEN_CHANGES = true;
+
     // returns loop duration, time offset never goes above this
-    virtual ms_t GetDuration( Stripper *strip );
+    virtual ms_t GetDuration( Stripper *strip ) { return DURATION; }
 
     // update pixels as needed
     virtual void Update( Stripper *strip, ms_t offset );
+
+    // writes palette indices on indexed strips
+    virtual bool CanIndex( ) const { return true; }
+    // returns time until the output changes
+    virtual ms_t GetNextChange( Stripper *strip, ms_t offset );
 };
 
 class TestPattern : public Pattern
 {
 public:
+    static const ms_t DURATION = 1000;
+
     // returns loop duration, time offset never goes above this
-    virtual ms_t GetDuration( Stripper *strip );
+    virtual ms_t GetDuration( Stripper *strip ) { return DURATION; }
 
     // update pixels as needed
     virtual void Update( Stripper *strip, ms_t offset );
+
+    // writes palette indices on indexed strips
+    virtual bool CanIndex( ) const { return true; }
 };
 
 class DiagnosticPattern : public Pattern
 {
 public:
+    static const bool STATIC_BETWEEN_CHANGES = true;
+
     DiagnosticPattern( int code = 0 ) 
         : m_code( code ) { }
 
     // update pixels as needed
     virtual void Update( Stripper *strip, ms_t offset );
 
+    // returns time until the output changes
+    virtual ms_t GetNextChange( Stripper *strip, ms_t offset ) { return STATIC_MS; }
+
     int m_code;
 };
 
+
+#ifndef ARDUINO
+// desk-only patterns, ids past the protocol's. They draw in 2D on strips
+// with a Layout and along the strip as a line without one.
+const uint8_t PATTERN_RADIAL_RAINBOW = 100;
+const uint8_t PATTERN_PLASMA = 101;
+const uint8_t PATTERN_SPECTRUM = 102;
+const uint8_t PATTERN_BEAT = 103;
+
+class Layout;
+
+class LayoutPattern : public Pattern
+{
+public:
+    LayoutPattern( );
+    virtual ~LayoutPattern( );
+
+protected:
+    // the strip's layout, or a line of its pixels if it has none that fits
+    const Layout *GetLayout( Stripper *strip );
+
+private:
+    Layout *m_line;
+};
+
+// rainbow rings moving out from the middle, level 0 twists them
+class RadialRainbowPattern : public LayoutPattern
+{
+public:
+    static const ms_t DURATION = 2000;
+
+    // returns loop duration, time offset never goes above this
+    virtual ms_t GetDuration( Stripper *strip ) { return DURATION; }
+
+    // update pixels as needed
+    virtual void Update( Stripper *strip, ms_t offset );
+};
+
+// sine plasma through the three colors
+class PlasmaPattern : public LayoutPattern
+{
+public:
+    static const ms_t DURATION = 8000;
+
+    // returns loop duration, time offset never goes above this
+    virtual ms_t GetDuration( Stripper *strip ) { return DURATION; }
+
+    // assume nothing, setup all pixels
+    virtual void Init( Stripper *strip, ms_t offset );
+
+    // update pixels as needed
+    virtual void Update( Stripper *strip, ms_t offset );
+
+private:
+    uint32_t m_colors[ 256 ]; // the gradient, looked up per pixel
+};
+
+// the strip's audio bands as bars, lows in color 0 through to highs in
+// color 1, up the grid or each along its own run of the strip. Level 0 is
+// the gain, 0x80 for as heard.
+class SpectrumPattern : public LayoutPattern
+{
+public:
+    static const bool STATIC_BETWEEN_CHANGES = true; // without audio
+
+    // assume nothing, setup all pixels
+    virtual void Init( Stripper *strip, ms_t offset );
+
+    // update pixels as needed
+    virtual void Update( Stripper *strip, ms_t offset );
+
+    // returns time until the output changes
+    virtual ms_t GetNextChange( Stripper *strip, ms_t offset );
+
+private:
+    uint32_t m_colors[ 256 ]; // the gradient, looked up per band
+};
+
+// the whole strip flashes on each beat, through the three colors in turn,
+// fading over level 1 * 4 ms and glowing with the loudness in between
+class BeatPattern : public Pattern
+{
+public:
+    static const bool STATIC_BETWEEN_CHANGES = true; // without audio
+
+    // update pixels as needed
+    virtual void Update( Stripper *strip, ms_t offset );
+
+    // returns time until the output changes
+    virtual ms_t GetNextChange( Stripper *strip, ms_t offset );
+};
+#endif
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <stddef.h>
+#include <radiopixel_protocol.h>
+#include "Pattern.h"
+
+
+// Which pattern class plays each id, as a list of types, so the factory,
+// storage size, trait lookups and per frame dispatch all come out of one
+// table at compile time. A pattern is added by giving its class the
+// traits it differs on ( see Pattern ) and an entry in Patterns below.
+
+struct PatternStorage;
+
+// placement new of our own, AVR toolchains don't all ship <new>
+inline void *operator new( size_t size, PatternStorage *storage );
+inline void operator delete( void *pattern, PatternStorage *storage );
+
+template< uint8_t Id, class T >
+struct PatternEntry
+{
+    static const uint8_t ID = Id;
+    typedef T Type;
+};
+
+template< class... Entries >
+struct PatternList;
+
+// past the last entry, unknown ids
+template< >
+struct PatternList< >
+{
+    static const size_t SIZE = 0;
+    static const size_t ALIGN = 1;
+    static const size_t SCRATCH_PER_PIXEL = 0;
+
+    static constexpr bool Has( uint8_t id ) { return false; }
+
+    static Pattern *Create( uint8_t id ) { return NULL; }
+
+    static Pattern *Create( uint8_t id, PatternStorage *storage ) { return NULL; }
+
+    // unknown ids get a DiagnosticPattern
+    static constexpr ms_t Duration( uint8_t id ) { return ms_t( DiagnosticPattern::DURATION ); }
+    static constexpr bool Stateful( uint8_t id ) { return bool( DiagnosticPattern::STATEFUL ); }
+    static constexpr bool StaticBetweenChanges( uint8_t id )
+    {
+        return bool( DiagnosticPattern::STATIC_BETWEEN_CHANGES );
+    }
+
+    static void Update( uint8_t id, Pattern *pattern, Stripper *strip, ms_t offset )
+    {
+        pattern->Update( strip, offset );
+    }
+
+    static void Loop( uint8_t id, Pattern *pattern, Stripper *strip, ms_t offset )
+    {
+        pattern->Loop( strip, offset );
+    }
+
+    static ms_t GetNextChange( uint8_t id, Pattern *pattern, Stripper *strip, ms_t offset )
+    {
+        return pattern->GetNextChange( strip, offset );
+    }
+};
+
+template< class Entry, class... Rest >
+struct PatternList< Entry, Rest... >
+{
+    typedef typename Entry::Type T;
+    typedef PatternList< Rest... > Tail;
+
+    static_assert( !Tail::Has( Entry::ID ), "two patterns share an id" );
+    static_assert( !( T::STATEFUL && T::TILE_SAFE ), "a stateful pattern can't draw a span on its own" );
+
+    // room for any of them
+    static const size_t SIZE = ( sizeof( T ) > Tail::SIZE ) ? sizeof( T ) : Tail::SIZE;
+    static const size_t ALIGN = ( alignof( T ) > Tail::ALIGN ) ? alignof( T ) : Tail::ALIGN;
+    static const size_t SCRATCH_PER_PIXEL = ( size_t( T::SCRATCH_PER_PIXEL ) > Tail::SCRATCH_PER_PIXEL ) ?
+                                            size_t( T::SCRATCH_PER_PIXEL ) : Tail::SCRATCH_PER_PIXEL;
+
+    static constexpr bool Has( uint8_t id ) { return id == Entry::ID || Tail::Has( id ); }
+
+    static Pattern *Create( uint8_t id )
+    {
+        return ( id == Entry::ID ) ? new T( ) : Tail::Create( id );
+    }
+
+    static Pattern *Create( uint8_t id, PatternStorage *storage )
+    {
+        return ( id == Entry::ID ) ? new ( storage ) T( ) : Tail::Create( id, storage );
+    }
+
+    // the casts read the constants without needing them defined anywhere
+
+    static constexpr ms_t Duration( uint8_t id )
+    {
+        return ( id == Entry::ID ) ? ms_t( T::DURATION ) : Tail::Duration( id );
+    }
+
+    static constexpr bool Stateful( uint8_t id )
+    {
+        return ( id == Entry::ID ) ? bool( T::STATEFUL ) : Tail::Stateful( id );
+    }
+
+    static constexpr bool StaticBetweenChanges( uint8_t id )
+    {
+        return ( id == Entry::ID ) ? bool( T::STATIC_BETWEEN_CHANGES ) : Tail::StaticBetweenChanges( id );
+    }
+
+    // pattern must be the one Create made for id. The qualified calls skip
+    // the vtable, so the compiler sees which body runs and can inline it.
+
+    static void Update( uint8_t id, Pattern *pattern, Stripper *strip, ms_t offset )
+    {
+        if ( id == Entry::ID )
+        {
+            static_cast< T * >( pattern )->T::Update( strip, offset );
+        }
+        else
+        {
+            Tail::Update( id, pattern, strip, offset );
+        }
+    }
+
+    static void Loop( uint8_t id, Pattern *pattern, Stripper *strip, ms_t offset )
+    {
+        if ( id == Entry::ID )
+        {
+            static_cast< T * >( pattern )->T::Loop( strip, offset );
+        }
+        else
+        {
+            Tail::Loop( id, pattern, strip, offset );
+        }
+    }
+
+    static ms_t GetNextChange( uint8_t id, Pattern *pattern, Stripper *strip, ms_t offset )
+    {
+        if ( id == Entry::ID )
+        {
+            return static_cast< T * >( pattern )->T::GetNextChange( strip, offset );
+        }
+        return Tail::GetNextChange( id, pattern, strip, offset );
+    }
+};
+
+
+typedef PatternList<
+    PatternEntry< RadioPixel::Command::MiniTwinkle, MiniTwinklePattern >,
+    PatternEntry< RadioPixel::Command::MiniSparkle, MiniSparklePattern >,
+    PatternEntry< RadioPixel::Command::Sparkle, SparklePattern >,
+    PatternEntry< RadioPixel::Command::Rainbow, RainbowPattern >,
+    PatternEntry< RadioPixel::Command::Flash, FlashPattern >,
+    PatternEntry< RadioPixel::Command::March, MarchPattern >,
+    PatternEntry< RadioPixel::Command::Wipe, WipePattern >,
+    PatternEntry< RadioPixel::Command::Gradient, GradientPattern >,
+    PatternEntry< RadioPixel::Command::Fixed, FixedPattern >,
+    PatternEntry< RadioPixel::Command::Strobe, StrobePattern >,
+    PatternEntry< RadioPixel::Command::CandyCane, CandyCanePattern >
+#ifndef ARDUINO
+    , PatternEntry< PATTERN_RADIAL_RAINBOW, RadialRainbowPattern >,
+    PatternEntry< PATTERN_PLASMA, PlasmaPattern >,
+    PatternEntry< PATTERN_SPECTRUM, SpectrumPattern >,
+    PatternEntry< PATTERN_BEAT, BeatPattern >
+#endif
+    > Patterns;
+
+
+// Room for whichever pattern is playing, so a player can make each one in
+// place instead of on the heap, and for the per pixel buffers its Init
+// claims, made once for the strip
+struct PatternStorage
+{
+    static const size_t SIZE = ( Patterns::SIZE > sizeof( DiagnosticPattern ) ) ?
+                               Patterns::SIZE : sizeof( DiagnosticPattern );
+    static const size_t ALIGN = ( Patterns::ALIGN > alignof( DiagnosticPattern ) ) ?
+                                Patterns::ALIGN : alignof( DiagnosticPattern );
+
+    // the most any pattern claims, plus padding to align two buffers
+    static const size_t SCRATCH_PER_PIXEL = Patterns::SCRATCH_PER_PIXEL;
+    static const size_t SCRATCH_SLACK = 2 * sizeof( uint32_t );
+
+    PatternStorage( ) : scratch( NULL ), scratchPixels( 0 ) { }
+
+    ~PatternStorage( ) { delete [] scratch; }
+
+    //! scratch for patterns on a strip of pixels, NULL if there's no room
+    uint8_t *Scratch( pixel_t pixels )
+    {
+        if ( pixels != scratchPixels )
+        {
+            delete [] scratch;
+            scratch = new uint8_t[ SCRATCH_PER_PIXEL * pixels + SCRATCH_SLACK ];
+            scratchPixels = scratch ? pixels : 0;
+        }
+        return scratch;
+    }
+
+    alignas( ALIGN ) uint8_t bytes[ SIZE ];
+    uint8_t *scratch;
+    pixel_t scratchPixels;
+};
+
+inline void *operator new( size_t size, PatternStorage *storage )
+{
+    return storage->bytes;
+}
+
+inline void operator delete( void *pattern, PatternStorage *storage )
+{
+}
+
+//! make the pattern for an id in storage, a DiagnosticPattern if unknown.
+// Destroy it with DestroyPattern, not delete.
+Pattern *CreatePattern( uint8_t pattern, PatternStorage *storage );
+
+//! end a pattern made in storage, NULL is fine
+inline void DestroyPattern( Pattern *pattern )
+{
+    if ( pattern )
+    {
+        pattern->~Pattern( );
+    }
+}
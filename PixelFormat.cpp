@@ -0,0 +1,263 @@
+
+#include <string.h>
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ))
+// built for SSSE3 whatever the compiler targets, used if the CPU has it
+#define PIXEL_SSSE3 __attribute__(( target( "ssse3" )))
+#include <tmmintrin.h>
+#endif
+#include "PixelFormat.h"
+
+
+size_t PixelFormatSize( PixelFormat format )
+{
+    switch ( format )
+    {
+    case FORMAT_RGBW:
+        return 4;
+    case FORMAT_RGB16:
+        return 6;
+    case FORMAT_RGB:
+    case FORMAT_GRB:
+    case FORMAT_BGR:
+    default:
+        return 3;
+    }
+}
+
+PixelPacker::PixelPacker( PixelFormat format )
+    : m_format( format ), m_scratch( NULL ), m_capacity( 0 ),
+      m_order( NULL ), m_orderCount( 0 ), m_ordered( NULL )
+{
+}
+
+PixelPacker::~PixelPacker( )
+{
+    delete [] m_scratch;
+    m_scratch = NULL;
+    delete [] m_ordered;
+    m_ordered = NULL;
+}
+
+void PixelPacker::setOrder( const pixel_t *order, pixel_t count )
+{
+    delete [] m_ordered;
+    m_ordered = order ? new uint32_t[ count ] : NULL;
+    m_order = order;
+    m_orderCount = order ? count : 0;
+}
+
+size_t PixelPacker::packedSize( pixel_t pixels ) const
+{
+    return PixelFormatSize( m_format ) * ( m_order ? m_orderCount : pixels );
+}
+
+size_t PixelPacker::pack( const StripBase *strip, uint8_t *out, size_t size )
+{
+    pixel_t count( strip->numPixels( ) );
+    size_t needed( packedSize( count ) );
+    if ( size < needed )
+    {
+        return 0;
+    }
+
+    if ( count > m_capacity )
+    {
+        delete [] m_scratch;
+        m_scratch = new uint32_t[ count ];
+        m_capacity = count;
+    }
+
+    scale( strip->getColors( 0, count, m_scratch ), count, strip->getBrightness( ), m_scratch );
+    if ( m_order )
+    {
+        for ( pixel_t i = 0; i < m_orderCount; ++i )
+        {
+            m_ordered[ i ] = ( m_order[ i ] < count ) ? m_scratch[ m_order[ i ]] : 0;
+        }
+        pack( m_format, m_ordered, m_orderCount, out );
+        return needed;
+    }
+    pack( m_format, m_scratch, count, out );
+    return needed;
+}
+
+//-------------------------------------------------------------
+
+void PixelPacker::scale( const uint32_t *pixels, pixel_t count, uint8_t bright, uint32_t *out )
+{
+    pixel_t i = 0;
+#ifdef __SSE2__
+    // t / 255 == ( t + 1 + ( t >> 8 ) ) >> 8 for every t = c * bright
+    const __m128i zero = _mm_setzero_si128( );
+    const __m128i one = _mm_set1_epi16( 1 );
+    const __m128i b = _mm_set1_epi16( bright );
+    for ( ; i + 4 <= count; i += 4 )
+    {
+        __m128i p = _mm_loadu_si128( ( const __m128i * )( pixels + i ) );
+        __m128i lo = _mm_mullo_epi16( _mm_unpacklo_epi8( p, zero ), b );
+        __m128i hi = _mm_mullo_epi16( _mm_unpackhi_epi8( p, zero ), b );
+        lo = _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( lo, one ), _mm_srli_epi16( lo, 8 ) ), 8 );
+        hi = _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( hi, one ), _mm_srli_epi16( hi, 8 ) ), 8 );
+        _mm_storeu_si128( ( __m128i * )( out + i ), _mm_packus_epi16( lo, hi ) );
+    }
+#endif
+    for ( ; i < count; ++i )
+    {
+        uint32_t c( pixels[ i ] ), s( 0 );
+        for ( int shift = 0; shift < 32; shift += 8 )
+        {
+            s |= ( ( ( c >> shift ) & 0xff ) * bright / 255 ) << shift;
+        }
+        out[ i ] = s;
+    }
+}
+
+//-------------------------------------------------------------
+
+#ifdef PIXEL_SSSE3
+// byte shuffles from four 0xAARRGGBB words ( B G R A in memory )
+static const int8_t SHUFFLE_RGB[ 16 ] = { 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 };
+static const int8_t SHUFFLE_GRB[ 16 ] = { 1, 2, 0, 5, 6, 4, 9, 10, 8, 13, 14, 12, -1, -1, -1, -1 };
+static const int8_t SHUFFLE_BGR[ 16 ] = { 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1 };
+static const int8_t SHUFFLE_RGBW[ 16 ] = { 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15 };
+static const int8_t SHUFFLE_RGB16_LO[ 16 ] = { 2, 2, 1, 1, 0, 0, 6, 6, 5, 5, 4, 4, 10, 10, 9, 9 };
+static const int8_t SHUFFLE_RGB16_HI[ 16 ] = { 8, 8, 14, 14, 13, 13, 12, 12, -1, -1, -1, -1, -1, -1, -1, -1 };
+
+PIXEL_SSSE3 static inline __m128i shuffle( __m128i v, const int8_t *mask )
+{
+    return _mm_shuffle_epi8( v, _mm_loadu_si128( ( const __m128i * )mask ) );
+}
+
+// store the low 12 bytes
+PIXEL_SSSE3 static inline void store12( uint8_t *out, __m128i v )
+{
+    _mm_storel_epi64( ( __m128i * )out, v );
+    uint32_t tail = _mm_cvtsi128_si32( _mm_srli_si128( v, 8 ) );
+    memcpy( out + 8, &tail, 4 );
+}
+
+// move min( r, g, b ) into the alpha byte and take it off the colors
+PIXEL_SSSE3 static inline __m128i extractWhite( __m128i p )
+{
+    const __m128i low = _mm_set1_epi32( 0xff );
+    __m128i w = _mm_min_epu8( p, _mm_srli_epi32( p, 8 ) );
+    w = _mm_and_si128( _mm_min_epu8( w, _mm_srli_epi32( p, 16 ) ), low );
+    __m128i rgb = _mm_or_si128( w, _mm_or_si128( _mm_slli_epi32( w, 8 ), _mm_slli_epi32( w, 16 ) ) );
+    p = _mm_and_si128( _mm_subs_epu8( p, rgb ), _mm_set1_epi32( 0x00ffffff ) );
+    return _mm_or_si128( p, _mm_slli_epi32( w, 24 ) );
+}
+
+// whole groups of four, returns how many pixels it packed
+PIXEL_SSSE3 static pixel_t packSsse3( PixelFormat format, const uint32_t *pixels, pixel_t count, uint8_t *out )
+{
+    pixel_t i = 0;
+    switch ( format )
+    {
+    case FORMAT_RGB:
+    case FORMAT_GRB:
+    case FORMAT_BGR:
+        {
+            const int8_t *mask = ( format == FORMAT_RGB ) ? SHUFFLE_RGB :
+                ( format == FORMAT_GRB ) ? SHUFFLE_GRB : SHUFFLE_BGR;
+            for ( ; i + 4 <= count; i += 4, out += 12 )
+            {
+                __m128i p = _mm_loadu_si128( ( const __m128i * )( pixels + i ) );
+                store12( out, shuffle( p, mask ) );
+            }
+        }
+        break;
+    case FORMAT_RGBW:
+        for ( ; i + 4 <= count; i += 4, out += 16 )
+        {
+            __m128i p = _mm_loadu_si128( ( const __m128i * )( pixels + i ) );
+            _mm_storeu_si128( ( __m128i * )out, shuffle( extractWhite( p ), SHUFFLE_RGBW ) );
+        }
+        break;
+    case FORMAT_RGB16:
+        for ( ; i + 4 <= count; i += 4, out += 24 )
+        {
+            __m128i p = _mm_loadu_si128( ( const __m128i * )( pixels + i ) );
+            _mm_storeu_si128( ( __m128i * )out, shuffle( p, SHUFFLE_RGB16_LO ) );
+            _mm_storel_epi64( ( __m128i * )( out + 16 ), shuffle( p, SHUFFLE_RGB16_HI ) );
+        }
+        break;
+    }
+    return i;
+}
+#endif
+
+void PixelPacker::pack( PixelFormat format, const uint32_t *pixels, pixel_t count, uint8_t *out )
+{
+    pixel_t done = 0;
+#ifdef PIXEL_SSSE3
+    static const bool ssse3( __builtin_cpu_supports( "ssse3" ) );
+    if ( ssse3 )
+    {
+        done = packSsse3( format, pixels, count, out );
+    }
+#endif
+    packReference( format, pixels + done, count - done, out + done * PixelFormatSize( format ) );
+}
+
+void PixelPacker::packReference( PixelFormat format, const uint32_t *pixels, pixel_t count, uint8_t *out )
+{
+    for ( pixel_t i = 0; i < count; ++i )
+    {
+        uint32_t c( pixels[ i ] );
+        uint8_t r = ( uint8_t )( c >> 16 ), g = ( uint8_t )( c >> 8 ), b = ( uint8_t )c;
+        switch ( format )
+        {
+        case FORMAT_RGB:
+            *out++ = r; *out++ = g; *out++ = b;
+            break;
+        case FORMAT_GRB:
+            *out++ = g; *out++ = r; *out++ = b;
+            break;
+        case FORMAT_BGR:
+            *out++ = b; *out++ = g; *out++ = r;
+            break;
+        case FORMAT_RGBW:
+            {
+                uint8_t w = std::min( r, std::min( g, b ) );
+                *out++ = r - w; *out++ = g - w; *out++ = b - w; *out++ = w;
+            }
+            break;
+        case FORMAT_RGB16:
+            *out++ = r; *out++ = r; *out++ = g; *out++ = g; *out++ = b; *out++ = b;
+            break;
+        }
+    }
+}
+
+void PixelPacker::unpack( PixelFormat format, const uint8_t *in, pixel_t count, uint32_t *pixels )
+{
+    for ( pixel_t i = 0; i < count; ++i )
+    {
+        int r = 0, g = 0, b = 0;
+        switch ( format )
+        {
+        case FORMAT_RGB:
+            r = in[ 0 ]; g = in[ 1 ]; b = in[ 2 ];
+            break;
+        case FORMAT_GRB:
+            g = in[ 0 ]; r = in[ 1 ]; b = in[ 2 ];
+            break;
+        case FORMAT_BGR:
+            b = in[ 0 ]; g = in[ 1 ]; r = in[ 2 ];
+            break;
+        case FORMAT_RGBW:
+            r = in[ 0 ] + in[ 3 ]; g = in[ 1 ] + in[ 3 ]; b = in[ 2 ] + in[ 3 ];
+            break;
+        case FORMAT_RGB16:
+            // high byte of each channel, the low byte only repeats it
+            r = in[ 0 ]; g = in[ 2 ]; b = in[ 4 ];
+            break;
+        }
+        pixels[ i ] = StripBase::Color( r, g, b );
+        in += PixelFormatSize( format );
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stddef.h>
+#include "StripBase.h"
+
+
+// wire layouts for output controllers
+enum PixelFormat
+{
+    FORMAT_RGB,
+    FORMAT_GRB,   // WS2812, NEO_GRB in the firmware
+    FORMAT_BGR,
+    FORMAT_RGBW,  // white pulled out of the common part of r, g and b
+    FORMAT_RGB16  // 16 bits per channel, big-endian
+};
+
+//! bytes per pixel for a format
+size_t PixelFormatSize( PixelFormat format );
+
+
+// Packs strip frames into the layout a controller wants, one per strip
+// so every output can have its own format. Alpha is never carried.
+class PixelPacker
+{
+public:
+    PixelPacker( PixelFormat format = FORMAT_GRB );
+
+    ~PixelPacker( );
+
+    PixelFormat format( ) const { return m_format; }
+
+    void setFormat( PixelFormat format ) { m_format = format; }
+
+    //! send pixels out in another order, order[ i ] is the strip pixel for
+    // output slot i, or past the end of the strip for black. For raster
+    // frames from a Layout grid. NULL goes back to strip order, not owned.
+    void setOrder( const pixel_t *order, pixel_t count );
+
+    // bytes needed for a strip length
+    size_t packedSize( pixel_t pixels ) const;
+
+    //! pack the strip with its brightness applied into out, returns the
+    // bytes written or 0 if size is too small
+    size_t pack( const StripBase *strip, uint8_t *out, size_t size );
+
+    // raw conversions, no brightness. pack( ) uses SSSE3 shuffles where
+    // the CPU has them.
+    static void pack( PixelFormat format, const uint32_t *pixels, pixel_t count, uint8_t *out );
+    static void unpack( PixelFormat format, const uint8_t *in, pixel_t count, uint32_t *pixels );
+
+    // pixel at a time packer, for checking pack( ) against
+    static void packReference( PixelFormat format, const uint32_t *pixels, pixel_t count, uint8_t *out );
+
+    // scale every channel by bright / 255, same rounding as Stripper::ColorFade
+    static void scale( const uint32_t *pixels, pixel_t count, uint8_t bright, uint32_t *out );
+
+private:
+    PixelFormat m_format;
+
+    // brightness scaled frame, only grows
+    uint32_t *m_scratch;
+    pixel_t m_capacity;
+
+    const pixel_t *m_order;
+    pixel_t m_orderCount;
+    uint32_t *m_ordered; // m_orderCount pixels
+};
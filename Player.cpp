@@ -1,20 +1,47 @@
-#include <QTime>
+#ifndef ARDUINO
+#include <QElapsedTimer>
+#endif
 #include "Player.h"
 
 
+#ifndef ARDUINO
+static thread_local Clock *currentClock = NULL;
+
+Clock *SetClock( Clock *clock )
+{
+    Clock *previous( currentClock );
+    currentClock = clock;
+    return previous;
+}
+
 ms_t millis( )
 {
-    QTime tm( QTime::currentTime());
-    return tm.msecsSinceStartOfDay();
+    if ( currentClock )
+    {
+        return currentClock->Now( );
+    }
+    // monotonic from the first call: the time of day steps back at
+    // midnight and whenever the wall clock is set
+    static const QElapsedTimer started( []( ) { QElapsedTimer timer; timer.start( ); return timer; }( ));
+    return started.elapsed( );
 }
+#endif
 
-void Player::SetSequence( Sequence *_sequence )
+void Player::SetSequence( Sequence *_sequence, ms_t now, stamp_t _received )
 {
+    if ( _received )
+    {
+        received = _received;
+    }
+
     if ( sequence != _sequence )
     {
         sequence = _sequence;
         step = sequence->Reset( );
-        stepTime = millis( );
+        stepTime = now;
+#ifndef ARDUINO
+        warp = 0;
+#endif
     }
 }
 
@@ -57,6 +84,9 @@ bool Player::UpdatePattern( ms_t now, Stripper *strip )
     {
         step = sequence->Advance( step, true );
         stepTime = now;
+#ifndef ARDUINO
+        warp = 0;
+#endif
     }
   
     // update the pattern to match the command
@@ -65,7 +95,8 @@ bool Player::UpdatePattern( ms_t now, Stripper *strip )
     switch ( sequence->GetCommand( step ) )
     {
     case HC_PATTERN:
-        if ( !pattern ||
+        effects.SetEffects( sequence->GetEffects( step ) );
+        if ( !pattern || restart ||
             sequence->GetPatternId( step ) != patternId ||
             sequence->GetColors( step, 0 ) != pattern->color( 0 ) ||
             sequence->GetColors( step, 1 ) != pattern->color( 1 ) ||
@@ -79,11 +110,28 @@ bool Player::UpdatePattern( ms_t now, Stripper *strip )
             Serial.println( sequence->GetPatternId( step ));
 #endif
             
-            delete pattern;
+            // new patterns draw on the strip, or beside the old one
+            Stripper *target( strip );
             patternId = sequence->GetPatternId( step );
+#ifndef ARDUINO
+            if ( transition.Begin( pattern, lastElapsed, speed, strip, now ) )
+            {
+                target = transition.Target( );
+            }
+            else
+            {
+                delete pattern;
+            }
             pattern = CreatePattern( patternId );
-            ms_t duration( pattern->GetDuration( strip ) );
-            ms_t offset = ( now * speed / 100 ) % duration;
+#else
+            // one at a time, in place
+            DestroyPattern( pattern );
+            pattern = CreatePattern( patternId, &patternStorage );
+            pattern->SetScratch( patternStorage.Scratch( strip->numPixels( ) ) );
+#endif
+            speed = sequence->GetSpeed( step );
+            ms_t duration( Patterns::Duration( patternId ) );
+            ms_t offset = Elapsed( now ) % duration;
             uint32_t colors[ 3 ];
             colors[ 0 ] = sequence->GetColors( step, 0 );
             colors[ 1 ] = sequence->GetColors( step, 1 );
@@ -92,18 +140,32 @@ bool Player::UpdatePattern( ms_t now, Stripper *strip )
             levels[ 0 ] = sequence->GetLevels( step, 0 );
             levels[ 1 ] = sequence->GetLevels( step, 1 );
             levels[ 2 ] = sequence->GetLevels( step, 2 );
-            pattern->Init( strip, colors, levels, offset );
-            strip->show();
+            if ( target == strip )
+            {
+                strip->setIndexed( indexed && pattern->CanIndex( ) );
+            }
+            pattern->Init( target, colors, levels, offset );
+            restart = false;
+#ifndef ARDUINO
+            transition.Update( strip, now );
+            lastElapsed = offset;
+#endif
+            effects.Apply( strip );
+            Show( strip );
 
             changed = true;
 
             strip->setBrightness( sequence->GetBrightness( step ) );
-            speed = sequence->GetSpeed( step );
         }
         break;
         
     case HC_CONTROL:
-        strip->setBrightness( sequence->GetBrightness( step ) );
+        if ( strip->getBrightness( ) != sequence->GetBrightness( step ) )
+        {
+            // static patterns won't redraw by themselves
+            strip->setBrightness( sequence->GetBrightness( step ) );
+            Show( strip );
+        }
         speed = sequence->GetSpeed( step );
         changed = true;
         break;
@@ -121,21 +183,158 @@ void Player::UpdateStrip( ms_t now, Stripper *strip )
     // update the strip if it's time
     if ( pattern && strip && ( ( now - lastUpdate ) > FRAME_MS ) )
     {
-        ms_t duration( pattern->GetDuration( strip ) );
-        ms_t offset = ( ( now - stepTime ) * speed / 100 ) % duration;
-        unsigned long count = ( ( now - stepTime ) * speed / 100 ) / duration;
-        unsigned long lastCount = ( ( lastUpdate - stepTime ) * speed / 100 ) / duration;
+        Stripper *target( strip );
+#ifndef ARDUINO
+        if ( transition.IsActive( ) )
+        {
+            target = transition.Target( );
+        }
+#endif
+        ms_t duration( Patterns::Duration( patternId ) );
+        unsigned long lastCount = Elapsed( lastUpdate ) / duration;
+#ifndef ARDUINO
+        React( now, strip );
+#endif
+        ms_t elapsed( Elapsed( now ) );
+        ms_t offset = elapsed % duration;
+        unsigned long count = elapsed / duration;
+        // by id, so the frame doesn't go through the vtable
         if ( count != lastCount )
         {
-            pattern->Loop( strip, offset );
+            Patterns::Loop( patternId, pattern, target, offset );
         }
         else
         {
-            pattern->Update( strip, offset );
+            Patterns::Update( patternId, pattern, target, offset );
         }
-        strip->show();
+#ifndef ARDUINO
+        // blend with the outgoing pattern, the last blend leaves the
+        // incoming frame on the strip
+        transition.Update( strip, now );
+        lastElapsed = elapsed;
+#endif
+        effects.Apply( strip );
+        Show( strip );
         
         lastUpdate = now;
     }
 }
 
+ms_t Player::GetNextUpdate( ms_t now, Stripper *strip )
+{
+    ms_t next = STATIC_MS;
+
+    // step boundary
+    if ( sequence && ( sequence->GetDuration( step ) > 0 ) )
+    {
+        next = stepTime + sequence->GetDuration( step );
+    }
+
+    // next pattern change, nothing shows while dark or stopped
+    if ( pattern && strip && strip->getBrightness( ) && speed )
+    {
+        ms_t frame( lastUpdate + FRAME_MS + 1 );
+        ms_t change( 0 );
+        if ( lastUpdate >= stepTime && Patterns::StaticBetweenChanges( patternId ) )
+        {
+            ms_t duration( Patterns::Duration( patternId ) );
+            ms_t elapsed( ( lastUpdate - stepTime ) * speed / 100 );
+            change = Patterns::GetNextChange( patternId, pattern, strip, elapsed % duration );
+            if ( change != STATIC_MS )
+            {
+                // first wall time whose pattern time reaches the change
+                change = stepTime + ( ( elapsed + change ) * 100 + speed - 1 ) / speed;
+            }
+        }
+        if ( change != STATIC_MS )
+        {
+            change = ( change > frame ) ? change : frame;
+            next = ( change < next ) ? change : next;
+        }
+    }
+
+    // jitter and trails move every frame, whatever the pattern does
+    if ( pattern && strip && strip->getBrightness( ) && effects.IsAnimated( ) )
+    {
+        ms_t frame( lastUpdate + FRAME_MS + 1 );
+        next = ( next == STATIC_MS || frame < next ) ? frame : next;
+    }
+
+#ifndef ARDUINO
+    // blends move every frame, even between static patterns, and so does
+    // anything following the sound
+    if ( pattern && ( transition.IsActive( ) || ( react && strip && strip->getAudio( ) ) ) )
+    {
+        ms_t frame( lastUpdate + FRAME_MS + 1 );
+        next = ( next == STATIC_MS || frame < next ) ? frame : next;
+    }
+#endif
+
+    return ( next != STATIC_MS && next < now ) ? now : next;
+}
+
+ms_t Player::GetPhase( ms_t now, Stripper *strip, ms_t *loop )
+{
+    if ( !pattern || !strip || !speed )
+    {
+        if ( loop )
+        {
+            *loop = 0;
+        }
+        return 0;
+    }
+    ms_t duration( Patterns::Duration( patternId ) );
+    if ( loop )
+    {
+        *loop = duration * 100 / speed;
+    }
+    return Elapsed( now ) % duration * 100 / speed;
+}
+
+#ifndef ARDUINO
+void Player::React( ms_t now, Stripper *strip )
+{
+    const AudioAnalyzer *audio( strip->getAudio( ) );
+    if ( !react || !audio || !sequence )
+    {
+        return;
+    }
+    AudioFrame frame( audio->snapshot( ) );
+
+    if ( react & AUDIO_REACT_BRIGHTNESS )
+    {
+        // the step's brightness when loud, a quarter of it in silence
+        uint8_t top( sequence->GetBrightness( step ) );
+        strip->setBrightness( top / 4 + ( top - top / 4 ) * frame.level / 255 );
+    }
+
+    if ( react & AUDIO_REACT_SPEED )
+    {
+        // half to one and a half times the speed with the bass, banked as
+        // pattern time so the pattern never jumps
+        ms_t since( now - lastUpdate );
+        since = ( since < 100 ) ? since : 100;
+        int bass( ( frame.bands[ 0 ] + frame.bands[ 1 ] ) / 2 );
+        warp += ( int64_t )since * speed * ( bass - 128 ) / 256;
+    }
+}
+#endif
+
+void Player::Show( Stripper *strip )
+{
+    strip->setStamp( received );
+    strip->show();
+    strip->setStamp( 0 );
+    if ( received )
+    {
+        shown = received;
+        received = 0;
+    }
+}
+
+stamp_t Player::TakeShown( )
+{
+    stamp_t stamp( shown );
+    shown = 0;
+    return stamp;
+}
@@ -1,10 +1,35 @@
+#pragma once
+
 #include <radiopixel_protocol.h>
 #include "Pattern.h"
+#include "PatternRegistry.h"
 #include "Sequence.h"
+#include "Effects.h"
+#ifndef ARDUINO
+#include "Audio.h"
+#include "Transition.h"
+#endif
 
 
 ms_t millis();
 
+#ifndef ARDUINO
+// where millis( ) gets the time, so players can run on simulated time
+class Clock
+{
+public:
+    virtual ~Clock( ) {}
+
+    virtual ms_t Now( ) = 0;
+};
+
+//! read millis( ) on this thread from clock, NULL for the real, monotonic one.
+// Returns the clock it replaces.
+Clock *SetClock( Clock *clock );
+#endif
+
+typedef uint64_t stamp_t; // receive time, ns since the epoch, 0 for none
+
 
 class Player
 {
@@ -12,15 +37,84 @@ public:
     Player()
         : sequence( NULL ), step( 0 ), stepTime( 0 ),
           pattern( NULL ), patternId( RadioPixel::Command::Gradient ), 
-          lastUpdate( 0 ), speed( 35 )
+          lastUpdate( 0 ), speed( 35 ), indexed( false ), restart( false ),
+          received( 0 ), shown( 0 )
+#ifndef ARDUINO
+          , lastElapsed( 0 ), react( AUDIO_REACT_NONE ), warp( 0 )
+#endif
     {
     }
 
+    //! render patterns that support it as palette indices
+    void SetIndexed( bool _indexed ) { indexed = _indexed; }
+
+#ifndef ARDUINO
+    //! blend pattern changes over duration ms, TRANSITION_NONE to swap
+    void SetTransition( uint8_t kind, ms_t duration ) { transition.Set( kind, duration ); }
+
+    //! follow the strip's audio, AUDIO_REACT_* flags
+    void SetAudioReact( uint8_t _react ) { react = _react; }
+#endif
+
     //! returns the current sequence
     Sequence *GetSequence( ) { return sequence; }
 
     //! Replace sequence
-    void SetSequence( Sequence *_sequence );
+    void SetSequence( Sequence *_sequence ) { SetSequence( _sequence, millis( ) ); }
+
+    //! Replace sequence at a given time, received stamps the command
+    // that caused it
+    void SetSequence( Sequence *_sequence, ms_t now, stamp_t _received = 0 );
+
+    //! the current sequence's steps changed under it, keep the step valid
+    void SequenceChanged( )
+    {
+        if ( sequence && step >= sequence->GetStepCount( ) )
+        {
+            step = sequence->Reset( );
+        }
+    }
+
+    //! returns the current step index
+    int GetStep( ) const { return step; }
+
+    //! jump to a step of the current sequence that started at _stepTime,
+    // to carry on where a restarted node left off
+    void SetStep( int _step, ms_t _stepTime ) { step = _step; stepTime = _stepTime; }
+
+    //! returns when the current step started
+    ms_t GetStepTime( ) const { return stepTime; }
+
+    //! Move the start of the current step, to run it on a shared timeline.
+    // Stateless patterns just draw at the new offset, stateful ones start
+    // over there.
+    void SetStepTime( ms_t _stepTime )
+    {
+        restart = restart || ( pattern && _stepTime != stepTime && Patterns::Stateful( patternId ) );
+        stepTime = _stepTime;
+    }
+
+#ifndef ARDUINO
+    //! the clock now reads delta ms more for the same instant, move every
+    // time kept from it so nothing on the strip jumps
+    void Rebase( int32_t delta )
+    {
+        stepTime += delta;
+        lastUpdate += delta;
+        transition.Rebase( delta );
+    }
+
+    //! pattern time into the current step at now, speed and audio included
+    ms_t GetPosition( ms_t now ) const { return Elapsed( now ); }
+
+    //! carry on position ms of pattern time into the current step, at the
+    // speed the step starts at
+    void SetPosition( ms_t position, ms_t now )
+    {
+        int64_t at( sequence ? sequence->GetSpeed( step ) : speed );
+        warp = ( ( int64_t )position - ( int64_t )( now - stepTime ) * at / 100 ) * 100;
+    }
+#endif
 
     //! Advance the sequence via a button press
     void AdvanceSequence( );
@@ -35,15 +129,62 @@ public:
     //! update the strip with the current pattern if needed
     void UpdateStrip( ms_t now, Stripper *strip );
 
+    //! returns the time UpdatePattern/UpdateStrip next have work to do,
+    // STATIC_MS if the output won't change without new input
+    ms_t GetNextUpdate( ms_t now, Stripper *strip );
+
+    //! returns where the pattern is within its loop and optionally the
+    // loop length, both in wall clock ms
+    ms_t GetPhase( ms_t now, Stripper *strip, ms_t *loop = NULL );
+
+    //! returns the stamp of the last command to reach show( ) and clears it,
+    // 0 if none has since the last call
+    stamp_t TakeShown( );
+
 protected:
+    // show the strip, tagging the frame with a waiting command stamp
+    void Show( Stripper *strip );
+
+    // pattern time since the step started
+    ms_t Elapsed( ms_t now ) const
+    {
+#ifndef ARDUINO
+        return ( now - stepTime ) * speed / 100 + warp / 100;
+#else
+        return ( now - stepTime ) * speed / 100;
+#endif
+    }
+
+#ifndef ARDUINO
+    // move brightness and speed with the strip's audio
+    void React( ms_t now, Stripper *strip );
+#endif
+
     Sequence *sequence;
     int step; // the current step index
     ms_t stepTime; // time we started the current step
     
-    Pattern *pattern;
+    Pattern *pattern; // always what CreatePattern made for patternId
     uint8_t patternId;    
+#ifdef ARDUINO
+    PatternStorage patternStorage; // pattern lives here, no heap churn per change
+#endif
     ms_t lastUpdate;
     uint8_t speed;
+    bool indexed; // palette mode allowed
+    bool restart; // the phase of a stateful pattern moved, Init it again
+
+    EffectChain effects; // post-processing for the current step
+
+    stamp_t received; // command waiting for its first frame
+    stamp_t shown; // command whose first frame went out
+
+#ifndef ARDUINO
+    Transition transition; // outgoing pattern while blending
+    ms_t lastElapsed; // pattern time of the last frame
+    uint8_t react; // AUDIO_REACT_* flags
+    int64_t warp; // pattern time gained or lost to audio this step, in 1/100 ms
+#endif
 };
 
 const ms_t FRAME_MS = 1000 / 125;
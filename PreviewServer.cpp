@@ -0,0 +1,432 @@
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QTcpSocket>
+#include <QtEndian>
+#include "PreviewServer.h"
+
+
+// a client that hasn't acked in this long lost the frame, start it over
+const qint64 ACK_TIMEOUT_MS = 2000;
+
+// don't pile frames onto a socket the kernel hasn't drained
+const qint64 MAX_UNSENT = 64 * 1024;
+
+// ignore handshakes and messages bigger than this
+const int MAX_INPUT = 8 * 1024;
+
+// zeros it takes to end a copy run, shorter gaps are cheaper to copy
+const int MIN_SKIP = 4;
+
+const char *WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+enum
+{
+    WS_TEXT = 0x1,
+    WS_BINARY = 0x2,
+    WS_CLOSE = 0x8,
+    WS_PING = 0x9,
+    WS_PONG = 0xa
+};
+
+
+static void putVarint( QByteArray *out, quint32 value )
+{
+    while ( value >= 0x80 )
+    {
+        out->append( char( value | 0x80 ));
+        value >>= 7;
+    }
+    out->append( char( value ));
+}
+
+static bool getVarint( const uchar **in, const uchar *end, quint32 *value )
+{
+    *value = 0;
+    for ( int shift = 0; shift < 35 && *in < end; shift += 7 )
+    {
+        uchar b = *( *in )++;
+        *value |= quint32( b & 0x7f ) << shift;
+        if ( !( b & 0x80 ))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+PreviewServer::PreviewServer( StripBase *strip, QObject *parent )
+    : QObject( parent ),
+      m_strip( strip ),
+      m_packer( FORMAT_RGB ),
+      m_frameNumber( 0 )
+{
+    connect( m_strip, SIGNAL( show()),
+             this, SLOT( onShow()));
+    connect( &m_server, SIGNAL( newConnection()),
+             this, SLOT( onConnection()));
+}
+
+PreviewServer::~PreviewServer( )
+{
+    qDeleteAll( m_clients );
+}
+
+bool PreviewServer::listen( quint16 port, const QHostAddress &address )
+{
+    if ( !m_server.listen( address, port ))
+    {
+        qWarning( ) << "preview can't listen on" << address << port << m_server.errorString( );
+        return false;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------
+
+QByteArray PreviewServer::encodeDelta( const QByteArray &base, const QByteArray &frame )
+{
+    QByteArray out;
+    const uchar *b = ( const uchar *)base.constData( );
+    const uchar *f = ( const uchar *)frame.constData( );
+    int size = frame.size( );
+    int baseSize = base.size( );
+
+    int pos = 0;
+    while ( pos < size )
+    {
+        // unchanged bytes
+        int skip = pos;
+        while ( skip < size && skip < baseSize && b[ skip ] == f[ skip ] )
+        {
+            ++skip;
+        }
+        if ( skip == size )
+        {
+            break; // nothing more to send
+        }
+
+        // changed bytes, until a long enough unchanged gap
+        int copy = skip;
+        int same = 0;
+        while ( copy < size && same < MIN_SKIP )
+        {
+            bool equal = copy < baseSize && b[ copy ] == f[ copy ];
+            same = equal ? same + 1 : 0;
+            ++copy;
+        }
+        copy -= same;
+
+        putVarint( &out, skip - pos );
+        putVarint( &out, copy - skip );
+        for ( int i = skip; i < copy; ++i )
+        {
+            out.append( char( f[ i ] ^ ( i < baseSize ? b[ i ] : 0 )));
+        }
+        pos = copy;
+    }
+    return out;
+}
+
+bool PreviewServer::applyDelta( QByteArray *base, const char *delta, int size )
+{
+    const uchar *in = ( const uchar *)delta;
+    const uchar *end = in + size;
+    uchar *out = ( uchar *)base->data( );
+    quint32 pos = 0;
+
+    while ( in < end )
+    {
+        quint32 skip, copy;
+        if ( !getVarint( &in, end, &skip ) || !getVarint( &in, end, &copy ))
+        {
+            return false;
+        }
+        pos += skip;
+        if ( pos + copy > ( quint32 )base->size( ) || copy > quint32( end - in ))
+        {
+            return false;
+        }
+        for ( quint32 i = 0; i < copy; ++i )
+        {
+            out[ pos++ ] ^= *in++;
+        }
+    }
+    return true;
+}
+
+//-------------------------------------------------------------
+
+void PreviewServer::onShow( )
+{
+    if ( m_clients.isEmpty( ))
+    {
+        return; // don't bother packing for nobody
+    }
+
+    packFrame( );
+    foreach ( Client *client, m_clients )
+    {
+        if ( !client->upgraded )
+        {
+            continue;
+        }
+        if ( client->pendingFrame && client->sent.elapsed( ) > ACK_TIMEOUT_MS &&
+             !client->socket->bytesToWrite( ))
+        {
+            // lost, or the client doesn't ack; resync from black
+            client->pendingFrame = 0;
+            client->acked.clear( );
+            client->ackedFrame = 0;
+        }
+        if ( client->pendingFrame || client->socket->bytesToWrite( ) > MAX_UNSENT )
+        {
+            client->stale = true;
+            continue;
+        }
+        sendFrame( client );
+    }
+}
+
+void PreviewServer::packFrame( )
+{
+    m_frame.resize( m_packer.packedSize( m_strip->numPixels( )));
+    m_packer.pack( m_strip, ( uint8_t *)m_frame.data( ), m_frame.size( ));
+    if ( !++m_frameNumber )
+    {
+        m_frameNumber = 1; // 0 means no frame
+    }
+}
+
+void PreviewServer::sendFrame( Client *client )
+{
+    // a different strip length can't be diffed
+    if ( client->acked.size( ) != m_frame.size( ))
+    {
+        client->acked.clear( );
+        client->ackedFrame = 0;
+    }
+
+    QByteArray message( 12, 0 );
+    qToLittleEndian<quint32>( m_frameNumber, ( uchar *)message.data( ));
+    qToLittleEndian<quint32>( client->ackedFrame, ( uchar *)message.data( ) + 4 );
+    qToLittleEndian<quint32>( m_strip->numPixels( ), ( uchar *)message.data( ) + 8 );
+    message.append( encodeDelta( client->acked, m_frame ));
+    sendMessage( client->socket, WS_BINARY, message );
+
+    client->pending = m_frame;
+    client->pendingFrame = m_frameNumber;
+    client->sent.start( );
+    client->stale = false;
+}
+
+void PreviewServer::sendMessage( QTcpSocket *socket, quint8 opcode, const QByteArray &payload )
+{
+    QByteArray header;
+    header.append( char( 0x80 | opcode ));
+    quint64 size = payload.size( );
+    if ( size < 126 )
+    {
+        header.append( char( size ));
+    }
+    else if ( size < 0x10000 )
+    {
+        header.append( char( 126 ));
+        header.append( char( size >> 8 ));
+        header.append( char( size ));
+    }
+    else
+    {
+        header.append( char( 127 ));
+        for ( int shift = 56; shift >= 0; shift -= 8 )
+        {
+            header.append( char( size >> shift ));
+        }
+    }
+    socket->write( header );
+    socket->write( payload );
+}
+
+//-------------------------------------------------------------
+
+void PreviewServer::onConnection( )
+{
+    while ( m_server.hasPendingConnections( ))
+    {
+        Client *client = new Client;
+        client->socket = m_server.nextPendingConnection( );
+        client->upgraded = false;
+        client->ackedFrame = 0;
+        client->pendingFrame = 0;
+        client->stale = false;
+        m_clients.append( client );
+
+        connect( client->socket, SIGNAL( readyRead()),
+                 this, SLOT( onReadyRead()));
+        connect( client->socket, SIGNAL( disconnected()),
+                 this, SLOT( onDisconnected()));
+    }
+}
+
+PreviewServer::Client *PreviewServer::find( QTcpSocket *socket )
+{
+    foreach ( Client *client, m_clients )
+    {
+        if ( client->socket == socket )
+        {
+            return client;
+        }
+    }
+    return nullptr;
+}
+
+void PreviewServer::onDisconnected( )
+{
+    Client *client = find( qobject_cast<QTcpSocket *>( sender( )));
+    if ( client )
+    {
+        m_clients.removeOne( client );
+        client->socket->deleteLater( );
+        delete client;
+    }
+}
+
+void PreviewServer::onReadyRead( )
+{
+    Client *client = find( qobject_cast<QTcpSocket *>( sender( )));
+    if ( !client )
+    {
+        return;
+    }
+
+    client->input.append( client->socket->readAll( ));
+    if ( client->input.size( ) > MAX_INPUT )
+    {
+        client->socket->abort( );
+        return;
+    }
+
+    if ( !client->upgraded && !handshake( client ))
+    {
+        return;
+    }
+    parseMessages( client );
+}
+
+bool PreviewServer::handshake( Client *client )
+{
+    int end = client->input.indexOf( "\r\n\r\n" );
+    if ( end < 0 )
+    {
+        return false; // wait for the rest
+    }
+
+    QByteArray key;
+    foreach ( const QByteArray &line, client->input.left( end ).split( '\n' ))
+    {
+        int colon = line.indexOf( ':' );
+        if ( colon > 0 &&
+             line.left( colon ).trimmed( ).toLower( ) == "sec-websocket-key" )
+        {
+            key = line.mid( colon + 1 ).trimmed( );
+        }
+    }
+    client->input.remove( 0, end + 4 );
+
+    if ( key.isEmpty( ))
+    {
+        client->socket->write( "HTTP/1.1 400 Bad Request\r\n\r\n" );
+        client->socket->disconnectFromHost( );
+        return false;
+    }
+
+    QByteArray accept( QCryptographicHash::hash( key + WS_GUID,
+                                                 QCryptographicHash::Sha1 ).toBase64( ));
+    client->socket->write( "HTTP/1.1 101 Switching Protocols\r\n"
+                           "Upgrade: websocket\r\n"
+                           "Connection: Upgrade\r\n"
+                           "Sec-WebSocket-Accept: " + accept + "\r\n\r\n" );
+    client->upgraded = true;
+
+    // a keyframe now, a still strip may not show( ) again for a long time,
+    // and nothing was packed while nobody watched
+    packFrame( );
+    sendFrame( client );
+    return true;
+}
+
+void PreviewServer::parseMessages( Client *client )
+{
+    for ( ;; )
+    {
+        const uchar *in = ( const uchar *)client->input.constData( );
+        int avail = client->input.size( );
+        if ( avail < 2 )
+        {
+            return;
+        }
+
+        quint8 opcode = in[ 0 ] & 0x0f;
+        bool masked = in[ 1 ] & 0x80;
+        quint64 size = in[ 1 ] & 0x7f;
+        int header = 2;
+        if ( size == 126 )
+        {
+            if ( avail < 4 )
+            {
+                return;
+            }
+            size = ( in[ 2 ] << 8 ) | in[ 3 ];
+            header = 4;
+        }
+        else if ( size == 127 )
+        {
+            client->socket->abort( ); // nothing we want is that big
+            return;
+        }
+        if ( masked )
+        {
+            header += 4;
+        }
+        if ( avail < header + ( int )size )
+        {
+            return;
+        }
+
+        QByteArray payload( client->input.mid( header, size ));
+        if ( masked )
+        {
+            const uchar *mask = in + header - 4;
+            for ( int i = 0; i < payload.size( ); ++i )
+            {
+                payload[ i ] = payload[ i ] ^ mask[ i & 3 ];
+            }
+        }
+        client->input.remove( 0, header + size );
+
+        if ( opcode == WS_CLOSE )
+        {
+            sendMessage( client->socket, WS_CLOSE, QByteArray( ));
+            client->socket->disconnectFromHost( );
+            return;
+        }
+        else if ( opcode == WS_PING )
+        {
+            sendMessage( client->socket, WS_PONG, payload );
+        }
+        else if ( opcode == WS_TEXT )
+        {
+            // ack, the client now has the frame in flight
+            if ( client->pendingFrame && payload.toUInt( ) == client->pendingFrame )
+            {
+                client->acked = client->pending;
+                client->ackedFrame = client->pendingFrame;
+                client->pendingFrame = 0;
+                if ( client->stale && !m_frame.isEmpty( ))
+                {
+                    sendFrame( client );
+                }
+            }
+        }
+    }
+}
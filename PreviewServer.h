@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QList>
+#include <QTcpServer>
+#include "PixelFormat.h"
+
+class QTcpSocket;
+
+
+// Streams a strip's frames to browser previewers over WebSocket. Frames go
+// out as packed RGB with the brightness applied, XOR'd against the last
+// frame the client acknowledged and run length coded, so a mostly still
+// strip costs a few bytes a frame. Each client has at most one frame in
+// flight; frames that arrive while it's busy are dropped and the client
+// gets the newest one when it acks.
+//
+// Binary message, little-endian:
+//   uint32 frame, uint32 base frame ( 0: against black ), uint32 pixels,
+//   then ( varint skip, varint copy, copy bytes ) runs to XOR in.
+// The client acks by sending the frame number as text.
+class PreviewServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    PreviewServer( StripBase *strip, QObject *parent = nullptr );
+
+    ~PreviewServer( );
+
+    //! loopback only unless you ask otherwise
+    bool listen( quint16 port, const QHostAddress &address = QHostAddress::LocalHost );
+
+    int clientCount( ) const { return m_clients.size( ); }
+
+    // delta codec, shared with native previewers
+    static QByteArray encodeDelta( const QByteArray &base, const QByteArray &frame );
+
+    //! apply a delta to base in place, false if it doesn't fit
+    static bool applyDelta( QByteArray *base, const char *delta, int size );
+
+private slots:
+    void onShow( );
+    void onConnection( );
+    void onReadyRead( );
+    void onDisconnected( );
+
+private:
+    struct Client
+    {
+        QTcpSocket *socket;
+        bool upgraded; // WebSocket handshake done
+        QByteArray input;
+
+        QByteArray acked; // frame the client has, empty for none
+        quint32 ackedFrame;
+        QByteArray pending; // frame in flight
+        quint32 pendingFrame; // 0 when nothing is in flight
+        QElapsedTimer sent;
+        bool stale; // frames were dropped while waiting
+    };
+
+    Client *find( QTcpSocket *socket );
+
+    bool handshake( Client *client );
+
+    // pull whole WebSocket messages out of the input
+    void parseMessages( Client *client );
+
+    // the strip as it is now into m_frame, under a new frame number
+    void packFrame( );
+
+    void sendFrame( Client *client );
+
+    void sendMessage( QTcpSocket *socket, quint8 opcode, const QByteArray &payload );
+
+    StripBase *m_strip;
+    QTcpServer m_server;
+    QList<Client *> m_clients;
+
+    PixelPacker m_packer;
+    QByteArray m_frame; // newest frame, packed
+    quint32 m_frameNumber;
+};
@@ -3,6 +3,7 @@
 //#include <avr/pgmspace.h>
 #include <radiopixel_protocol.h>
 #include "Pattern.h"
+#include "Effects.h"
 
 
 class Sequence
@@ -25,6 +26,7 @@ public:
     virtual int GetPatternId( int step ) = 0;
     virtual uint32_t GetColors( int step, int color ) = 0;
     virtual uint8_t GetLevels( int step, int level ) = 0;
+    virtual uint8_t GetEffects( int step ) { return EFFECT_NONE; }
 };
 
 class PacketSequence : public Sequence
@@ -54,6 +56,7 @@ struct Step
     uint8_t pattern;
     uint32_t colors[ 3 ];
     uint8_t level;
+    uint8_t effects;
 };
 #pragma pack( pop )
 
@@ -69,6 +72,7 @@ public:
     virtual int GetPatternId( int step ) { return steps[ step ].pattern; }
     virtual uint32_t GetColors( int step, int color ) { return steps[ step ].colors[ color ]; }
     virtual uint8_t GetLevels( int step, int level ) { return ( level == 0 ) ? steps[ step ].level : 0; }
+    virtual uint8_t GetEffects( int step ) { return steps[ step ].effects; }
 
     const Step *steps;
     int stepCount;
@@ -0,0 +1,215 @@
+#include <string.h>
+#include <QDebug>
+#include <QFileInfo>
+#include "SequenceLibrary.h"
+
+
+// what a sequence plays when its name leaves the library
+static const Step darkStep =
+    { 0, 0, 0, RadioPixel::Command::Fixed, 0, 0, 0, 0, EFFECT_NONE };
+
+
+SequenceLibrary::SequenceLibrary( QObject *parent )
+    : QObject( parent ),
+      m_file( nullptr ), m_data( nullptr ), m_size( 0 )
+{
+    // editors and seqc replace the file, so watch the directory as well
+    connect( &m_watcher, SIGNAL( fileChanged(QString)),
+             this, SLOT( onChanged()));
+    connect( &m_watcher, SIGNAL( directoryChanged(QString)),
+             this, SLOT( onChanged()));
+}
+
+SequenceLibrary::~SequenceLibrary()
+{
+    qDeleteAll( m_sequences );
+    delete m_file;
+}
+
+bool SequenceLibrary::open( const QString &path )
+{
+    m_path = path;
+    m_watcher.addPath( QFileInfo( path ).absolutePath( ));
+    if ( QFile::exists( path ))
+    {
+        m_watcher.addPath( path );
+    }
+    return load( );
+}
+
+Sequence *SequenceLibrary::sequence( const QString &name )
+{
+    StepSequence *sequence( m_sequences.value( name ));
+    if ( !sequence && names( ).contains( name ))
+    {
+        sequence = new StepSequence( NULL, 0 );
+        attach( name, sequence );
+        m_sequences.insert( name, sequence );
+    }
+    return sequence;
+}
+
+QStringList SequenceLibrary::names( ) const
+{
+    QStringList names;
+    if ( m_data )
+    {
+        uint32_t count( ( ( const LibraryHeader *)m_data )->count );
+        for ( uint32_t i = 0; i < count; ++i )
+        {
+            names.append( QString::fromLatin1( entries( )[ i ].name ));
+        }
+    }
+    return names;
+}
+
+void SequenceLibrary::onChanged()
+{
+    // a replaced file drops out of the watcher
+    QFileInfo info( m_path );
+    if ( !info.exists( ))
+    {
+        return;
+    }
+    if ( !m_watcher.files( ).contains( m_path ))
+    {
+        m_watcher.addPath( m_path );
+    }
+
+    if ( info.lastModified( ) != m_modified || info.size( ) != m_size )
+    {
+        if ( load( ))
+        {
+            emit reloaded( );
+        }
+    }
+}
+
+bool SequenceLibrary::load( )
+{
+    QFile *file = new QFile( m_path );
+    if ( !file->open( QIODevice::ReadOnly ))
+    {
+        qWarning( ) << "can't open sequence library" << m_path << file->errorString( );
+        delete file;
+        return false;
+    }
+
+    qint64 size( file->size( ));
+    const uchar *data( size ? file->map( 0, size ) : nullptr );
+    QString error( data ? validate( data, size ) : QString( "can't map it" ));
+    if ( !error.isEmpty( ))
+    {
+        // keep playing from the old mapping, a half written file gets
+        // another look when it next changes
+        qWarning( ) << "sequence library" << m_path << error;
+        delete file;
+        return false;
+    }
+
+    // move everyone over before the old mapping goes
+    QFile *old( m_file );
+    m_file = file;
+    m_data = data;
+    m_size = size;
+    m_modified = QFileInfo( m_path ).lastModified( );
+    for ( QMap< QString, StepSequence * >::iterator i = m_sequences.begin( );
+          i != m_sequences.end( ); ++i )
+    {
+        attach( i.key( ), i.value( ));
+    }
+    delete old;
+    return true;
+}
+
+void SequenceLibrary::attach( const QString &name, StepSequence *sequence )
+{
+    const LibraryHeader *header( ( const LibraryHeader *)m_data );
+    const LibraryEntry *entry( entries( ));
+    const Step *steps( ( const Step *)( entry + header->count ));
+    for ( uint32_t i = 0; i < header->count; ++i, ++entry )
+    {
+        if ( name == QLatin1String( entry->name ))
+        {
+            sequence->steps = steps + entry->first;
+            sequence->stepCount = entry->steps;
+            return;
+        }
+    }
+    qWarning( ) << "sequence" << name << "left the library";
+    sequence->steps = &darkStep;
+    sequence->stepCount = 1;
+}
+
+const LibraryEntry *SequenceLibrary::entries( ) const
+{
+    return ( const LibraryEntry *)( m_data + sizeof( LibraryHeader ));
+}
+
+//-------------------------------------------------------------
+
+QString SequenceLibrary::validate( const uchar *data, qint64 size )
+{
+    if ( size < ( qint64 )sizeof( LibraryHeader ))
+    {
+        return "too short";
+    }
+    const LibraryHeader *header( ( const LibraryHeader *)data );
+    if ( header->magic != LIBRARY_MAGIC )
+    {
+        return "not a sequence library";
+    }
+    if ( header->version != LIBRARY_VERSION || header->stepSize != sizeof( Step ))
+    {
+        return QString( "version %1, step size %2" ).arg( header->version ).arg( header->stepSize );
+    }
+
+    qint64 stepBytes( size - ( qint64 )sizeof( LibraryHeader ) -
+                      ( qint64 )header->count * ( qint64 )sizeof( LibraryEntry ));
+    if ( stepBytes < 0 || stepBytes % ( qint64 )sizeof( Step ))
+    {
+        return "truncated";
+    }
+    qint64 stepCount( stepBytes / ( qint64 )sizeof( Step ));
+
+    const LibraryEntry *entry( ( const LibraryEntry *)( header + 1 ));
+    for ( uint32_t i = 0; i < header->count; ++i, ++entry )
+    {
+        if ( !memchr( entry->name, 0, LIBRARY_NAME_SIZE ))
+        {
+            return QString( "entry %1 has no name" ).arg( i );
+        }
+        if ( !entry->steps || ( qint64 )entry->first + entry->steps > stepCount )
+        {
+            return QString( "sequence %1 has bad steps" ).arg( entry->name );
+        }
+    }
+    return QString( );
+}
+
+QByteArray SequenceLibrary::build( const QStringList &names, const QList< QVector< Step > > &steps )
+{
+    LibraryHeader header;
+    header.magic = LIBRARY_MAGIC;
+    header.version = LIBRARY_VERSION;
+    header.count = names.size( );
+    header.stepSize = sizeof( Step );
+
+    QByteArray image( ( const char *)&header, sizeof header );
+    uint32_t first( 0 );
+    for ( int i = 0; i < names.size( ); ++i )
+    {
+        LibraryEntry entry;
+        memset( &entry, 0, sizeof entry );
+        strncpy( entry.name, names[ i ].toLatin1( ).constData( ), LIBRARY_NAME_SIZE - 1 );
+        entry.first = first;
+        entry.steps = steps[ i ].size( );
+        image.append( ( const char *)&entry, sizeof entry );
+        first += entry.steps;
+    }
+    for ( int i = 0; i < steps.size( ); ++i )
+    {
+        image.append( ( const char *)steps[ i ].constData( ), steps[ i ].size( ) * sizeof( Step ));
+    }
+    return image;
+}
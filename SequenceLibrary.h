@@ -0,0 +1,91 @@
+#pragma once
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QList>
+#include <QMap>
+#include <QStringList>
+#include <QVector>
+
+#include "Sequence.h"
+
+
+// Sequence library file, in host byte order: a LibraryHeader, count
+// LibraryEntry records, then the packed Steps of every sequence. Steps are
+// used in place from the mapping, so the node never parses or copies them.
+const uint32_t LIBRARY_MAGIC = 0x4c535052; // "RPSL"
+const uint32_t LIBRARY_VERSION = 1;
+const int LIBRARY_NAME_SIZE = 24; // with the terminating NUL
+
+#pragma pack( push, 1 )
+struct LibraryHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count; // entries
+    uint32_t stepSize; // sizeof( Step ) when written
+};
+
+struct LibraryEntry
+{
+    char name[ LIBRARY_NAME_SIZE ];
+    uint32_t first; // index into the steps
+    uint32_t steps;
+};
+#pragma pack( pop )
+
+
+// A memory-mapped sequence library that follows changes to its file.
+// Replace the file rather than rewriting it in place, the way seqc does:
+// the old mapping stays valid until every sequence has moved over.
+class SequenceLibrary : public QObject
+{
+    Q_OBJECT
+
+public:
+    SequenceLibrary( QObject *parent = nullptr );
+    ~SequenceLibrary();
+
+    //! map path and watch it, false if it isn't a valid library yet
+    bool open( const QString &path );
+
+    //! the named sequence, NULL if the library has none. Owned by the
+    // library, it follows reloads, going dark if the name disappears.
+    Sequence *sequence( const QString &name );
+
+    QStringList names( ) const;
+
+    //! returns what's wrong with a library image, empty if nothing
+    static QString validate( const uchar *data, qint64 size );
+
+    //! returns a library image of the named step lists
+    static QByteArray build( const QStringList &names, const QList< QVector< Step > > &steps );
+
+signals:
+    //! sequences handed out may have new steps, and fewer of them
+    void reloaded();
+
+private slots:
+    void onChanged();
+
+private:
+    // map the file and move every sequence onto it
+    bool load( );
+
+    // point a sequence at its steps in the current mapping
+    void attach( const QString &name, StepSequence *sequence );
+
+    const LibraryEntry *entries( ) const;
+
+    QString m_path;
+    QFile *m_file; // holds the mapping
+    const uchar *m_data;
+    QDateTime m_modified; // of the file mapped
+    qint64 m_size;
+
+    QFileSystemWatcher m_watcher;
+
+    QMap< QString, StepSequence * > m_sequences; // handed out
+};
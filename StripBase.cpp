@@ -1,2 +1,145 @@
+#include <string.h>
+#include <algorithm>
 #include "StripBase.h"
 
+
+// channel * bright / 255, the same scaling the outputs use
+static uint32_t dim( uint32_t color, uint8_t bright )
+{
+    return ( ( color >> 16 & 0xff ) * bright / 255 ) << 16 |
+        ( ( color >> 8 & 0xff ) * bright / 255 ) << 8 |
+        ( color & 0xff ) * bright / 255;
+}
+
+StripBase::StripBase( StripBase *parent, pixel_t first, pixel_t count, bool reversed )
+    : m_count( count ), m_data( parent->m_data + first ),
+      m_parent( parent ), m_first( first ), m_reversed( reversed ),
+      m_processed( false ), m_indexed( false ), m_paletteSize( 0 ),
+      m_bright( 255 ), m_stamp( 0 ), m_layout( NULL ), m_audio( NULL )
+{
+    m_parent->m_views.push_back( this );
+}
+
+StripBase::~StripBase( )
+{
+    if ( m_parent )
+    {
+        std::vector< StripBase * > &views( m_parent->m_views );
+        views.erase( std::remove( views.begin( ), views.end( ), this ), views.end( ));
+    }
+}
+
+const uint32_t *StripBase::getColors( pixel_t first, pixel_t count, uint32_t *scratch ) const
+{
+    if ( m_indexed )
+    {
+        const uint8_t *indices( m_indices.data() + first );
+        for ( pixel_t i = 0; i < count; ++i )
+        {
+            scratch[ i ] = m_palette[ indices[ i ] ];
+        }
+        return scratch;
+    }
+
+    // views draw in their own order at their own brightness, from the
+    // output if effects ran over them, untouched ones go out straight
+    // from the buffer
+    const uint32_t *data( m_processed ? output( ) : m_data );
+    bool compose( false );
+    for ( size_t v = 0; v < m_views.size( ); ++v )
+    {
+        const StripBase *view( m_views[ v ] );
+        compose = compose || view->m_reversed || view->m_bright != 255 ||
+            view->m_processed != m_processed;
+    }
+
+    if ( !compose )
+    {
+        return data + first;
+    }
+
+    memcpy( scratch, data + first, count * sizeof( uint32_t ));
+    for ( size_t v = 0; v < m_views.size( ); ++v )
+    {
+        const StripBase *view( m_views[ v ] );
+        const uint32_t *colors( view->m_processed ? output( ) : m_data );
+        pixel_t low( std::max( first, view->m_first ));
+        pixel_t high( std::min( first + count, view->m_first + view->m_count ));
+        for ( pixel_t i = low; i < high; ++i )
+        {
+            pixel_t from( view->m_reversed ? 2 * view->m_first + view->m_count - 1 - i : i );
+            scratch[ i - first ] = ( view->m_bright == 255 ) ?
+                colors[ from ] : dim( colors[ from ], view->m_bright );
+        }
+    }
+    return scratch;
+}
+
+uint32_t *StripBase::getOutput( )
+{
+    if ( m_parent )
+    {
+        return m_parent->getOutput( ) + m_first;
+    }
+    if ( m_output.size( ) != m_count )
+    {
+        m_output.assign( m_count, 0 );
+    }
+    return m_output.data( );
+}
+
+void StripBase::setIndexed( bool indexed )
+{
+    // views share the parent's buffer, which then can't go away
+    if ( indexed == m_indexed || m_parent || !m_views.empty( ))
+    {
+        return;
+    }
+
+    if ( indexed )
+    {
+        // start dark, patterns that index redraw everything
+        m_indices.assign( m_count, 0 );
+        m_palette[ 0 ] = 0;
+        m_paletteSize = 1;
+        Buffer( ).swap( m_pixels );
+        m_data = NULL;
+    }
+    else
+    {
+        // keep the look for patterns that read back what they inherit
+        m_pixels.resize( m_count );
+        getColors( 0, m_count, m_pixels.data() );
+        m_data = m_pixels.data();
+        std::vector< uint8_t >( ).swap( m_indices );
+    }
+    m_indexed = indexed;
+}
+
+uint8_t StripBase::findPaletteColor( uint32_t color )
+{
+    uint32_t rgb( color & 0xffffff );
+    int nearest = 0, best = 0x7fffffff;
+    for ( int i = 0; i < m_paletteSize; ++i )
+    {
+        uint32_t c( m_palette[ i ] & 0xffffff );
+        if ( c == rgb )
+        {
+            return i;
+        }
+        int distance = abs( Red( c ) - Red( rgb ) ) +
+            abs( Green( c ) - Green( rgb ) ) + abs( Blue( c ) - Blue( rgb ) );
+        if ( distance < best )
+        {
+            best = distance;
+            nearest = i;
+        }
+    }
+
+    if ( m_paletteSize < 256 )
+    {
+        m_palette[ m_paletteSize ] = color;
+        return m_paletteSize++;
+    }
+    return nearest;
+}
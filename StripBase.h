@@ -4,38 +4,158 @@
 #include <vector>
 #include <QtGlobal>
 #include <QObject>
-#include <QColor>
+
+// pixel index, wide enough for walls of a million pixels and more
+typedef uint32_t pixel_t;
+
+class Layout;
+class AudioAnalyzer;
 
 class StripBase : public QObject
 {
     Q_OBJECT;
 
 public:
-    StripBase( uint16_t pixels, uint8_t /*pin*/, uint8_t /*type*/ )
-        : m_pixels( pixels )
+    StripBase( pixel_t pixels, uint8_t /*pin*/, uint8_t /*type*/ )
+        : m_count( pixels ), m_pixels( pixels ), m_data( m_pixels.data() ),
+          m_parent( NULL ), m_first( 0 ), m_reversed( false ),
+          m_processed( false ), m_indexed( false ), m_paletteSize( 0 ),
+          m_stamp( 0 ), m_layout( NULL ), m_audio( NULL )
     {
     }
 
-    uint16_t numPixels( ) const
+    //! a view of count pixels from first in parent's frame buffer, for
+    // zones. Views are always direct and have their own brightness.
+    // Reversed views run backwards on the output, see getColors( ).
+    StripBase( StripBase *parent, pixel_t first, pixel_t count, bool reversed );
+
+    ~StripBase( );
+
+    pixel_t numPixels( ) const
     {
-        return m_pixels.size();
+        return m_count;
     }
 
+    // 0xAARRGGBB, opaque, the same words as QRgb without needing QtGui
+
     static uint32_t Color( uint8_t r, uint8_t g, uint8_t b )
     {
-        return qRgb( r, g, b );
+        return 0xff000000u | ( uint32_t )r << 16 | ( uint32_t )g << 8 | b;
+    }
+
+    static uint8_t Red( uint32_t color )
+    {
+        return color >> 16;
+    }
+
+    static uint8_t Green( uint32_t color )
+    {
+        return color >> 8;
+    }
+
+    static uint8_t Blue( uint32_t color )
+    {
+        return color;
+    }
+
+    uint32_t getPixelColor( pixel_t pixel ) const
+    {
+        return m_indexed ? m_palette[ m_indices[ pixel ] ] : m_data[ pixel ];
+    }
+
+    void setPixelColor( pixel_t pixel, uint32_t color )
+    {
+        if ( m_indexed )
+        {
+            m_indices[ pixel ] = findPaletteColor( color );
+        }
+        else
+        {
+            m_data[ pixel ] = color;
+        }
     }
 
-    uint32_t getPixelColor( uint16_t pixel ) const
+    // raw frame buffer, numPixels( ) words, NULL in indexed mode
+    uint32_t *getPixels( )
     {
-        return m_pixels[ pixel ];
+        return m_indexed ? NULL : m_data;
     }
 
-    void setPixelColor( uint16_t pixel, uint32_t color )
+    const uint32_t *getPixels( ) const
     {
-        m_pixels[ pixel ] = color;
+        return m_indexed ? NULL : m_data;
     }
 
+    // colors of count pixels from first as they go out, straight from the
+    // frame buffer or expanded into scratch for palettes and for views
+    // that are reversed or dimmed
+    const uint32_t *getColors( pixel_t first, pixel_t count, uint32_t *scratch ) const;
+
+    //! post-processing output, numPixels( ) words beside the frame buffer
+    // so effects never feed back into what the pattern reads next frame.
+    // Views get their span of the parent's.
+    uint32_t *getOutput( );
+
+    //! while set, getColors( ) sends out getOutput( ) instead of the frame
+    void setProcessed( bool processed )
+    {
+        m_processed = processed;
+    }
+
+    // indexed mode: one byte per pixel into a 256 color palette, a quarter
+    // of the memory and cache traffic of the direct 32 bit buffer
+
+    bool isIndexed( ) const
+    {
+        return m_indexed;
+    }
+
+    //! switch modes, going direct expands the current frame
+    void setIndexed( bool indexed );
+
+    uint8_t getPixelIndex( pixel_t pixel ) const
+    {
+        return m_indices[ pixel ];
+    }
+
+    void setPixelIndex( pixel_t pixel, uint8_t index )
+    {
+        m_indices[ pixel ] = index;
+    }
+
+    const uint8_t *getIndices( ) const
+    {
+        return m_indices.data();
+    }
+
+    void clearPalette( )
+    {
+        m_paletteSize = 0;
+    }
+
+    int getPaletteSize( ) const
+    {
+        return m_paletteSize;
+    }
+
+    uint32_t getPaletteColor( uint8_t index ) const
+    {
+        return m_palette[ index ];
+    }
+
+    void setPaletteColor( uint8_t index, uint32_t color )
+    {
+        m_palette[ index ] = color;
+        if ( index >= m_paletteSize )
+        {
+            m_paletteSize = index + 1;
+        }
+    }
+
+    //! returns the palette index of a color, adding it if there is room
+    // or else the nearest entry
+    uint8_t findPaletteColor( uint32_t color );
+
     uint8_t getBrightness( ) const
     {
         return m_bright;
@@ -46,15 +166,77 @@ public:
         m_bright = bright;
     }
 
+    //! receive time ( ns since the epoch ) of the command this frame is the
+    // first to show, 0 for frames that only advance a pattern. Valid while
+    // show( ) is being emitted.
+    uint64_t getStamp( ) const
+    {
+        return m_stamp;
+    }
+
+    void setStamp( uint64_t stamp )
+    {
+        m_stamp = stamp;
+    }
+
+    //! where the pixels sit in 2D, NULL for a plain strip. Not owned.
+    const Layout *getLayout( ) const
+    {
+        return m_layout;
+    }
+
+    void setLayout( const Layout *layout )
+    {
+        m_layout = layout;
+    }
+
+    //! sound for patterns to follow, NULL for none. Not owned.
+    const AudioAnalyzer *getAudio( ) const
+    {
+        return m_audio;
+    }
+
+    void setAudio( const AudioAnalyzer *audio )
+    {
+        m_audio = audio;
+    }
+
 signals:
     void show();
 
 private:
     typedef std::vector< uint32_t > Buffer;
 
-    Buffer m_pixels;
+    // where getOutput( ) points, without allocating
+    const uint32_t *output( ) const
+    {
+        return m_parent ? m_parent->m_output.data( ) + m_first : m_output.data( );
+    }
+
+    pixel_t m_count;
+
+    Buffer m_pixels; // direct mode
+    uint32_t *m_data; // m_pixels, or a span of the parent's for views
+
+    StripBase *m_parent; // views only
+    pixel_t m_first;
+    bool m_reversed;
+    std::vector< StripBase * > m_views;
+
+    Buffer m_output; // roots only, allocated by the first getOutput( )
+    bool m_processed;
+
+    bool m_indexed;
+    std::vector< uint8_t > m_indices; // indexed mode
+    uint32_t m_palette[ 256 ];
+    int m_paletteSize;
 
     uint8_t m_bright;
+
+    uint64_t m_stamp;
+
+    const Layout *m_layout;
+    const AudioAnalyzer *m_audio;
 };
 
 #endif // STRIPBASE_H
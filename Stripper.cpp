@@ -1,20 +1,64 @@
 #include "Stripper.h"
 
 
+#ifndef ARDUINO
+// xorshift32 per thread, so parallel renders don't share one sequence
+// and each can be repeated from its seed
+static thread_local uint32_t randomState = 2463534242u;
+
+void randomSeed( uint32_t seed )
+{
+    randomState = seed ? seed : 2463534242u;
+}
+
 int random( int _max )
 {
-    return rand( ) % _max;
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState % _max;
+}
+#else
+int random( int _max )
+{
+    if ( _max <= RAND_MAX )
+    {
+        return rand( ) % _max;
+    }
+
+    // RAND_MAX can be as low as 32767, too few for long strips
+    unsigned long long r = ( unsigned long long )rand( ) * ( ( unsigned long long )RAND_MAX + 1 ) + rand( );
+    return r % _max;
 }
+#endif
 
 
-Stripper::Stripper( uint16_t pixels, uint8_t pin, uint8_t type )
+Stripper::Stripper( pixel_t pixels, uint8_t pin, uint8_t type )
     : StripperBase( pixels, pin, type )
 {
 }
 
+#ifndef ARDUINO
+Stripper::Stripper( Stripper *parent, pixel_t first, pixel_t count, bool reversed )
+    : StripperBase( parent, first, count, reversed )
+{
+}
+#endif
+
 void Stripper::setAllColor( uint32_t color)
 {
-    for ( uint16_t i = 0; i < numPixels( ); i++ ) 
+    if ( isIndexed( ) )
+    {
+        // one palette lookup for the whole strip
+        uint8_t index( findPaletteColor( color ) );
+        for ( pixel_t i = 0; i < numPixels( ); i++ ) 
+        {
+            setPixelIndex( i, index );
+        }
+        return;
+    }
+
+    for ( pixel_t i = 0; i < numPixels( ); i++ ) 
     {
         setPixelColor( i, color );
     }
@@ -22,7 +66,7 @@ void Stripper::setAllColor( uint32_t color)
 
 void Stripper::setAllFade( uint8_t v )
 {
-    for ( uint16_t i = 0; i < numPixels( ); i++ ) 
+    for ( pixel_t i = 0; i < numPixels( ); i++ ) 
     {
         setPixelColor( i, ColorFade( getPixelColor( i ), v ) );
     }
@@ -2,13 +2,20 @@
 #define _STRIPPER_H
 
 
+#ifdef ARDUINO
+#include <Adafruit_NeoPixel.h>
+#else
 #include "StripBase.h"
-
-//#include <Adafruit_NeoPixel.h>
+#endif
 
 
 int random( int _max );
 
+#ifndef ARDUINO
+//! restart this thread's random( ) sequence, each thread has its own
+void randomSeed( uint32_t seed );
+#endif
+
 
 // utilities
 
@@ -18,15 +25,26 @@ inline uint32_t fade( uint32_t low, uint32_t high, uint8_t v )
     return ( high - low ) * v / 255 + low;
 }
 
-//typedef Adafruit_NeoPixel StripperBase;
+#ifdef ARDUINO
+#ifndef STRIPBASE_H
+typedef uint16_t pixel_t; // the NeoPixel library counts in 16 bits
+#endif
+typedef Adafruit_NeoPixel StripperBase;
+#else
 typedef StripBase StripperBase;
+#endif
 
 
 // adds convenience methods to base strip class
 class Stripper : public StripperBase
 {
 public:
-    Stripper( uint16_t pixels, uint8_t pin, uint8_t type );
+    Stripper( pixel_t pixels, uint8_t pin, uint8_t type );
+
+#ifndef ARDUINO
+    // a zone of parent, see StripBase
+    Stripper( Stripper *parent, pixel_t first, pixel_t count, bool reversed = false );
+#endif
     
     // set all pixels to a color
     void setAllColor( uint32_t color );
@@ -34,6 +52,17 @@ public:
     // decrease all pixels intensity by value (0-255)
     void setAllFade( uint8_t value );
 
+#ifdef ARDUINO
+    // the NeoPixel buffer has no palette mode, always direct
+    bool isIndexed( ) const { return false; }
+    void setIndexed( bool ) { }
+    void clearPalette( ) { }
+    void setPaletteColor( uint8_t, uint32_t ) { }
+    void setPixelIndex( pixel_t, uint8_t ) { }
+    uint8_t findPaletteColor( uint32_t ) { return 0; }
+    void setStamp( uint64_t ) { }
+#endif
+
     // color tools
 
     // decrease intensity by value (0-255)
@@ -0,0 +1,246 @@
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "Pattern.h"
+#include "Transition.h"
+
+
+Transition::Transition( )
+    : m_kind( TRANSITION_NONE ), m_duration( 0 ),
+      m_from( NULL ), m_fromElapsed( 0 ), m_fromSpeed( 0 ), m_fromLast( 0 ),
+      m_start( 0 ),
+      m_order( NULL ), m_capacity( 0 )
+{
+    m_pool[ 0 ] = m_pool[ 1 ] = NULL;
+}
+
+Transition::~Transition( )
+{
+    End( );
+    delete m_pool[ 0 ];
+    delete m_pool[ 1 ];
+    delete [] m_order;
+}
+
+void Transition::Set( uint8_t kind, ms_t duration )
+{
+    m_kind = kind;
+    m_duration = duration;
+}
+
+void Transition::Reserve( pixel_t count )
+{
+    if ( m_pool[ 0 ] && m_pool[ 0 ]->numPixels( ) == count )
+    {
+        return;
+    }
+
+    delete m_pool[ 0 ];
+    delete m_pool[ 1 ];
+    m_pool[ 0 ] = new Stripper( count, 0, 0 );
+    m_pool[ 1 ] = new Stripper( count, 0, 0 );
+
+    if ( count > m_capacity )
+    {
+        delete [] m_order;
+        m_order = new uint8_t[ count ];
+        m_capacity = count;
+    }
+}
+
+bool Transition::Begin( Pattern *from, ms_t elapsed, uint8_t speed, Stripper *strip, ms_t now )
+{
+    if ( m_kind == TRANSITION_NONE || !m_duration || !from || !strip->numPixels( ) )
+    {
+        return false;
+    }
+
+    pixel_t count( strip->numPixels( ) );
+    if ( m_from && m_pool[ 0 ]->numPixels( ) == count )
+    {
+        // interrupted, the incoming pattern goes out from its own buffer
+        End( );
+        Stripper *swap( m_pool[ 0 ] );
+        m_pool[ 0 ] = m_pool[ 1 ];
+        m_pool[ 1 ] = swap;
+    }
+    else
+    {
+        // the outgoing pattern carries on from the frame it left. The blend
+        // writes every pixel, so the strip stays direct until the next change.
+        End( );
+        Reserve( count );
+        strip->setIndexed( false );
+        memcpy( m_pool[ 0 ]->getPixels( ), strip->getPixels( ), count * sizeof( uint32_t ) );
+    }
+    m_pool[ 1 ]->setAllColor( 0 );
+    m_pool[ 0 ]->setLayout( strip->getLayout( ));
+    m_pool[ 1 ]->setLayout( strip->getLayout( ));
+    m_pool[ 0 ]->setAudio( strip->getAudio( ));
+    m_pool[ 1 ]->setAudio( strip->getAudio( ));
+
+    if ( m_kind == TRANSITION_DISSOLVE )
+    {
+        for ( pixel_t i = 0; i < count; ++i )
+        {
+            m_order[ i ] = random( 255 );
+        }
+    }
+
+    m_from = from;
+    m_fromElapsed = elapsed;
+    m_fromSpeed = speed;
+    m_fromLast = elapsed;
+    m_start = now;
+    return true;
+}
+
+bool Transition::Update( Stripper *strip, ms_t now )
+{
+    if ( !m_from )
+    {
+        return false;
+    }
+
+    pixel_t count( strip->numPixels( ) );
+    uint32_t *out( strip->getPixels( ) );
+    const uint32_t *to( m_pool[ 1 ]->getPixels( ) );
+
+    ms_t elapsed( now - m_start );
+    if ( elapsed >= m_duration || !out )
+    {
+        if ( out )
+        {
+            memcpy( out, to, count * sizeof( uint32_t ) );
+        }
+        End( );
+        return false;
+    }
+
+    // the outgoing pattern keeps running at its own speed
+    ms_t duration( m_from->GetDuration( m_pool[ 0 ] ) );
+    ms_t time( m_fromElapsed + elapsed * m_fromSpeed / 100 );
+    if ( time / duration != m_fromLast / duration )
+    {
+        m_from->Loop( m_pool[ 0 ], time % duration );
+    }
+    else
+    {
+        m_from->Update( m_pool[ 0 ], time % duration );
+    }
+    m_fromLast = time;
+
+    const uint32_t *from( m_pool[ 0 ]->getPixels( ) );
+    uint8_t mix( ( uint64_t )elapsed * 255 / m_duration );
+    switch ( m_kind )
+    {
+    case TRANSITION_WIPE:
+        Wipe( from, to, out, count, mix );
+        break;
+    case TRANSITION_DISSOLVE:
+        Dissolve( from, to, m_order, out, count, mix );
+        break;
+    case TRANSITION_CROSSFADE:
+    default:
+        Crossfade( from, to, out, count, mix );
+        break;
+    }
+    return true;
+}
+
+void Transition::End( )
+{
+    delete m_from;
+    m_from = NULL;
+}
+
+//-------------------------------------------------------------
+
+// ( a * ( 256 - m ) + b * m ) >> 8 per byte, m scaled so 255 is all b
+static inline uint32_t blend( uint32_t a, uint32_t b, uint32_t m )
+{
+    uint32_t rb = ( ( a & 0x00ff00ff ) * ( 256 - m ) + ( b & 0x00ff00ff ) * m ) >> 8;
+    uint32_t ag = ( ( ( a >> 8 ) & 0x00ff00ff ) * ( 256 - m ) + ( ( b >> 8 ) & 0x00ff00ff ) * m );
+    return ( rb & 0x00ff00ff ) | ( ag & 0xff00ff00 );
+}
+
+void Transition::Crossfade( const uint32_t *from, const uint32_t *to, uint32_t *out, pixel_t count, uint8_t mix )
+{
+    pixel_t i = 0;
+
+#ifdef __SSE2__
+    uint32_t m = mix + ( mix >> 7 ); // 0 - 256
+    // 16 bit lanes, a * ( 256 - m ) + b * m fits when done as a + ( b - a ) * m
+    const __m128i zero = _mm_setzero_si128( );
+    const __m128i mm = _mm_set1_epi16( m );
+    for ( ; i + 4 <= count; i += 4 )
+    {
+        __m128i a = _mm_loadu_si128( ( const __m128i *)( from + i ) );
+        __m128i b = _mm_loadu_si128( ( const __m128i *)( to + i ) );
+
+        __m128i alo = _mm_unpacklo_epi8( a, zero );
+        __m128i ahi = _mm_unpackhi_epi8( a, zero );
+        __m128i blo = _mm_unpacklo_epi8( b, zero );
+        __m128i bhi = _mm_unpackhi_epi8( b, zero );
+
+        // ( a << 8 ) + ( b - a ) * m, wraps mod 2^16 to the exact sum
+        __m128i lo = _mm_add_epi16( _mm_slli_epi16( alo, 8 ), _mm_mullo_epi16( _mm_sub_epi16( blo, alo ), mm ) );
+        __m128i hi = _mm_add_epi16( _mm_slli_epi16( ahi, 8 ), _mm_mullo_epi16( _mm_sub_epi16( bhi, ahi ), mm ) );
+
+        lo = _mm_srli_epi16( lo, 8 );
+        hi = _mm_srli_epi16( hi, 8 );
+        _mm_storeu_si128( ( __m128i *)( out + i ), _mm_packus_epi16( lo, hi ) );
+    }
+#endif
+
+    CrossfadeReference( from + i, to + i, out + i, count - i, mix );
+}
+
+void Transition::CrossfadeReference( const uint32_t *from, const uint32_t *to, uint32_t *out, pixel_t count, uint8_t mix )
+{
+    uint32_t m = mix + ( mix >> 7 ); // 0 - 256
+    for ( pixel_t i = 0; i < count; ++i )
+    {
+        out[ i ] = blend( from[ i ], to[ i ], m );
+    }
+}
+
+void Transition::Wipe( const uint32_t *from, const uint32_t *to, uint32_t *out, pixel_t count, uint8_t mix )
+{
+    pixel_t edge( ( uint64_t )count * mix / 255 );
+    memmove( out, to, edge * sizeof( uint32_t ) );
+    memmove( out + edge, from + edge, ( count - edge ) * sizeof( uint32_t ) );
+}
+
+void Transition::Dissolve( const uint32_t *from, const uint32_t *to, const uint8_t *order,
+                           uint32_t *out, pixel_t count, uint8_t mix )
+{
+    pixel_t i = 0;
+
+#ifdef __SSE2__
+    // select per pixel with a mask built from the thresholds
+    const __m128i bias = _mm_set1_epi32( 0x80000000 );
+    const __m128i mm = _mm_xor_si128( _mm_set1_epi32( mix ), bias );
+    for ( ; i + 4 <= count; i += 4 )
+    {
+        __m128i a = _mm_loadu_si128( ( const __m128i *)( from + i ) );
+        __m128i b = _mm_loadu_si128( ( const __m128i *)( to + i ) );
+        __m128i t = _mm_setr_epi32( order[ i ], order[ i + 1 ], order[ i + 2 ], order[ i + 3 ] );
+        __m128i take = _mm_cmplt_epi32( _mm_xor_si128( t, bias ), mm );
+        __m128i o = _mm_or_si128( _mm_and_si128( take, b ), _mm_andnot_si128( take, a ) );
+        _mm_storeu_si128( ( __m128i *)( out + i ), o );
+    }
+#endif
+
+    DissolveReference( from + i, to + i, order + i, out + i, count - i, mix );
+}
+
+void Transition::DissolveReference( const uint32_t *from, const uint32_t *to, const uint8_t *order,
+                                    uint32_t *out, pixel_t count, uint8_t mix )
+{
+    for ( pixel_t i = 0; i < count; ++i )
+    {
+        out[ i ] = ( order[ i ] < mix ) ? to[ i ] : from[ i ];
+    }
+}
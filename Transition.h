@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Stripper.h"
+
+class Pattern;
+
+
+// how one pattern hands over to the next
+enum
+{
+    TRANSITION_NONE,      // swap at once, like the node
+    TRANSITION_CROSSFADE, // blend every pixel
+    TRANSITION_WIPE,      // the new pattern sweeps in from pixel 0
+    TRANSITION_DISSOLVE   // pixels switch over in a random order
+};
+
+
+// Runs the outgoing and incoming patterns side by side for a while, each
+// on its own pooled strip, and blends them onto the real one. The pool
+// only grows when the strip does, so a running transition never
+// allocates.
+class Transition
+{
+public:
+    Transition( );
+
+    ~Transition( );
+
+    //! pick the kind and length, NONE or 0 ms turns transitions off
+    void Set( uint8_t kind, ms_t duration );
+
+    bool IsActive( ) const { return m_from != NULL; }
+
+    //! take over the outgoing pattern, elapsed pattern time into it, and
+    // the frame it left on strip. False ( and nothing taken ) if off.
+    bool Begin( Pattern *from, ms_t elapsed, uint8_t speed, Stripper *strip, ms_t now );
+
+    //! where the incoming pattern draws while active
+    Stripper *Target( ) { return m_pool[ 1 ]; }
+
+    //! advance the outgoing pattern and blend both onto strip, returns
+    // false once done, with the incoming frame copied onto strip
+    bool Update( Stripper *strip, ms_t now );
+
+    //! drop the outgoing pattern now
+    void End( );
+
+    //! the clock now reads delta ms more for the same instant
+    void Rebase( int32_t delta ) { m_start += delta; }
+
+    // kernels, mix 0 is all from, 255 all to
+
+    static void Crossfade( const uint32_t *from, const uint32_t *to, uint32_t *out, pixel_t count, uint8_t mix );
+
+    static void Wipe( const uint32_t *from, const uint32_t *to, uint32_t *out, pixel_t count, uint8_t mix );
+
+    // order holds a threshold per pixel, it switches once mix passes it
+    static void Dissolve( const uint32_t *from, const uint32_t *to, const uint8_t *order,
+                          uint32_t *out, pixel_t count, uint8_t mix );
+
+    // the scalar loops alone, for checking the kernels against
+
+    static void CrossfadeReference( const uint32_t *from, const uint32_t *to, uint32_t *out, pixel_t count, uint8_t mix );
+
+    static void DissolveReference( const uint32_t *from, const uint32_t *to, const uint8_t *order,
+                                   uint32_t *out, pixel_t count, uint8_t mix );
+
+private:
+    // size the pool for a strip length
+    void Reserve( pixel_t count );
+
+    uint8_t m_kind;
+    ms_t m_duration;
+
+    Pattern *m_from;
+    ms_t m_fromElapsed; // pattern time at m_start
+    uint8_t m_fromSpeed;
+    ms_t m_fromLast; // pattern time of its last frame
+
+    ms_t m_start;
+
+    Stripper *m_pool[ 2 ]; // outgoing, incoming
+    uint8_t *m_order; // dissolve thresholds
+    pixel_t m_capacity;
+};
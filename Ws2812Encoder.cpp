@@ -0,0 +1,183 @@
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include <QtEndian>
+#include "Stripper.h"
+#include "Ws2812Encoder.h"
+
+
+const uint32_t RESET_US = 300; // WS2812B latch, older parts only need 50
+const size_t BUFFER_ALIGN = 64; // cache line, keeps DMA descriptors happy
+
+
+Ws2812Encoder::Ws2812Encoder( Symbol symbol, uint32_t spiHz )
+    : m_symbol( symbol ), m_spiHz( spiHz ),
+      m_buffer( NULL ), m_capacity( 0 ), m_size( 0 )
+{
+    if ( !m_spiHz )
+    {
+        m_spiHz = ( m_symbol == SYMBOL_4BIT ) ? 3200000 : 2400000;
+    }
+
+    // one symbol per bit, msb first
+    for ( int v = 0; v < 256; ++v )
+    {
+        uint32_t bits = 0;
+        for ( int b = 7; b >= 0; --b )
+        {
+            bool one = ( v >> b ) & 1;
+            if ( m_symbol == SYMBOL_4BIT )
+            {
+                bits = ( bits << 4 ) | ( one ? 0xe : 0x8 );
+            }
+            else
+            {
+                bits = ( bits << 3 ) | ( one ? 0x6 : 0x4 );
+            }
+        }
+        m_table[ v ] = bits;
+    }
+}
+
+Ws2812Encoder::~Ws2812Encoder( )
+{
+    qFreeAligned( m_buffer );
+    m_buffer = NULL;
+}
+
+size_t Ws2812Encoder::resetBytes( ) const
+{
+    return ( ( uint64_t )RESET_US * m_spiHz / 1000000 + 7 ) / 8;
+}
+
+size_t Ws2812Encoder::streamSize( pixel_t pixels ) const
+{
+    return ( size_t )pixels * 3 * m_symbol + resetBytes( );
+}
+
+void Ws2812Encoder::reserve( pixel_t pixels )
+{
+    size_t needed( streamSize( pixels ) );
+    if ( needed > m_capacity )
+    {
+        qFreeAligned( m_buffer );
+        m_buffer = ( uint8_t * )qMallocAligned( needed, BUFFER_ALIGN );
+        m_capacity = m_buffer ? needed : 0;
+    }
+    m_size = m_buffer ? needed : 0;
+}
+
+void Ws2812Encoder::toGrb( uint32_t color, uint8_t bright, uint8_t *grb )
+{
+    uint32_t c( Stripper::ColorFade( color, bright ) );
+    grb[ 0 ] = ( uint8_t )( c >> 8 );
+    grb[ 1 ] = ( uint8_t )( c >> 16 );
+    grb[ 2 ] = ( uint8_t )c;
+}
+
+const uint8_t *Ws2812Encoder::encode( const StripBase *strip )
+{
+    pixel_t pixels( strip->numPixels( ) );
+    reserve( pixels );
+    if ( !m_buffer )
+    {
+        return NULL;
+    }
+
+    // brightness as a lookup, same scaling as Stripper::ColorFade
+    uint8_t bright( strip->getBrightness( ) );
+    uint8_t scale[ 256 ];
+    for ( int v = 0; v < 256; ++v )
+    {
+        scale[ v ] = fade( 0, v, bright );
+    }
+
+    // indexed strips expand a chunk at a time
+    const pixel_t CHUNK = 256;
+    uint32_t chunk[ CHUNK ];
+    uint8_t *out( m_buffer );
+    for ( pixel_t first = 0; first < pixels; first += CHUNK )
+    {
+        pixel_t count( std::min( CHUNK, pixels - first ) );
+        const uint32_t *src( strip->getColors( first, count, chunk ) );
+        if ( m_symbol == SYMBOL_4BIT )
+        {
+            for ( pixel_t i = 0; i < count; ++i, out += 12 )
+            {
+                uint32_t c( src[ i ] );
+                qToBigEndian< quint32 >( m_table[ scale[ ( c >> 8 ) & 0xff ] ], out );
+                qToBigEndian< quint32 >( m_table[ scale[ ( c >> 16 ) & 0xff ] ], out + 4 );
+                qToBigEndian< quint32 >( m_table[ scale[ c & 0xff ] ], out + 8 );
+            }
+        }
+        else
+        {
+            for ( pixel_t i = 0; i < count; ++i, out += 9 )
+            {
+                uint32_t c( src[ i ] );
+                uint32_t g( m_table[ scale[ ( c >> 8 ) & 0xff ] ] );
+                uint32_t r( m_table[ scale[ ( c >> 16 ) & 0xff ] ] );
+                uint32_t b( m_table[ scale[ c & 0xff ] ] );
+                out[ 0 ] = g >> 16; out[ 1 ] = g >> 8; out[ 2 ] = g;
+                out[ 3 ] = r >> 16; out[ 4 ] = r >> 8; out[ 5 ] = r;
+                out[ 6 ] = b >> 16; out[ 7 ] = b >> 8; out[ 8 ] = b;
+            }
+        }
+    }
+
+    // hold the line low to latch
+    memset( out, 0, m_size - ( out - m_buffer ) );
+    return m_buffer;
+}
+
+double Ws2812Encoder::maxFps( pixel_t pixels ) const
+{
+    double bits( streamSize( pixels ) * 8.0 );
+    return m_spiHz / bits;
+}
+
+void Ws2812Encoder::encodeReference( const uint8_t *grb, size_t bytes, Symbol symbol, uint8_t *out )
+{
+    size_t bit = 0;
+    memset( out, 0, bytes * symbol );
+    for ( size_t i = 0; i < bytes; ++i )
+    {
+        for ( int b = 7; b >= 0; --b )
+        {
+            // a symbol is high for the first slot, then high again for a one
+            // ( 110 / 1110 ), low for a zero ( 100 / 1000 ), then low
+            bool one = ( grb[ i ] >> b ) & 1;
+            for ( int s = 0; s < symbol; ++s, ++bit )
+            {
+                bool high = ( s == 0 ) || ( one && s < symbol - 1 );
+                if ( high )
+                {
+                    out[ bit / 8 ] |= 0x80 >> ( bit % 8 );
+                }
+            }
+        }
+    }
+}
+
+bool Ws2812Encoder::verify( const StripBase *strip ) const
+{
+    pixel_t pixels( strip->numPixels( ) );
+    if ( !m_buffer || m_size != streamSize( pixels ) )
+    {
+        return false;
+    }
+
+    // what goes out, after effects and views
+    std::vector< uint32_t > scratch( pixels );
+    const uint32_t *colors( strip->getColors( 0, pixels, scratch.data( ) ) );
+    std::vector< uint8_t > grb( pixels * 3 );
+    for ( pixel_t i = 0; i < pixels; ++i )
+    {
+        toGrb( colors[ i ], strip->getBrightness( ), &grb[ i * 3 ] );
+    }
+
+    std::vector< uint8_t > expected( m_size, 0 );
+    encodeReference( grb.data( ), grb.size( ), m_symbol, expected.data( ) );
+    return memcmp( expected.data( ), m_buffer, m_size ) == 0;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stddef.h>
+#include "StripBase.h"
+
+
+// Expands a strip frame into the SPI symbol stream that drives WS2812
+// pixels from a plain SPI MOSI line. Every color bit becomes a 3 bit
+// ( 100 / 110 ) or 4 bit ( 1000 / 1110 ) symbol, pixels go out in GRB
+// order with the strip brightness applied, followed by a low reset gap.
+class Ws2812Encoder
+{
+public:
+    enum Symbol
+    {
+        SYMBOL_3BIT = 3, // 2.4 MHz nominal
+        SYMBOL_4BIT = 4  // 3.2 MHz nominal
+    };
+
+    // spiHz of 0 picks the nominal clock for the symbol width
+    Ws2812Encoder( Symbol symbol = SYMBOL_3BIT, uint32_t spiHz = 0 );
+
+    ~Ws2812Encoder( );
+
+    Symbol symbol( ) const { return m_symbol; }
+
+    uint32_t spiHz( ) const { return m_spiHz; }
+
+    // bytes of stream for a strip length, including the reset gap
+    size_t streamSize( pixel_t pixels ) const;
+
+    //! size the stream buffer, only allocates when the strip gets longer
+    void reserve( pixel_t pixels );
+
+    //! encode a frame, returns the stream ( size( ) bytes, 64 byte aligned )
+    const uint8_t *encode( const StripBase *strip );
+
+    const uint8_t *data( ) const { return m_buffer; }
+
+    size_t size( ) const { return m_size; }
+
+    //! frames per second the wire allows for a strip length
+    double maxFps( pixel_t pixels ) const;
+
+    // bit at a time encoder, for checking encode( ) against
+    static void encodeReference( const uint8_t *grb, size_t bytes, Symbol symbol, uint8_t *out );
+
+    //! re-encode the strip with the reference encoder and compare
+    bool verify( const StripBase *strip ) const;
+
+private:
+    size_t resetBytes( ) const;
+
+    // GRB bytes for a pixel after brightness
+    static void toGrb( uint32_t color, uint8_t bright, uint8_t *grb );
+
+    Symbol m_symbol;
+    uint32_t m_spiHz;
+
+    // symbol bits for each byte value, right aligned
+    uint32_t m_table[ 256 ];
+
+    uint8_t *m_buffer;
+    size_t m_capacity;
+    size_t m_size;
+};
@@ -0,0 +1,50 @@
+#include "Zone.h"
+
+
+Zone::Config::Config( )
+    : first( 0 ), count( 0 ), reversed( false ), group( 0 ),
+      sequence( "idle" )
+{
+}
+
+Zone::Zone( Stripper *strip, const Config &config )
+    : m_config( config ),
+      m_view( NULL ), m_strip( strip ),
+      m_idle( &m_builtinIdle ),
+      m_recvSequence( &m_recvPacket )
+{
+    // clamp to the strip, a zone past the end is empty
+    pixel_t length( strip->numPixels( ));
+    m_config.first = ( m_config.first < length ) ? m_config.first : length;
+    pixel_t rest( length - m_config.first );
+    m_config.count = ( m_config.count && m_config.count < rest ) ? m_config.count : rest;
+
+    if ( m_config.count != length || m_config.reversed )
+    {
+        m_view = new Stripper( strip, m_config.first, m_config.count, m_config.reversed );
+        m_strip = m_view;
+    }
+
+    m_player.SetSequence( m_idle );
+}
+
+Zone::~Zone( )
+{
+    delete m_view;
+}
+
+void Zone::play( const RadioPixel::Command &command, ms_t now, stamp_t received )
+{
+    m_recvPacket = command;
+    m_player.SetSequence( &m_recvSequence, now, received );
+}
+
+void Zone::setIdle( Sequence *sequence )
+{
+    Sequence *idle( sequence ? sequence : &m_builtinIdle );
+    if ( m_player.GetSequence( ) == m_idle )
+    {
+        m_player.SetSequence( idle );
+    }
+    m_idle = idle;
+}
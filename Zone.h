@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QString>
+
+#include "Player.h"
+
+
+// A span of a strip with its own player and sequences, following one
+// command group. Zones draw straight into their span of the strip's
+// frame buffer, so one show( ) sends every zone.
+class Zone
+{
+public:
+    struct Config
+    {
+        Config( );
+
+        QString name;
+        pixel_t first;
+        pixel_t count; // 0 for the rest of the strip
+        bool reversed; // first pixel of the pattern at the far end
+        uint8_t group;
+        QString sequence; // library sequence to start on, else the built-in idle
+    };
+
+    //! a zone of strip, or all of it if config covers it in order
+    Zone( Stripper *strip, const Config &config );
+    ~Zone( );
+
+    const QString &name( ) const { return m_config.name; }
+
+    uint8_t group( ) const { return m_config.group; }
+
+    const QString &idleName( ) const { return m_config.sequence; }
+
+    //! true if the zone draws on a view rather than the strip itself
+    bool isView( ) const { return m_view != NULL; }
+
+    //! where the zone's patterns draw, numPixels( ) is the zone length
+    Stripper *strip( ) { return m_strip; }
+
+    Player *player( ) { return &m_player; }
+
+    //! play a received command from now
+    void play( const RadioPixel::Command &command, ms_t now, stamp_t received );
+
+    //! true if playing the last received command, not idling
+    bool isPlayingCommand( ) { return m_player.GetSequence( ) == &m_recvSequence; }
+
+    const RadioPixel::Command &command( ) const { return m_recvPacket; }
+
+    //! fall back to sequence, if the zone is idle, NULL for the built-in
+    void setIdle( Sequence *sequence );
+
+private:
+    Config m_config;
+
+    Stripper *m_view; // owned, NULL when the zone is the whole strip
+    Stripper *m_strip;
+
+    Player m_player;
+    IdleSequence m_builtinIdle;
+    Sequence *m_idle;
+
+    RadioPixel::Command m_recvPacket; // last packet received
+    PacketSequence m_recvSequence;
+};
@@ -0,0 +1,409 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QSettings>
+#include <QStringList>
+#include "radiopixel_protocol.h"
+#include "Broadcaster.h"
+#include "DeskNode.h"
+#include "OutputSink.h"
+#include "PreviewServer.h"
+
+
+const ms_t DEFAULT_TRANSITION_MS = 500;
+
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 14, 0 )
+const auto SKIP_EMPTY = Qt::SkipEmptyParts;
+#else
+const auto SKIP_EMPTY = QString::SkipEmptyParts;
+#endif
+
+
+// one strip group: node settings plus where its frames go
+struct StripConfig
+{
+    StripConfig( ) : format( FORMAT_GRB ), preview( 0 ), broadcast( -1 ) {}
+
+    DeskNode::Config node;
+    QString sink;
+    PixelFormat format;
+    quint16 preview; // loopback WebSocket port, 0 for none
+    int broadcast; // group this strip controls, -1 for none
+};
+
+
+static bool parseFormat( const QString &name, PixelFormat *format )
+{
+    static const struct { const char *name; PixelFormat format; } formats[] =
+    {
+        { "rgb", FORMAT_RGB },
+        { "grb", FORMAT_GRB },
+        { "bgr", FORMAT_BGR },
+        { "rgbw", FORMAT_RGBW },
+        { "rgb16", FORMAT_RGB16 },
+    };
+
+    for ( size_t i = 0; i < sizeof formats / sizeof formats[ 0 ]; ++i )
+    {
+        if ( name.compare( formats[ i ].name, Qt::CaseInsensitive ) == 0 )
+        {
+            *format = formats[ i ].format;
+            return true;
+        }
+    }
+    return false;
+}
+
+// "crossfade:500", the kind alone takes DEFAULT_TRANSITION_MS
+static bool parseTransition( const QString &spec, uint8_t *kind, ms_t *duration )
+{
+    static const struct { const char *name; uint8_t kind; } kinds[] =
+    {
+        { "none", TRANSITION_NONE },
+        { "crossfade", TRANSITION_CROSSFADE },
+        { "wipe", TRANSITION_WIPE },
+        { "dissolve", TRANSITION_DISSOLVE },
+    };
+
+    bool ok( true );
+    *duration = DEFAULT_TRANSITION_MS;
+    if ( spec.contains( ':' ))
+    {
+        *duration = spec.section( ':', 1 ).toUInt( &ok );
+    }
+    QString name( spec.section( ':', 0, 0 ));
+    for ( size_t i = 0; ok && i < sizeof kinds / sizeof kinds[ 0 ]; ++i )
+    {
+        if ( name.compare( kinds[ i ].name, Qt::CaseInsensitive ) == 0 )
+        {
+            *kind = kinds[ i ].kind;
+            return true;
+        }
+    }
+    return false;
+}
+
+// "brightness+speed", what players follow in the audio
+static bool parseReact( const QString &spec, uint8_t *react )
+{
+    *react = AUDIO_REACT_NONE;
+    foreach ( const QString &name, spec.split( '+', SKIP_EMPTY ))
+    {
+        if ( name == "brightness" )
+        {
+            *react |= AUDIO_REACT_BRIGHTNESS;
+        }
+        else if ( name == "speed" )
+        {
+            *react |= AUDIO_REACT_SPEED;
+        }
+        else if ( name != "none" )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// "left:0-149:1:idle", name, first to last pixel with an r to reverse, the
+// group to follow, the strip's by default, and the library sequence to
+// idle on
+static bool parseZone( const QString &spec, uint8_t group, Zone::Config *zone )
+{
+    bool ok( true );
+    QString range( spec.section( ':', 1, 1 ));
+    zone->name = spec.section( ':', 0, 0 );
+    zone->reversed = range.endsWith( 'r' );
+    if ( zone->reversed )
+    {
+        range.chop( 1 );
+    }
+    zone->first = range.section( '-', 0, 0 ).toUInt( &ok );
+    pixel_t last( ok ? range.section( '-', 1 ).toUInt( &ok ) : 0 );
+    ok = ok && last >= zone->first;
+    zone->count = last - zone->first + 1;
+
+    uint zoneGroup( group );
+    if ( ok && spec.count( ':' ) > 1 )
+    {
+        zoneGroup = spec.section( ':', 2, 2 ).toUInt( &ok );
+    }
+    ok = ok && zoneGroup < 256;
+    zone->group = zoneGroup;
+    if ( spec.count( ':' ) > 2 )
+    {
+        zone->sequence = spec.section( ':', 3 );
+    }
+    return ok;
+}
+
+// apply one key, returns false for a bad key or value
+static bool setKey( StripConfig *config, const QString &key, const QString &value )
+{
+    bool ok( true );
+    if ( key == "length" )
+    {
+        config->node.length = value.toUInt( &ok );
+        ok = ok && config->node.length;
+    }
+    else if ( key == "port" )
+    {
+        config->node.port = value.toUShort( &ok );
+    }
+    else if ( key == "cloud" )
+    {
+        // host:port, empty to stay off the cloud
+        config->node.cloudHost = value.section( ':', 0, 0 );
+        if ( value.contains( ':' ))
+        {
+            config->node.cloudPort = value.section( ':', 1 ).toUShort( &ok );
+        }
+    }
+    else if ( key == "indexed" )
+    {
+        config->node.indexed = ( value == "1" || value == "true" );
+    }
+    else if ( key == "sink" )
+    {
+        config->sink = value;
+    }
+    else if ( key == "group" )
+    {
+        uint group( value.toUInt( &ok ));
+        ok = ok && group < 256;
+        config->node.group = group;
+    }
+    else if ( key == "broadcast" )
+    {
+        uint group( value.toUInt( &ok ));
+        ok = ok && group < 256;
+        config->broadcast = group;
+    }
+    else if ( key == "clock" )
+    {
+        // serve:port to be the reference, host:port to follow one
+        QString host( value.section( ':', 0, 0 ));
+        quint16 port( value.section( ':', 1 ).toUShort( &ok ));
+        if ( host == "serve" )
+        {
+            config->node.clockServe = port;
+        }
+        else
+        {
+            config->node.clockPeer = host;
+            config->node.clockPeerPort = port;
+        }
+    }
+    else if ( key == "stats" )
+    {
+        config->node.statsSeconds = value.toInt( &ok );
+    }
+    else if ( key == "preview" )
+    {
+        config->preview = value.toUShort( &ok );
+    }
+    else if ( key == "format" )
+    {
+        ok = parseFormat( value, &config->format );
+    }
+    else if ( key == "checkpoint" )
+    {
+        // path[:seconds]
+        config->node.checkpoint = value.section( ':', 0, 0 );
+        if ( value.contains( ':' ))
+        {
+            config->node.checkpointSeconds = value.section( ':', 1 ).toInt( &ok );
+            ok = ok && config->node.checkpointSeconds > 0;
+        }
+    }
+    else if ( key == "library" )
+    {
+        config->node.library = value;
+    }
+    else if ( key == "layout" )
+    {
+        // checked when the node builds it
+        config->node.layout = value;
+    }
+    else if ( key == "zones" )
+    {
+        // several joined with '+'
+        config->node.zones.clear( );
+        foreach ( const QString &spec, value.split( '+', SKIP_EMPTY ))
+        {
+            Zone::Config zone;
+            ok = ok && parseZone( spec, config->node.group, &zone );
+            config->node.zones.append( zone );
+        }
+    }
+    else if ( key == "transition" )
+    {
+        ok = parseTransition( value, &config->node.transition, &config->node.transitionMs );
+    }
+    else if ( key == "audio" )
+    {
+        // checked when the node opens it
+        config->node.audio = value;
+    }
+    else if ( key == "react" )
+    {
+        ok = parseReact( value, &config->node.audioReact );
+    }
+    else if ( key == "record" )
+    {
+        // every command received, for radiopixel-replay
+        config->node.record = value;
+    }
+    else
+    {
+        ok = false;
+    }
+
+    if ( !ok )
+    {
+        qCritical( ) << "bad strip setting" << key << "=" << value;
+    }
+    return ok;
+}
+
+// zones have to land on the strip, checked once every key is in since
+// length can come after zones
+static bool checkZones( const DeskNode::Config &node )
+{
+    foreach ( const Zone::Config &zone, node.zones )
+    {
+        if ( !zone.count || zone.first >= node.length || zone.count > node.length - zone.first )
+        {
+            qCritical( ) << "zone" << zone.name << "is off the end of the" << node.length << "pixel strip";
+            return false;
+        }
+    }
+    return true;
+}
+
+// "length=300,port=5100,sink=spi:/dev/spidev0.0"
+static bool parseStrip( const QString &spec, StripConfig *config )
+{
+    foreach ( const QString &item, spec.split( ',', SKIP_EMPTY ))
+    {
+        if ( !setKey( config, item.section( '=', 0, 0 ).trimmed( ),
+                      item.section( '=', 1 ).trimmed( )))
+        {
+            return false;
+        }
+    }
+    return checkZones( config->node );
+}
+
+// one ini group per strip, same keys as --strip
+static bool parseConfig( const QString &path, QList<StripConfig> *strips )
+{
+    QSettings settings( path, QSettings::IniFormat );
+    if ( settings.status( ) != QSettings::NoError )
+    {
+        qCritical( ) << "can't read" << path;
+        return false;
+    }
+
+    foreach ( const QString &group, settings.childGroups( ))
+    {
+        StripConfig config;
+        settings.beginGroup( group );
+        foreach ( const QString &key, settings.childKeys( ))
+        {
+            if ( !setKey( &config, key, settings.value( key ).toString( )))
+            {
+                return false;
+            }
+        }
+        settings.endGroup( );
+        if ( !checkZones( config.node ))
+        {
+            return false;
+        }
+        strips->append( config );
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    a.setOrganizationName( "Beardodrome");
+    a.setApplicationName( "RadioPixel");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription( "Headless RadioPixel node" );
+    parser.addHelpOption( );
+    QCommandLineOption configOption( "config",
+        "Ini file with a group per strip.", "file" );
+    QCommandLineOption stripOption( "strip",
+        "Add a strip, keys are length, port, group, broadcast, cloud, indexed, sink, format, preview, clock, stats, transition, zones, layout, library, checkpoint, audio, react and record.", "k=v,..." );
+    parser.addOption( configOption );
+    parser.addOption( stripOption );
+    parser.process( a );
+
+    QList<StripConfig> strips;
+    if ( parser.isSet( configOption ) &&
+         !parseConfig( parser.value( configOption ), &strips ))
+    {
+        return 1;
+    }
+    foreach ( const QString &spec, parser.values( stripOption ))
+    {
+        StripConfig config;
+        if ( !parseStrip( spec, &config ))
+        {
+            return 1;
+        }
+        strips.append( config );
+    }
+    if ( strips.isEmpty( ))
+    {
+        strips.append( StripConfig( ));
+    }
+
+    // nodes and sinks live as long as the app, every controlled group
+    // shares one broadcaster so they can share datagrams
+    Broadcaster *broadcaster = nullptr;
+    foreach ( StripConfig config, strips )
+    {
+        if ( config.broadcast >= 0 )
+        {
+            // a controller doesn't take orders from the LAN, its own
+            // broadcasts included
+            config.node.port = 0;
+        }
+        DeskNode *node = new DeskNode( config.node, &a );
+        if ( config.broadcast >= 0 )
+        {
+            if ( !broadcaster )
+            {
+                broadcaster = new Broadcaster( HN_PORT, QHostAddress::Broadcast, &a );
+            }
+            broadcaster->addGroup( config.broadcast, node );
+        }
+
+        // several sinks join with +, "spi:/dev/spidev0.0+ring:/desk0"
+        foreach ( const QString &sink, config.sink.split( '+', SKIP_EMPTY ))
+        {
+            if ( sink != "none" &&
+                 !OutputSink::create( sink, node->strip( ), config.format, node ))
+            {
+                return 1;
+            }
+        }
+
+        if ( config.preview )
+        {
+            PreviewServer *preview = new PreviewServer( node->strip( ), node );
+            if ( !preview->listen( config.preview ))
+            {
+                return 1;
+            }
+        }
+    }
+
+    return a.exec();
+}
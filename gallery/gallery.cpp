@@ -0,0 +1,360 @@
+// Pattern gallery. Renders a short clip of every combination of patterns,
+// color sets, levels and speeds on all cores, then writes a contact sheet
+// for lighting designers and a manifest with a hash of each clip for QA.
+//
+//   radiopixel-gallery --patterns 1-11,100,101 \
+//                      --colors ff0000/ffffff/00ff00,0000ff/ff00ff/000000 \
+//                      --levels 32,128,255 --speeds 35,100 sheet.png
+//
+// Each thumbnail has the strip across and time going down, a row per
+// sampled frame, in the sheet a row of thumbnails at a time. The manifest
+// has a line per clip in the same order:
+//   index pattern color0/color1/color2 level speed hash
+// where the hash is FNV-1a over every frame of the clip, not just the
+// sampled ones. Every clip's random( ) is seeded from its index, so the
+// hashes don't depend on which thread drew it.
+
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QImage>
+#include <QStringList>
+#include "Pattern.h"
+
+
+const uint64_t FNV_OFFSET = 0xcbf29ce484222325ull;
+const uint64_t FNV_PRIME = 0x100000001b3ull;
+const int GAP = 2; // between thumbnails
+const QRgb BACKGROUND = 0xff202020;
+const ms_t CLIP_FRAME_MS = 8; // the player's FRAME_MS
+
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 14, 0 )
+const auto SKIP_EMPTY = Qt::SkipEmptyParts;
+#else
+const auto SKIP_EMPTY = QString::SkipEmptyParts;
+#endif
+
+
+struct Clip
+{
+    uint8_t pattern;
+    uint32_t colors[ 3 ];
+    uint8_t level; // all three
+    uint8_t speed;
+};
+
+struct Gallery
+{
+    std::vector< Clip > clips;
+    pixel_t length;
+    ms_t duration;
+    int rows; // frames sampled per thumbnail
+    int scale; // sheet pixels per LED
+    int columns; // thumbnails across
+    uint32_t seed;
+
+    QImage sheet;
+    std::vector< uint64_t > hashes;
+};
+
+
+// "1-11,100", numbers and ranges of them up to max
+static bool parseList( const QString &spec, uint max, std::vector< uint > *values )
+{
+    values->clear( );
+    foreach ( const QString &item, spec.split( ',', SKIP_EMPTY ))
+    {
+        bool ok[ 2 ];
+        uint first( item.section( '-', 0, 0 ).toUInt( &ok[ 0 ], 0 ));
+        uint last( item.contains( '-' ) ? item.section( '-', 1 ).toUInt( &ok[ 1 ], 0 ) : first );
+        if ( !ok[ 0 ] || ( item.contains( '-' ) && !ok[ 1 ] ) || first > last || last > max )
+        {
+            return false;
+        }
+        for ( uint value = first; value <= last; ++value )
+        {
+            values->push_back( value );
+        }
+    }
+    return !values->empty( );
+}
+
+// "ff0000/ffffff/00ff00,0000ff", sets of up to three colors, short sets
+// repeat their last color
+static bool parseColors( const QString &spec, std::vector< std::vector< uint32_t > > *sets )
+{
+    sets->clear( );
+    foreach ( const QString &item, spec.split( ',', SKIP_EMPTY ))
+    {
+        QStringList names( item.split( '/' ));
+        if ( names.size( ) > 3 )
+        {
+            return false;
+        }
+        std::vector< uint32_t > set;
+        for ( int c = 0; c < 3; ++c )
+        {
+            bool ok;
+            set.push_back( names[ std::min( c, names.size( ) - 1 ) ].toUInt( &ok, 16 ));
+            if ( !ok || set.back( ) > 0xffffff )
+            {
+                return false;
+            }
+        }
+        sets->push_back( set );
+    }
+    return !sets->empty( );
+}
+
+static uint64_t fnv( uint64_t hash, const uint32_t *pixels, pixel_t count )
+{
+    for ( pixel_t i = 0; i < count; ++i )
+    {
+        uint32_t pixel( pixels[ i ] );
+        for ( int b = 0; b < 4; ++b )
+        {
+            hash = ( hash ^ ( ( pixel >> ( 8 * b )) & 0xff )) * FNV_PRIME;
+        }
+    }
+    return hash;
+}
+
+// one clip on a worker's strip, the way Player runs a pattern, straight
+// into its cell of the sheet
+static void render( Gallery *gallery, size_t index, Stripper *strip, QRgb *bits, int stride )
+{
+    const Clip &clip( gallery->clips[ index ] );
+    randomSeed( gallery->seed + index * 2654435761u );
+
+    // the strip comes from the last clip, start dark like a new one
+    strip->setAllColor( 0 );
+    Pattern *pattern( CreatePattern( clip.pattern ));
+    uint8_t levels[ 3 ] = { clip.level, clip.level, clip.level };
+    pattern->Init( strip, clip.colors, levels, 0 );
+    ms_t loop( pattern->GetDuration( strip ));
+
+    int column( index % gallery->columns ), line( index / gallery->columns );
+    int tileWidth( strip->numPixels( ) * gallery->scale ), tileHeight( gallery->rows * gallery->scale );
+    QRgb *tile( bits + ( GAP + line * ( tileHeight + GAP )) * stride + GAP + column * ( tileWidth + GAP ));
+
+    uint64_t hash( FNV_OFFSET );
+    int frames( gallery->duration / CLIP_FRAME_MS );
+    int row( 0 );
+    unsigned long lastCount( 0 );
+    for ( int frame = 0; frame <= frames; ++frame )
+    {
+        if ( frame )
+        {
+            ms_t elapsed( frame * CLIP_FRAME_MS * clip.speed / 100 );
+            unsigned long count( elapsed / loop );
+            if ( count != lastCount )
+            {
+                pattern->Loop( strip, elapsed % loop );
+            }
+            else
+            {
+                pattern->Update( strip, elapsed % loop );
+            }
+            lastCount = count;
+        }
+        const uint32_t *pixels( strip->getPixels( ));
+        hash = fnv( hash, pixels, strip->numPixels( ));
+
+        // sampled frames spread evenly down the thumbnail
+        while ( row < gallery->rows && frame >= ( long )row * frames / gallery->rows )
+        {
+            for ( int y = 0; y < gallery->scale; ++y )
+            {
+                QRgb *out( tile + ( row * gallery->scale + y ) * stride );
+                for ( pixel_t i = 0; i < strip->numPixels( ); ++i )
+                {
+                    for ( int x = 0; x < gallery->scale; ++x )
+                    {
+                        *out++ = 0xff000000 | pixels[ i ];
+                    }
+                }
+            }
+            ++row;
+        }
+    }
+    delete pattern;
+    gallery->hashes[ index ] = hash;
+}
+
+// every clip, each worker taking the next one with its own strip
+static void renderAll( Gallery *gallery, int threads )
+{
+    // detach once here, the workers only write their own cells
+    QRgb *bits( ( QRgb *)gallery->sheet.bits( ));
+    int stride( gallery->sheet.bytesPerLine( ) / sizeof( QRgb ));
+
+    std::atomic< size_t > next( 0 );
+    auto work = [ gallery, bits, stride, &next ]( )
+    {
+        Stripper strip( gallery->length, 0, 0 );
+        for ( size_t index = next++; index < gallery->clips.size( ); index = next++ )
+        {
+            render( gallery, index, &strip, bits, stride );
+        }
+    };
+    std::vector< std::thread > pool;
+    for ( int t = 1; t < threads; ++t )
+    {
+        pool.push_back( std::thread( work ));
+    }
+    work( );
+    for ( size_t t = 0; t < pool.size( ); ++t )
+    {
+        pool[ t ].join( );
+    }
+}
+
+int main( int argc, char *argv[] )
+{
+    QCoreApplication a( argc, argv );
+    QCommandLineParser parser;
+    parser.setApplicationDescription( "Render pattern clips to a contact sheet and a hash manifest." );
+    parser.addHelpOption( );
+    parser.addPositionalArgument( "sheet", "Contact sheet image to write, eg sheet.png." );
+    QCommandLineOption patternsOption( "patterns", "Pattern ids and ranges.", "list", "1-11,100,101" );
+    QCommandLineOption colorsOption( "colors", "Color sets, three hex colors joined with '/'.", "sets",
+                                     "ff0000/ffffff/00ff00" );
+    QCommandLineOption levelsOption( "levels", "Levels, 0 - 255.", "list", "128" );
+    QCommandLineOption speedsOption( "speeds", "Speeds, 0 - 255, 100 for as designed.", "list", "35,100" );
+    QCommandLineOption lengthOption( "length", "Pixels in the strip.", "n", "92" );
+    QCommandLineOption msOption( "ms", "Length of each clip.", "ms", "2000" );
+    QCommandLineOption rowsOption( "rows", "Frames sampled down each thumbnail.", "n", "16" );
+    QCommandLineOption scaleOption( "scale", "Sheet pixels per LED.", "n", "2" );
+    QCommandLineOption columnsOption( "columns", "Thumbnails across, 0 for about square.", "n", "0" );
+    QCommandLineOption seedOption( "seed", "Seed for the random patterns.", "n", "1" );
+    QCommandLineOption threadsOption( "threads", "Render workers, 0 for one per core.", "n", "0" );
+    QCommandLineOption manifestOption( "manifest", "Manifest to write, the sheet's name with .txt by default.", "file" );
+    parser.addOption( patternsOption );
+    parser.addOption( colorsOption );
+    parser.addOption( levelsOption );
+    parser.addOption( speedsOption );
+    parser.addOption( lengthOption );
+    parser.addOption( msOption );
+    parser.addOption( rowsOption );
+    parser.addOption( scaleOption );
+    parser.addOption( columnsOption );
+    parser.addOption( seedOption );
+    parser.addOption( threadsOption );
+    parser.addOption( manifestOption );
+    parser.process( a );
+    if ( parser.positionalArguments( ).size( ) != 1 )
+    {
+        parser.showHelp( 1 );
+    }
+
+    Gallery gallery;
+    std::vector< uint > patterns, levels, speeds;
+    std::vector< std::vector< uint32_t > > colors;
+    bool ok[ 8 ];
+    gallery.length = parser.value( lengthOption ).toUInt( &ok[ 0 ] );
+    gallery.duration = parser.value( msOption ).toUInt( &ok[ 1 ] );
+    gallery.rows = parser.value( rowsOption ).toInt( &ok[ 2 ] );
+    gallery.scale = parser.value( scaleOption ).toInt( &ok[ 3 ] );
+    gallery.columns = parser.value( columnsOption ).toInt( &ok[ 4 ] );
+    gallery.seed = parser.value( seedOption ).toUInt( &ok[ 5 ] );
+    int threads( parser.value( threadsOption ).toInt( &ok[ 6 ] ));
+    ok[ 7 ] = gallery.length && gallery.duration >= CLIP_FRAME_MS &&
+        gallery.rows > 0 && gallery.scale > 0 && gallery.columns >= 0 && threads >= 0;
+    for ( int i = 0; i < 8; ++i )
+    {
+        if ( !ok[ i ] )
+        {
+            fprintf( stderr, "bad number\n" );
+            return 1;
+        }
+    }
+    if ( !parseList( parser.value( patternsOption ), 255, &patterns ) ||
+         !parseColors( parser.value( colorsOption ), &colors ) ||
+         !parseList( parser.value( levelsOption ), 255, &levels ) ||
+         !parseList( parser.value( speedsOption ), 255, &speeds ))
+    {
+        fprintf( stderr, "bad patterns, colors, levels or speeds\n" );
+        return 1;
+    }
+
+    // patterns slowest changing, so each pattern's clips sit together
+    for ( size_t p = 0; p < patterns.size( ); ++p )
+    {
+        for ( size_t c = 0; c < colors.size( ); ++c )
+        {
+            for ( size_t l = 0; l < levels.size( ); ++l )
+            {
+                for ( size_t s = 0; s < speeds.size( ); ++s )
+                {
+                    Clip clip;
+                    clip.pattern = patterns[ p ];
+                    for ( int i = 0; i < 3; ++i )
+                    {
+                        clip.colors[ i ] = colors[ c ][ i ];
+                    }
+                    clip.level = levels[ l ];
+                    clip.speed = speeds[ s ];
+                    gallery.clips.push_back( clip );
+                }
+            }
+        }
+    }
+
+    // about square, columns * tileWidth = lines * tileHeight
+    int tileWidth( gallery.length * gallery.scale + GAP ), tileHeight( gallery.rows * gallery.scale + GAP );
+    if ( !gallery.columns )
+    {
+        gallery.columns = std::max( 1, ( int )ceil( sqrt( gallery.clips.size( ) * ( double )tileHeight / tileWidth )));
+    }
+    int lines( ( gallery.clips.size( ) + gallery.columns - 1 ) / gallery.columns );
+    gallery.sheet = QImage( GAP + gallery.columns * tileWidth, GAP + lines * tileHeight, QImage::Format_RGB32 );
+    if ( gallery.sheet.isNull( ))
+    {
+        fprintf( stderr, "sheet too big\n" );
+        return 1;
+    }
+    gallery.sheet.fill( BACKGROUND );
+    gallery.hashes.resize( gallery.clips.size( ));
+
+    if ( !threads )
+    {
+        threads = std::max( 1u, std::thread::hardware_concurrency( ));
+    }
+    std::chrono::steady_clock::time_point start( std::chrono::steady_clock::now( ));
+    renderAll( &gallery, threads );
+    double seconds( std::chrono::duration< double >( std::chrono::steady_clock::now( ) - start ).count( ));
+
+    QString sheetPath( parser.positionalArguments( ).first( ));
+    if ( !gallery.sheet.save( sheetPath ))
+    {
+        fprintf( stderr, "can't write %s\n", qPrintable( sheetPath ));
+        return 1;
+    }
+    QFileInfo sheetInfo( sheetPath );
+    QString manifestPath( parser.isSet( manifestOption ) ? parser.value( manifestOption ) :
+                          sheetInfo.path( ) + "/" + sheetInfo.completeBaseName( ) + ".txt" );
+    FILE *manifest( fopen( qPrintable( manifestPath ), "w" ));
+    if ( !manifest )
+    {
+        fprintf( stderr, "can't write %s\n", qPrintable( manifestPath ));
+        return 1;
+    }
+    for ( size_t i = 0; i < gallery.clips.size( ); ++i )
+    {
+        const Clip &clip( gallery.clips[ i ] );
+        fprintf( manifest, "%zu %u %06x/%06x/%06x %u %u %016llx\n", i, clip.pattern,
+                 clip.colors[ 0 ], clip.colors[ 1 ], clip.colors[ 2 ], clip.level, clip.speed,
+                 ( unsigned long long )gallery.hashes[ i ] );
+    }
+    fclose( manifest );
+
+    printf( "%zu clips on %d threads in %.2f s\n", gallery.clips.size( ), threads, seconds );
+    return 0;
+}
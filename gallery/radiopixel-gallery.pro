@@ -0,0 +1,27 @@
+QT       = core gui
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = radiopixel-gallery
+
+PROTOCOL_DIR = $$PWD/../../radiopixel-protocol
+
+INCLUDEPATH += $$PWD/.. $$PROTOCOL_DIR
+
+SOURCES += \
+    gallery.cpp \
+    ../Gradient.cpp \
+    ../Layout.cpp \
+    ../Pattern.cpp \
+    ../StripBase.cpp \
+    ../Stripper.cpp
+
+HEADERS += \
+    ../Audio.h \
+    ../Gradient.h \
+    ../Layout.h \
+    ../Pattern.h \
+    ../PatternRegistry.h \
+    ../StripBase.h \
+    ../Stripper.h
@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include "Golden.h"
+#include "MeshSim.h"
+
+
+const uint64_t FNV_OFFSET = 0xcbf29ce484222325ull;
+const uint64_t FNV_PRIME = 0x100000001b3ull;
+
+// the packets run's commands leave some brightness to scale
+const uint8_t PACKET_MIN_BRIGHTNESS = 32;
+
+
+// millis( ) for the run, moved on by the loop
+class SimClock : public Clock
+{
+public:
+    SimClock( ) : now( 0 ) {}
+
+    virtual ms_t Now( ) { return now; }
+
+    ms_t now;
+};
+
+static uint64_t fnv( uint64_t hash, const void *data, size_t size )
+{
+    const uint8_t *bytes( ( const uint8_t *)data );
+    for ( size_t i = 0; i < size; ++i )
+    {
+        hash = ( hash ^ bytes[ i ] ) * FNV_PRIME;
+    }
+    return hash;
+}
+
+Golden::Config::Config( )
+    : length( 92 ), duration( 60 * 60 * 1000 ), commandMs( 20 * 1000 ), seed( 1 )
+{
+}
+
+Golden::Golden( const Config &config )
+    : m_config( config ), m_frames( 0 )
+{
+}
+
+std::vector< std::string > Golden::Runs( )
+{
+    std::vector< std::string > runs;
+    runs.push_back( "idle" );
+    runs.push_back( "alert" );
+    runs.push_back( "random" );
+    runs.push_back( "packets" );
+    return runs;
+}
+
+std::vector< uint64_t > Golden::Run( const std::string &name )
+{
+    // simulated time for anything reading millis( ), and the same random( )
+    SimClock clock;
+    Clock *wall( SetClock( &clock ));
+    randomSeed( m_config.seed );
+    std::mt19937 commands( m_config.seed );
+
+    Stripper strip( m_config.length, 0, 0 );
+    Player player;
+    IdleSequence idle;
+    AlertSequence alert;
+    RandomSequence randm;
+    RadioPixel::Command packet;
+    memset( &packet, 0, sizeof packet );
+    PacketSequence packets( &packet );
+    bool received( name == "packets" );
+    player.SetSequence( ( name == "alert" ) ? ( Sequence *)&alert :
+                        ( name == "random" ) ? ( Sequence *)&randm : &idle, 0 );
+
+    // hash what is shown as it changes, so the run doesn't depend on how
+    // often the player asks to be woken when nothing does
+    std::vector< uint32_t > shown( m_config.length + 1, 0 );
+    std::vector< uint32_t > frame( m_config.length + 1 );
+    std::vector< uint32_t > scratch( m_config.length );
+    std::vector< uint64_t > seconds;
+    uint64_t hash( FNV_OFFSET );
+    ms_t nextCommand( 0 );
+    ms_t now( 0 );
+    while ( now < m_config.duration )
+    {
+        clock.now = now;
+        if ( received && now >= nextCommand )
+        {
+            RandomCommand( commands, &packet, PACKET_MIN_BRIGHTNESS );
+            player.SetSequence( &packets, now );
+            nextCommand = now + m_config.commandMs;
+        }
+
+        // the desk node's wake( )
+        player.UpdatePattern( now, &strip );
+        player.UpdateStrip( now, &strip );
+
+        // what the sinks see, after effects
+        memcpy( frame.data( ), strip.getColors( 0, m_config.length, scratch.data( ) ),
+            m_config.length * sizeof( uint32_t ));
+        frame[ m_config.length ] = strip.getBrightness( );
+        if ( frame != shown )
+        {
+            hash = fnv( hash, &now, sizeof now );
+            hash = fnv( hash, frame.data( ), frame.size( ) * sizeof( uint32_t ));
+            shown.swap( frame );
+            ++m_frames;
+        }
+
+        ms_t next( player.GetNextUpdate( now, &strip ));
+        if ( received )
+        {
+            next = std::min( next, nextCommand );
+        }
+        next = std::min( std::max( next, now + 1 ), m_config.duration );
+
+        // seconds with nothing new keep the hash they had
+        while ( ( seconds.size( ) + 1 ) * 1000 <= next )
+        {
+            seconds.push_back( hash );
+        }
+        now = next;
+    }
+
+    SetClock( wall );
+    return seconds;
+}
+
+std::string Golden::Header( const std::string &name ) const
+{
+    std::ostringstream header;
+    header << "# radiopixel golden " << name << " length " << m_config.length <<
+              " ms " << m_config.duration << " command " << m_config.commandMs <<
+              " seed " << m_config.seed;
+    return header.str( );
+}
+
+bool Golden::Record( const std::string &dir )
+{
+    std::ostringstream report;
+    bool ok( true );
+    std::vector< std::string > runs( Runs( ));
+    for ( size_t r = 0; r < runs.size( ); ++r )
+    {
+        m_frames = 0;
+        std::vector< uint64_t > seconds( Run( runs[ r ] ));
+        std::string path( dir + "/" + runs[ r ] + ".golden" );
+        FILE *file( fopen( path.c_str( ), "w" ));
+        if ( !file )
+        {
+            report << runs[ r ] << ": can't write " << path << "\n";
+            ok = false;
+            continue;
+        }
+        fprintf( file, "%s\n", Header( runs[ r ] ).c_str( ));
+        for ( size_t s = 0; s < seconds.size( ); ++s )
+        {
+            fprintf( file, "%zu %016llx\n", s, ( unsigned long long )seconds[ s ] );
+        }
+        fclose( file );
+        report << runs[ r ] << ": recorded " << seconds.size( ) << " s, " << m_frames << " frames\n";
+    }
+    m_report = report.str( );
+    return ok;
+}
+
+bool Golden::Check( const std::string &dir )
+{
+    std::ostringstream report;
+    bool ok( true );
+    std::vector< std::string > runs( Runs( ));
+    for ( size_t r = 0; r < runs.size( ); ++r )
+    {
+        std::string path( dir + "/" + runs[ r ] + ".golden" );
+        FILE *file( fopen( path.c_str( ), "r" ));
+        if ( !file )
+        {
+            report << runs[ r ] << ": no " << path << ", record it first\n";
+            ok = false;
+            continue;
+        }
+        char line[ 256 ];
+        std::string header( fgets( line, sizeof line, file ) ? line : "" );
+        if ( header != Header( runs[ r ] ) + "\n" )
+        {
+            fclose( file );
+            report << runs[ r ] << ": " << path << " was recorded with other settings\n";
+            ok = false;
+            continue;
+        }
+        std::vector< uint64_t > golden;
+        size_t second;
+        unsigned long long hash;
+        while ( fscanf( file, "%zu %llx", &second, &hash ) == 2 && second == golden.size( ))
+        {
+            golden.push_back( hash );
+        }
+        fclose( file );
+
+        m_frames = 0;
+        std::vector< uint64_t > seconds( Run( runs[ r ] ));
+        size_t same( 0 );
+        while ( same < seconds.size( ) && same < golden.size( ) && seconds[ same ] == golden[ same ] )
+        {
+            ++same;
+        }
+        if ( same < seconds.size( ) || same < golden.size( ))
+        {
+            report << runs[ r ] << ": differs from " << same << " s\n";
+            ok = false;
+        }
+        else
+        {
+            report << runs[ r ] << ": matches, " << seconds.size( ) << " s, " << m_frames << " frames\n";
+        }
+    }
+    m_report = report.str( );
+    return ok;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Player.h"
+
+
+// Golden frame regression runs. Each run plays one of the stock sequences,
+// or a seeded stream of received commands, through a Player on a simulated
+// clock for an hour as fast as it renders, and hashes every frame it draws.
+// Recording writes the hashes to a file per run; checking renders again
+// and reports the first second that no longer matches. Work on the color
+// math or patterns that shouldn't change the output can be checked with
+// it, and work that should can be re-recorded. The files for the default
+// settings are checked in next to this, so radiopixel-golden --check golden
+// run from the source tree checks against them.
+class Golden
+{
+public:
+    struct Config
+    {
+        Config( );
+
+        pixel_t length;
+        ms_t duration; // simulated time per run
+        ms_t commandMs; // a new command this often in the packet run
+        uint32_t seed; // for random( ) and the commands
+    };
+
+    Golden( const Config &config );
+
+    //! names of the runs, also their file names
+    static std::vector< std::string > Runs( );
+
+    //! render a run, returns the running hash at the end of each second
+    std::vector< uint64_t > Run( const std::string &name );
+
+    //! write every run's file in dir
+    bool Record( const std::string &dir );
+
+    //! render every run and compare with its file in dir, true if all match
+    bool Check( const std::string &dir );
+
+    //! human readable results of the last Record or Check
+    std::string Report( ) const { return m_report; }
+
+private:
+    // the header line of a run's file, so files from other settings don't match
+    std::string Header( const std::string &name ) const;
+
+    Config m_config;
+    std::string m_report;
+    uint64_t m_frames;
+};
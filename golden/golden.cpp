@@ -0,0 +1,38 @@
+// Golden frame regression runs, see Golden.h.
+//
+//   radiopixel-golden --check golden
+//   radiopixel-golden --record golden
+//
+// Exits 2 if a run no longer matches its file.
+
+#include <stdio.h>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include "Golden.h"
+
+
+int main( int argc, char *argv[] )
+{
+    QCoreApplication a( argc, argv );
+    QCommandLineParser parser;
+    parser.setApplicationDescription( "Render each stock sequence for a simulated hour and check its frame hashes." );
+    parser.addHelpOption( );
+    QCommandLineOption recordOption( "record",
+        "Write each run's frame hashes to dir.", "dir" );
+    QCommandLineOption checkOption( "check",
+        "Compare each run with the hashes in dir.", "dir" );
+    parser.addOption( recordOption );
+    parser.addOption( checkOption );
+    parser.process( a );
+    if ( parser.isSet( recordOption ) == parser.isSet( checkOption ))
+    {
+        parser.showHelp( 1 );
+    }
+
+    Golden golden( ( Golden::Config( )));
+    bool ok( parser.isSet( recordOption ) ?
+             golden.Record( parser.value( recordOption ).toStdString( )) :
+             golden.Check( parser.value( checkOption ).toStdString( )));
+    fputs( golden.Report( ).c_str( ), stdout );
+    return ok ? 0 : 2;
+}
@@ -1,43 +1,29 @@
+#include <algorithm>
 #include <cmath>
 #include <utility>
 #include <QApplication>
-#include <QHostAddress>
 #include <QPainter>
 #include <QSettings>
-#include <QTimer>
-#include "radiopixel_protocol.h"
 #include "mainwindow.h"
 
 
+// node settings, a 2D layout can be set as eg "serpentine:16x16"
+static DeskNode::Config nodeConfig( )
+{
+    DeskNode::Config config;
+    config.layout = QSettings( ).value( "layout" ).toString( );
+    return config;
+}
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
-      m_strip( STRIP_LENGTH, 0, 0 ),
-      m_recvSequence( &m_recvPacket )
+      m_node( nodeConfig( ) ),
+      m_tilesWide( 0 ), m_tilesHigh( 0 )
 {
     // when strip signals, we repaint
-    connect( &m_strip, SIGNAL( show()),
+    connect( m_node.strip( ), SIGNAL( show()),
              this, SLOT( update()));
 
-    // connect the LAN socket
-    m_lanSocket.bind( HN_PORT, QAbstractSocket::ShareAddress );
-    connect( &m_lanSocket, SIGNAL( readyRead()),
-             this, SLOT( onLanRecv()));
-
-    // connect the cloud socket
-    connect( &m_cloudSocket, SIGNAL( readyRead()),
-             this, SLOT( onCloudRecv()));
-    QTimer *connectTimer = new QTimer( this );
-    connect( connectTimer, SIGNAL(timeout()),
-             this, SLOT(onCloudReconnect()));
-    connectTimer->start( 30 * 1000 );
-    onCloudReconnect();
-
-    // start a timer
-    startTimer( 25 );
-
-    // start idle pattern
-    m_player.SetSequence( &m_idle );
-
     // restore saved geometry
     if ( !( QApplication::keyboardModifiers() & Qt::ControlModifier ) )
     {
@@ -50,43 +36,6 @@ MainWindow::~MainWindow()
 {
 }
 
-void MainWindow::onLanRecv()
-{
-    while ( m_lanSocket.hasPendingDatagrams())
-    {
-        m_lanSocket.readDatagram( ( char *)&m_recvPacket, sizeof m_recvPacket );
-        m_player.SetSequence( &m_recvSequence );
-    }
-}
-
-void MainWindow::onCloudReconnect()
-{
-    if ( m_cloudSocket.state() == QTcpSocket::UnconnectedState )
-    {
-        m_cloudSocket.connectToHost( "hats.blynch.net", 8100 );
-    }
-}
-
-void MainWindow::onCloudRecv()
-{
-    while ( m_cloudSocket.bytesAvailable())
-    {
-        m_cloudSocket.read( ( char *)&m_recvPacket, sizeof m_recvPacket );
-        m_player.SetSequence( &m_recvSequence );
-    }
-}
-
-void MainWindow::timerEvent(QTimerEvent *event)
-{
-    ms_t now = millis( );
-
-    if ( m_player.UpdatePattern( now, &m_strip ) )
-    {
-        //lastTransmit = 0;
-    }
-    m_player.UpdateStrip( now, &m_strip );
-}
-
 int srgbToLinear( int in )
 {
     static std::vector<int> lut;
@@ -119,19 +68,48 @@ void MainWindow::paintEvent(QPaintEvent *event)
 
     p.fillRect( rect(), QBrush( QColor( 0, 0, 0)));
 
-    const int sz = 30;
-    int w( width() / sz);
-    int h( height() / sz);
+    Stripper &strip( *m_node.strip( ));
+    uint8_t bright( strip.getBrightness());
+    pixel_t pixels( strip.numPixels());
+
+    // what the sinks send, effects and zones and all
+    m_scratch.resize( pixels );
+    const uint32_t *colors( strip.getColors( 0, pixels, m_scratch.data( )));
+
+    // the layout's grid as big as fits, else the strip tiled over the window
+    const Layout *layout( strip.getLayout( ));
+    int sz, w, h;
+    const pixel_t *cells;
+    if ( layout )
+    {
+        w = layout->width( );
+        h = layout->height( );
+        sz = std::max( 1, std::min( width() / w, height() / h ));
+        cells = layout->grid( );
+    }
+    else
+    {
+        sz = 30;
+        w = width() / sz;
+        h = height() / sz;
+        if ( w != m_tilesWide || h != m_tilesHigh )
+        {
+            tile( w, h, pixels );
+        }
+        cells = m_tiles.data( );
+    }
 
-    uint8_t bright( m_strip.getBrightness());
-    uint16_t pixels( m_strip.numPixels());
     for ( int x = 0; x < w; x++ )
     {
         for ( int y = 0; y < h; y++ )
         {
-            int pixel = ( w > h ) ? ( y * w + x ) : ( x * h + y );
+            pixel_t pixel( cells[ y * w + x ] );
+            if ( pixel >= pixels )
+            {
+                continue;
+            }
 
-            QRgb color( m_strip.getPixelColor( pixel % pixels ));
+            QRgb color( colors[ pixel ] );
             QRgb mult( Stripper::ColorFade( color, bright));
             QRgb scaled( qRgb( srgbToLinear(qRed(mult)), srgbToLinear(qGreen(mult)), srgbToLinear(qBlue(mult))));
             p.setBrush( QBrush( QColor( scaled)));
@@ -140,6 +118,22 @@ void MainWindow::paintEvent(QPaintEvent *event)
     }
 }
 
+void MainWindow::tile( int w, int h, pixel_t pixels )
+{
+    // along the longer side, wrapping the strip as often as it takes
+    m_tiles.resize( w * h );
+    for ( int x = 0; x < w; x++ )
+    {
+        for ( int y = 0; y < h; y++ )
+        {
+            int pixel = ( w > h ) ? ( y * w + x ) : ( x * h + y );
+            m_tiles[ y * w + x ] = pixel % pixels;
+        }
+    }
+    m_tilesWide = w;
+    m_tilesHigh = h;
+}
+
 void MainWindow::closeEvent(QCloseEvent *event)
 {
     QSettings settings;
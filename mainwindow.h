@@ -1,11 +1,10 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
-#include <QUdpSocket>
-#include <QTcpSocket>
+#include <vector>
 #include <QMainWindow>
 
-#include "Player.h"
+#include "DeskNode.h"
 
 
 class MainWindow : public QMainWindow
@@ -17,32 +16,18 @@ public:
     ~MainWindow();
 
 protected:
-    void timerEvent(QTimerEvent *event) override;
     void paintEvent(QPaintEvent *event) override;
     void closeEvent(QCloseEvent *event) override;
 
-private slots:
-    void onLanRecv();
-    void onCloudReconnect();
-    void onCloudRecv();
-
 private:
-    const int STRIP_LENGTH = 92;
-
-    Stripper m_strip;
-
-    // patterns
-
-    Player m_player;
-    IdleSequence m_idle;
-    AlertSequence m_alert;
-    RandomSequence m_randm;
-
-    QUdpSocket m_lanSocket;
+    // map window cells to pixels for a strip with no layout
+    void tile( int w, int h, pixel_t pixels );
 
-    QTcpSocket m_cloudSocket;
+    DeskNode m_node;
 
-    RadioPixel::Command m_recvPacket; // last packet received
-    PacketSequence m_recvSequence;
+    std::vector< pixel_t > m_tiles; // pixel per cell, row after row
+    std::vector< uint32_t > m_scratch; // getColors( ) expands zones into this
+    int m_tilesWide;
+    int m_tilesHigh;
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,102 @@
+// Radio mesh simulator, see MeshSim.h.
+//
+//   radiopixel-mesh nodes=64,loss=0.1,latency=5,jitter=3,seconds=60
+//
+// Reports convergence and phase spread, and exits 2 if some command never
+// converged.
+
+#include <stdio.h>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QStringList>
+#include "MeshSim.h"
+
+
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 14, 0 )
+const auto SKIP_EMPTY = Qt::SkipEmptyParts;
+#else
+const auto SKIP_EMPTY = QString::SkipEmptyParts;
+#endif
+
+
+static bool parseMesh( const QString &spec, MeshSim::Config *config )
+{
+    foreach ( const QString &item, spec.split( ',', SKIP_EMPTY ))
+    {
+        QString key( item.section( '=', 0, 0 ).trimmed( ));
+        QString value( item.section( '=', 1 ).trimmed( ));
+        bool ok( true );
+        if ( key == "nodes" )
+        {
+            config->nodes = value.toInt( &ok );
+        }
+        else if ( key == "length" )
+        {
+            config->length = value.toUInt( &ok );
+        }
+        else if ( key == "loss" )
+        {
+            config->loss = value.toDouble( &ok );
+        }
+        else if ( key == "latency" )
+        {
+            config->latency = value.toUInt( &ok );
+        }
+        else if ( key == "jitter" )
+        {
+            config->jitter = value.toUInt( &ok );
+        }
+        else if ( key == "seconds" )
+        {
+            config->duration = value.toUInt( &ok ) * 1000;
+        }
+        else if ( key == "change" )
+        {
+            config->changeMs = value.toUInt( &ok );
+        }
+        else if ( key == "transmit" )
+        {
+            config->transmitMs = value.toUInt( &ok );
+        }
+        else if ( key == "seed" )
+        {
+            config->seed = value.toUInt( &ok );
+        }
+        else if ( key == "threads" )
+        {
+            config->threads = value.toInt( &ok );
+        }
+        else if ( key == "epochs" )
+        {
+            config->epochs = ( value == "1" || value == "true" );
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if ( !ok )
+        {
+            qCritical( ) << "bad mesh setting" << key << "=" << value;
+            return false;
+        }
+    }
+    return config->changeMs && config->duration;
+}
+
+int main( int argc, char *argv[] )
+{
+    QCoreApplication a( argc, argv );
+    MeshSim::Config config;
+    if ( argc > 2 || ( argc == 2 && !parseMesh( argv[ 1 ], &config )))
+    {
+        fprintf( stderr, "usage: %s [k=v,...]\n"
+                         "keys are nodes, length, loss, latency, jitter, seconds, change, transmit,\n"
+                         "seed, threads and epochs\n", argv[ 0 ] );
+        return 1;
+    }
+    MeshSim mesh( config );
+    bool converged( mesh.Run( ));
+    fputs( mesh.Report( ).c_str( ), stdout );
+    return converged ? 0 : 2;
+}
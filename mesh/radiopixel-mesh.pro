@@ -0,0 +1,29 @@
+QT       = core
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = radiopixel-mesh
+
+PROTOCOL_DIR = $$PWD/../../radiopixel-protocol
+
+INCLUDEPATH += $$PWD/.. $$PROTOCOL_DIR
+
+SOURCES += \
+    mesh.cpp \
+    ../Effects.cpp \
+    ../Gradient.cpp \
+    ../Layout.cpp \
+    ../MeshSim.cpp \
+    ../Pattern.cpp \
+    ../Player.cpp \
+    ../Sequence.cpp \
+    ../StripBase.cpp \
+    ../Stripper.cpp \
+    ../Transition.cpp \
+    $$PROTOCOL_DIR/radiopixel_protocol.cpp
+
+HEADERS += \
+    ../MeshSim.h \
+    ../Player.h \
+    ../StripBase.h
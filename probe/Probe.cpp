@@ -0,0 +1,127 @@
+#include <string.h>
+#include <QDebug>
+#include <QHostAddress>
+#include <QTimerEvent>
+#include "radiopixel_protocol.h"
+#include "DeskNode.h"
+#include "Probe.h"
+
+
+const int PROBE_SYNC_MS = 2500; // past the clock's fast pings, before the probe trusts it
+const int PROBE_SAMPLE_MS = 20;
+const int PROBE_SAMPLES = 100;
+
+
+LatencyProbe::LatencyProbe( DeskNode *node, quint16 port, int commands, QObject *parent )
+    : QObject( parent ),
+      m_node( node ), m_port( port ), m_commands( commands ), m_sent( 0 ), m_timer( 0 )
+{
+}
+
+void LatencyProbe::start( int intervalMs )
+{
+    m_node->latency( ).clear( );
+    m_timer = startTimer( intervalMs, Qt::PreciseTimer );
+}
+
+void LatencyProbe::timerEvent( QTimerEvent *event )
+{
+    if ( event->timerId( ) != m_timer )
+    {
+        return;
+    }
+
+    if ( m_sent == m_commands )
+    {
+        // the last command had a whole interval to land
+        killTimer( m_timer );
+        qInfo( ).noquote( ) << "latency" << m_node->latency( ).summary( );
+        emit finished( );
+        return;
+    }
+
+    // every command changes the color so every one makes a new frame
+    RadioPixel::Command command;
+    memset( &command, 0, sizeof command );
+    command.command = HC_PATTERN;
+    command.brightness = 255;
+    command.speed = 100;
+    command.pattern = RadioPixel::Command::Fixed;
+    command.color[ 0 ] = ( m_sent & 1 ) ? 0xff0000 : 0x0000ff;
+    command.level[ 0 ] = 255;
+    m_socket.writeDatagram( ( const char *)&command, sizeof command,
+                            QHostAddress::LocalHost, m_port );
+    ++m_sent;
+}
+
+//-------------------------------------------------------------
+
+PhaseProbe::PhaseProbe( DeskNode *reference, DeskNode *follower, QObject *parent )
+    : QObject( parent ),
+      m_reference( reference ), m_follower( follower ),
+      m_timer( 0 ), m_samples( -1 ), m_maxError( 0 ), m_totalError( 0 )
+{
+}
+
+void PhaseProbe::start( )
+{
+    m_timer = startTimer( PROBE_SYNC_MS, Qt::PreciseTimer );
+}
+
+void PhaseProbe::timerEvent( QTimerEvent *event )
+{
+    if ( event->timerId( ) != m_timer )
+    {
+        return;
+    }
+
+    if ( m_samples < 0 )
+    {
+        // synced, or as synced as it gets; start both on one epoch
+        RadioPixel::Command command;
+        memset( &command, 0, sizeof command );
+        command.command = HC_PATTERN;
+        command.brightness = 255;
+        command.speed = 100;
+        command.pattern = RadioPixel::Command::March;
+        command.color[ 0 ] = 0xff0000;
+        command.color[ 1 ] = 0x00ff00;
+        command.level[ 0 ] = 255;
+        command.level[ 1 ] = 255;
+        ms_t epoch( m_reference->now( ));
+        m_reference->inject( command, epoch );
+        m_follower->inject( command, epoch );
+
+        killTimer( m_timer );
+        m_timer = startTimer( PROBE_SAMPLE_MS, Qt::PreciseTimer );
+        m_samples = 0;
+        return;
+    }
+
+    // both clocks read at the same instant, so the phases should agree
+    ms_t loop( 0 );
+    ms_t a( m_reference->player( )->GetPhase( m_reference->now( ), m_reference->strip( ), &loop ));
+    ms_t b( m_follower->player( )->GetPhase( m_follower->now( ), m_follower->strip( )));
+    ms_t error( a > b ? a - b : b - a );
+    if ( loop && error > loop / 2 )
+    {
+        error = loop - error; // wrapped
+    }
+    m_maxError = qMax( m_maxError, error );
+    m_totalError += error;
+
+    if ( ++m_samples == PROBE_SAMPLES )
+    {
+        killTimer( m_timer );
+        ClockSync *clock( m_follower->clock( ));
+        qInfo( ).noquote( ) << QString( "phase error mean %1 ms max %2 ms ( %3 frames ), "
+                                        "skew %4 ms corrected by %5 ms, round trip %6 ms" )
+            .arg( m_totalError / m_samples, 0, 'f', 2 )
+            .arg( m_maxError )
+            .arg( m_maxError / ( double )FRAME_MS, 0, 'f', 2 )
+            .arg( -clock->offset( ))
+            .arg( clock->offset( ))
+            .arg( clock->delay( ));
+        emit finished( );
+    }
+}
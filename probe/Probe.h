@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QObject>
+#include <QUdpSocket>
+#include "Player.h"
+
+class DeskNode;
+
+
+// Fires commands at a node over loopback and reports how long each took
+// to reach show( )
+class LatencyProbe : public QObject
+{
+    Q_OBJECT
+
+public:
+    LatencyProbe( DeskNode *node, quint16 port, int commands, QObject *parent = nullptr );
+
+    void start( int intervalMs );
+
+signals:
+    void finished( );
+
+protected:
+    void timerEvent( QTimerEvent *event ) override;
+
+private:
+    DeskNode *m_node;
+    quint16 m_port;
+    int m_commands;
+    int m_sent;
+    int m_timer;
+    QUdpSocket m_socket;
+};
+
+
+// Two nodes on loopback, one following the other's clock from a skewed
+// local clock. Once synced both get the same command and epoch, and the
+// probe reports how far apart their pattern phases are
+class PhaseProbe : public QObject
+{
+    Q_OBJECT
+
+public:
+    PhaseProbe( DeskNode *reference, DeskNode *follower, QObject *parent = nullptr );
+
+    void start( );
+
+signals:
+    void finished( );
+
+protected:
+    void timerEvent( QTimerEvent *event ) override;
+
+private:
+    DeskNode *m_reference;
+    DeskNode *m_follower;
+    int m_timer;
+    int m_samples;
+    ms_t m_maxError;
+    double m_totalError;
+};
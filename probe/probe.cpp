@@ -0,0 +1,80 @@
+// Loopback probes against desk nodes in this process, see Probe.h.
+//
+//   radiopixel-probe --latency 500 --length 300
+//   radiopixel-probe --phase 250
+//
+// The latency probe reports command-to-frame p50 / p99, the phase probe
+// how far a follower with its clock off by skew ms animates from its
+// reference once synced.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include "radiopixel_protocol.h"
+#include "DeskNode.h"
+#include "Probe.h"
+
+
+int main( int argc, char *argv[] )
+{
+    QCoreApplication a( argc, argv );
+    QCommandLineParser parser;
+    parser.setApplicationDescription( "Probe desk nodes over loopback and report." );
+    parser.addHelpOption( );
+    QCommandLineOption latencyOption( "latency",
+        "Send commands to a node, report p50/p99 and exit.", "commands" );
+    QCommandLineOption phaseOption( "phase",
+        "Sync two nodes, one with its clock off by skew ms, report their phase error and exit.", "skew" );
+    QCommandLineOption lengthOption( "length", "Pixels in the latency probe's strip.", "n",
+                                     QString::number( DeskNode::Config( ).length ));
+    QCommandLineOption portOption( "port", "Loopback port the latency probe's node listens on.", "port",
+                                   QString::number( HN_PORT ));
+    parser.addOption( latencyOption );
+    parser.addOption( phaseOption );
+    parser.addOption( lengthOption );
+    parser.addOption( portOption );
+    parser.process( a );
+
+    if ( parser.isSet( latencyOption ) == parser.isSet( phaseOption ))
+    {
+        parser.showHelp( 1 );
+    }
+
+    if ( parser.isSet( latencyOption ))
+    {
+        // nothing from the cloud to skew it
+        DeskNode::Config config;
+        bool ok[ 2 ];
+        config.length = parser.value( lengthOption ).toUInt( &ok[ 0 ] );
+        config.port = parser.value( portOption ).toUShort( &ok[ 1 ] );
+        config.cloudHost.clear( );
+        if ( !ok[ 0 ] || !ok[ 1 ] || !config.length || !config.port )
+        {
+            parser.showHelp( 1 );
+        }
+        DeskNode node( config );
+        LatencyProbe probe( &node, config.port, parser.value( latencyOption ).toInt( ));
+        QObject::connect( &probe, SIGNAL( finished()),
+                          &a, SLOT( quit()));
+        probe.start( 20 );
+        return a.exec( );
+    }
+
+    const quint16 CLOCK_PORT = HN_PORT + 2;
+    DeskNode::Config config;
+    config.port = 0;
+    config.cloudHost.clear( );
+    config.clockServe = CLOCK_PORT;
+    DeskNode reference( config );
+
+    config.clockServe = 0;
+    config.clockPeer = "127.0.0.1";
+    config.clockPeerPort = CLOCK_PORT;
+    config.clockSkew = parser.value( phaseOption ).toInt( );
+    DeskNode follower( config );
+
+    PhaseProbe probe( &reference, &follower );
+    QObject::connect( &probe, SIGNAL( finished()),
+                      &a, SLOT( quit()));
+    probe.start( );
+    return a.exec( );
+}
@@ -0,0 +1,48 @@
+QT       = core network
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = radiopixel-probe
+
+PROTOCOL_DIR = $$PWD/../../radiopixel-protocol
+
+INCLUDEPATH += $$PWD/.. $$PROTOCOL_DIR
+
+# the nodes' audio=alsa:device, where ALSA is installed
+linux:packagesExist(alsa) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += alsa
+    DEFINES += RADIOPIXEL_ALSA
+}
+
+SOURCES += \
+    probe.cpp \
+    Probe.cpp \
+    ../Audio.cpp \
+    ../Broadcaster.cpp \
+    ../Checkpoint.cpp \
+    ../ClockSync.cpp \
+    ../CommandLog.cpp \
+    ../DeskNode.cpp \
+    ../Effects.cpp \
+    ../Gradient.cpp \
+    ../Latency.cpp \
+    ../Layout.cpp \
+    ../Pattern.cpp \
+    ../Player.cpp \
+    ../Sequence.cpp \
+    ../SequenceLibrary.cpp \
+    ../StripBase.cpp \
+    ../Stripper.cpp \
+    ../Transition.cpp \
+    ../Zone.cpp \
+    $$PROTOCOL_DIR/radiopixel_protocol.cpp
+
+HEADERS += \
+    Probe.h \
+    ../Broadcaster.h \
+    ../ClockSync.h \
+    ../DeskNode.h \
+    ../SequenceLibrary.h \
+    ../StripBase.h
@@ -0,0 +1,78 @@
+QT       = core network
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+PROTOCOL_DIR = $$PWD/../radiopixel-protocol
+
+INCLUDEPATH += $$PROTOCOL_DIR
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# live capture for audio=alsa:device, where ALSA is installed
+linux:packagesExist(alsa) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += alsa
+    DEFINES += RADIOPIXEL_ALSA
+}
+
+# shm_open for the frame ring
+linux: LIBS += -lrt
+
+SOURCES += \
+    Audio.cpp \
+    Broadcaster.cpp \
+    Checkpoint.cpp \
+    ClockSync.cpp \
+    CommandLog.cpp \
+    DeskNode.cpp \
+    Effects.cpp \
+    FrameRing.cpp \
+    Gradient.cpp \
+    Latency.cpp \
+    Layout.cpp \
+    OutputSink.cpp \
+    Pattern.cpp \
+    PixelFormat.cpp \
+    Player.cpp \
+    PreviewServer.cpp \
+    Sequence.cpp \
+    SequenceLibrary.cpp \
+    StripBase.cpp \
+    Stripper.cpp \
+    Transition.cpp \
+    Ws2812Encoder.cpp \
+    Zone.cpp \
+    daemon.cpp \
+    $$PROTOCOL_DIR/radiopixel_protocol.cpp
+
+HEADERS += \
+    Audio.h \
+    Broadcaster.h \
+    Checkpoint.h \
+    ClockSync.h \
+    CommandLog.h \
+    DeskNode.h \
+    Effects.h \
+    FrameRing.h \
+    Gradient.h \
+    Latency.h \
+    Layout.h \
+    OutputSink.h \
+    Pattern.h \
+    PatternRegistry.h \
+    PixelFormat.h \
+    Player.h \
+    PreviewServer.h \
+    Sequence.h \
+    SequenceLibrary.h \
+    StripBase.h \
+    Stripper.h \
+    Transition.h \
+    Ws2812Encoder.h \
+    Zone.h
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
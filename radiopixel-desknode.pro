@@ -19,25 +19,61 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# live capture for audio=alsa:device, where ALSA is installed
+linux:packagesExist(alsa) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += alsa
+    DEFINES += RADIOPIXEL_ALSA
+}
+
 SOURCES += \
+    Audio.cpp \
+    Broadcaster.cpp \
+    Checkpoint.cpp \
+    ClockSync.cpp \
+    CommandLog.cpp \
+    DeskNode.cpp \
+    Effects.cpp \
     Gradient.cpp \
+    Latency.cpp \
+    Layout.cpp \
     Pattern.cpp \
+    PixelFormat.cpp \
     Player.cpp \
     Sequence.cpp \
+    SequenceLibrary.cpp \
     StripBase.cpp \
     Stripper.cpp \
+    Transition.cpp \
+    Ws2812Encoder.cpp \
+    Zone.cpp \
     main.cpp \
     mainwindow.cpp \
     $$PROTOCOL_DIR/radiopixel_protocol.cpp
 
 HEADERS += \
+    Audio.h \
+    Broadcaster.h \
     Button.h \
+    Checkpoint.h \
+    ClockSync.h \
+    CommandLog.h \
+    DeskNode.h \
+    Effects.h \
     Gradient.h \
+    Latency.h \
+    Layout.h \
     Pattern.h \
+    PatternRegistry.h \
+    PixelFormat.h \
     Player.h \
     Sequence.h \
+    SequenceLibrary.h \
     StripBase.h \
     Stripper.h \
+    Transition.h \
+    Ws2812Encoder.h \
+    Zone.h \
     mainwindow.h
 
 RC_ICONS = hat.ico
@@ -62,12 +62,14 @@ const int FLASH_PIN = 8;
 //    * disable local control if external control received within last 10 seconds
 //    * idle command so all nodes know they are in idle?
 
+#ifdef DEBUG          
 int freeRam()
 {
     extern int __heap_start, *__brkval;
     int v;
     return (int) &v - (__brkval == 0 ? (int) &__heap_start : (int) __brkval);
 }
+#endif
 
 void setup() 
 {
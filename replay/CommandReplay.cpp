@@ -0,0 +1,158 @@
+#include <string.h>
+#include <random>
+#include <QDebug>
+#include <QTimerEvent>
+#include <QtEndian>
+#include "radiopixel_protocol.h"
+#include "Broadcaster.h"
+#include "MeshSim.h"
+#include "CommandReplay.h"
+
+
+CommandReplay::CommandReplay( const std::vector< CommandLog::Entry > &entries, double speed, QObject *parent )
+    : QObject( parent ),
+      m_entries( entries ), m_speed( speed ), m_batched( false ), m_next( 0 ), m_failed( 0 ),
+      m_port( 0 ), m_stream( NULL )
+{
+    for ( size_t i = 0; i < m_entries.size( ); ++i )
+    {
+        m_batched = m_batched || m_entries[ i ].group;
+    }
+}
+
+void CommandReplay::storm( unsigned rate, ms_t ms, int groups, uint32_t seed, std::vector< CommandLog::Entry > *entries )
+{
+    // evenly spaced, every one a new look so every one is worth a frame
+    std::mt19937 random( seed );
+    quint64 count( ( quint64 )rate * ms / 1000 );
+    entries->clear( );
+    entries->reserve( count );
+    for ( quint64 i = 0; i < count; ++i )
+    {
+        CommandLog::Entry entry;
+        entry.stamp = i * 1000000000ull / rate;
+        entry.source = CommandLog::SOURCE_LAN;
+        entry.group = ( groups > 1 ) ? random( ) % groups : 0;
+
+        RandomCommand( random, &entry.command );
+        entries->push_back( entry );
+    }
+}
+
+void CommandReplay::toUdp( const QHostAddress &address, quint16 port )
+{
+    m_address = address;
+    m_port = port;
+}
+
+bool CommandReplay::toTcp( quint16 port )
+{
+    if ( !m_server.listen( QHostAddress::Any, port ))
+    {
+        qWarning( ) << "can't serve commands on" << port << m_server.errorString( );
+        return false;
+    }
+    connect( &m_server, SIGNAL( newConnection()),
+             this, SLOT( onConnection()));
+    return true;
+}
+
+void CommandReplay::start( )
+{
+    if ( m_server.isListening( ) && !m_stream )
+    {
+        // the node connects on its own schedule, up to its reconnect interval
+        qInfo( ) << "waiting for a node on port" << m_server.serverPort( );
+        return;
+    }
+    qInfo( ) << "replaying" << m_entries.size( ) << "commands at" << m_speed << "x";
+    m_elapsed.start( );
+    m_timer.start( 0, Qt::PreciseTimer, this );
+}
+
+void CommandReplay::onConnection( )
+{
+    QTcpSocket *socket( m_server.nextPendingConnection( ));
+    if ( m_stream )
+    {
+        // one node at a time, the cloud only has one stream per node anyway
+        socket->deleteLater( );
+        return;
+    }
+    m_stream = socket;
+    m_stream->setParent( this );
+    m_stream->setSocketOption( QAbstractSocket::LowDelayOption, 1 );
+    start( );
+}
+
+void CommandReplay::timerEvent( QTimerEvent *event )
+{
+    if ( event->timerId( ) == m_timer.timerId( ))
+    {
+        m_timer.stop( );
+        send( );
+    }
+}
+
+void CommandReplay::send( )
+{
+    if ( m_entries.empty( ))
+    {
+        emit finished( );
+        return;
+    }
+
+    // log time we've reached at this speed
+    stamp_t first( m_entries.front( ).stamp );
+    stamp_t reached( first + ( stamp_t )( m_elapsed.nsecsElapsed( ) * m_speed ));
+    for ( ; m_next < m_entries.size( ) && m_entries[ m_next ].stamp <= reached; ++m_next )
+    {
+        const CommandLog::Entry &entry( m_entries[ m_next ] );
+        if ( m_stream )
+        {
+            m_stream->write( ( const char *)&entry.command, sizeof entry.command );
+            continue;
+        }
+        qint64 sent;
+        if ( m_batched )
+        {
+            // one entry, so only zones on its group take it
+            uchar datagram[ BATCH_HEADER + BATCH_ENTRY ] = { };
+            qToLittleEndian< quint32 >( COMMAND_BATCH_MAGIC, datagram );
+            datagram[ 4 ] = 1;
+            datagram[ BATCH_HEADER ] = entry.group;
+            memcpy( datagram + BATCH_HEADER + 1, &entry.command, sizeof entry.command );
+            sent = m_socket.writeDatagram( ( const char *)datagram, sizeof datagram, m_address, m_port );
+        }
+        else
+        {
+            sent = m_socket.writeDatagram( ( const char *)&entry.command, sizeof entry.command,
+                                           m_address, m_port );
+        }
+        m_failed += ( sent < 0 );
+    }
+
+    if ( m_next < m_entries.size( ))
+    {
+        qint64 due( ( qint64 )( ( m_entries[ m_next ].stamp - first ) / m_speed ) - m_elapsed.nsecsElapsed( ));
+        // rounded up, or the last millisecond before each one spins
+        m_timer.start( ( int )qMax< qint64 >( ( due + 999999 ) / 1000000, 0 ), Qt::PreciseTimer, this );
+        return;
+    }
+
+    // the whole log is out, say how close we came to its pace
+    double seconds( m_elapsed.nsecsElapsed( ) / 1e9 );
+    double span( ( m_entries.back( ).stamp - first ) / 1e9 / m_speed );
+    qInfo( ).noquote( ) << QString( "replayed %1 commands in %2 s, %3/s, asked %4/s, %5 failed" )
+        .arg( m_entries.size( ))
+        .arg( seconds, 0, 'f', 2 )
+        .arg( m_entries.size( ) / qMax( seconds, 1e-3 ), 0, 'f', 0 )
+        .arg( m_entries.size( ) / qMax( span, 1e-3 ), 0, 'f', 0 )
+        .arg( m_failed );
+    if ( m_stream )
+    {
+        m_stream->flush( );
+        m_stream->waitForBytesWritten( 1000 );
+    }
+    emit finished( );
+}
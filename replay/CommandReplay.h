@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <QBasicTimer>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include "CommandLog.h"
+
+
+// Plays a log back against a node at speed times as fast as it was
+// recorded, over UDP like a controller or over a TCP server standing in
+// for the cloud. Whatever falls due between timer ticks goes out
+// together, so 1000x keeps up with a busy log.
+class CommandReplay : public QObject
+{
+    Q_OBJECT
+
+public:
+    CommandReplay( const std::vector< CommandLog::Entry > &entries, double speed, QObject *parent = nullptr );
+
+    //! rate random commands a second for ms, spread over groups
+    static void storm( unsigned rate, ms_t ms, int groups, uint32_t seed, std::vector< CommandLog::Entry > *entries );
+
+    //! send datagrams to address:port
+    void toUdp( const QHostAddress &address, quint16 port );
+
+    //! serve the stream on port, starts once a node connects
+    bool toTcp( quint16 port );
+
+    void start( );
+
+signals:
+    void finished( );
+
+protected:
+    void timerEvent( QTimerEvent *event ) override;
+
+private slots:
+    void onConnection( );
+
+private:
+    // send everything due, then sleep until the next is
+    void send( );
+
+    std::vector< CommandLog::Entry > m_entries;
+    double m_speed;
+    bool m_batched; // groups other than 0, so zones can tell them apart
+    size_t m_next;
+    quint64 m_failed; // datagrams the socket wouldn't take
+
+    QUdpSocket m_socket;
+    QHostAddress m_address;
+    quint16 m_port;
+    QTcpServer m_server;
+    QTcpSocket *m_stream; // NULL for UDP
+
+    QElapsedTimer m_elapsed;
+    QBasicTimer m_timer;
+};
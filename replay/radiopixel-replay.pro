@@ -0,0 +1,34 @@
+QT       = core network
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = radiopixel-replay
+
+PROTOCOL_DIR = $$PWD/../../radiopixel-protocol
+
+INCLUDEPATH += $$PWD/.. $$PROTOCOL_DIR
+
+SOURCES += \
+    replay.cpp \
+    CommandReplay.cpp \
+    ../CommandLog.cpp \
+    ../Effects.cpp \
+    ../Gradient.cpp \
+    ../Latency.cpp \
+    ../Layout.cpp \
+    ../MeshSim.cpp \
+    ../Pattern.cpp \
+    ../Player.cpp \
+    ../Sequence.cpp \
+    ../StripBase.cpp \
+    ../Stripper.cpp \
+    ../Transition.cpp \
+    $$PROTOCOL_DIR/radiopixel_protocol.cpp
+
+HEADERS += \
+    CommandReplay.h \
+    ../CommandLog.h \
+    ../Latency.h \
+    ../MeshSim.h \
+    ../StripBase.h
@@ -0,0 +1,144 @@
+// Command replay, a load generator. Sends a log the daemon recorded with
+// record=file, or a storm of random commands, to a node running elsewhere
+// with stats on.
+//
+//   radiopixel-replay log=desk.rplog,speed=100,to=udp:10.0.0.5:8101
+//   radiopixel-replay storm=2000,to=tcp:8100
+//
+// to=tcp:port stands in for the cloud, for a node with cloud=127.0.0.1:port.
+
+#include <stdio.h>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QStringList>
+#include "radiopixel_protocol.h"
+#include "CommandReplay.h"
+
+
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 14, 0 )
+const auto SKIP_EMPTY = Qt::SkipEmptyParts;
+#else
+const auto SKIP_EMPTY = QString::SkipEmptyParts;
+#endif
+
+
+// what to send and where
+struct ReplayConfig
+{
+    ReplayConfig( )
+        : storm( 0 ), seconds( 10 ), groups( 1 ), seed( 1 ), speed( 1 ),
+          tcp( false ), address( QHostAddress::LocalHost ), port( HN_PORT ) {}
+
+    QString log; // recorded commands, empty for a storm
+    unsigned storm; // synthetic commands a second
+    unsigned seconds;
+    int groups;
+    uint32_t seed;
+    double speed; // 1 - 1000 times as fast as recorded
+    bool tcp; // serve them as the cloud would, else UDP datagrams
+    QHostAddress address;
+    quint16 port;
+};
+
+
+static bool parseReplay( const QString &spec, ReplayConfig *config )
+{
+    foreach ( const QString &item, spec.split( ',', SKIP_EMPTY ))
+    {
+        QString key( item.section( '=', 0, 0 ).trimmed( ));
+        QString value( item.section( '=', 1 ).trimmed( ));
+        bool ok( true );
+        if ( key == "log" )
+        {
+            config->log = value;
+        }
+        else if ( key == "storm" )
+        {
+            config->storm = value.toUInt( &ok );
+            ok = ok && config->storm;
+        }
+        else if ( key == "seconds" )
+        {
+            config->seconds = value.toUInt( &ok );
+        }
+        else if ( key == "groups" )
+        {
+            config->groups = value.toInt( &ok );
+            ok = ok && config->groups > 0 && config->groups <= 256;
+        }
+        else if ( key == "seed" )
+        {
+            config->seed = value.toUInt( &ok );
+        }
+        else if ( key == "speed" )
+        {
+            config->speed = value.toDouble( &ok );
+            ok = ok && config->speed >= 1 && config->speed <= 1000;
+        }
+        else if ( key == "to" )
+        {
+            // udp:host:port, or tcp:port for a node with cloud=127.0.0.1:port
+            QString kind( value.section( ':', 0, 0 ));
+            config->tcp = ( kind == "tcp" );
+            if ( config->tcp )
+            {
+                config->port = value.section( ':', 1 ).toUShort( &ok );
+            }
+            else
+            {
+                config->address = QHostAddress( value.section( ':', 1, 1 ));
+                config->port = value.section( ':', 2 ).toUShort( &ok );
+                ok = ok && kind == "udp" && !config->address.isNull( );
+            }
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if ( !ok )
+        {
+            qCritical( ) << "bad replay setting" << key << "=" << value;
+            return false;
+        }
+    }
+    return !config->log.isEmpty( ) || config->storm;
+}
+
+int main( int argc, char *argv[] )
+{
+    QCoreApplication a( argc, argv );
+    ReplayConfig config;
+    if ( argc != 2 || !parseReplay( argv[ 1 ], &config ))
+    {
+        fprintf( stderr, "usage: %s k=v,...\n"
+                         "keys are log, storm, seconds, groups, seed, speed and to\n", argv[ 0 ] );
+        return 1;
+    }
+
+    std::vector< CommandLog::Entry > entries;
+    if ( config.log.isEmpty( ))
+    {
+        CommandReplay::storm( config.storm, config.seconds * 1000, config.groups, config.seed, &entries );
+    }
+    else if ( !CommandLog::load( config.log, &entries ))
+    {
+        return 1;
+    }
+    CommandReplay replay( entries, config.speed );
+    if ( config.tcp )
+    {
+        if ( !replay.toTcp( config.port ))
+        {
+            return 1;
+        }
+    }
+    else
+    {
+        replay.toUdp( config.address, config.port );
+    }
+    QObject::connect( &replay, SIGNAL( finished()),
+                      &a, SLOT( quit()));
+    replay.start( );
+    return a.exec( );
+}
@@ -0,0 +1,210 @@
+#include <QStringList>
+#include "SequenceText.h"
+
+
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 14, 0 )
+const auto SKIP_EMPTY = Qt::SkipEmptyParts;
+#else
+const auto SKIP_EMPTY = QString::SkipEmptyParts;
+#endif
+
+
+static const struct { const char *name; uint8_t id; } patterns[] =
+{
+    { "MiniTwinkle", RadioPixel::Command::MiniTwinkle },
+    { "MiniSparkle", RadioPixel::Command::MiniSparkle },
+    { "Sparkle", RadioPixel::Command::Sparkle },
+    { "Rainbow", RadioPixel::Command::Rainbow },
+    { "Flash", RadioPixel::Command::Flash },
+    { "March", RadioPixel::Command::March },
+    { "Wipe", RadioPixel::Command::Wipe },
+    { "Gradient", RadioPixel::Command::Gradient },
+    { "Fixed", RadioPixel::Command::Fixed },
+    { "Strobe", RadioPixel::Command::Strobe },
+    { "CandyCane", RadioPixel::Command::CandyCane },
+    { "RadialRainbow", PATTERN_RADIAL_RAINBOW },
+    { "Plasma", PATTERN_PLASMA },
+};
+
+static const struct { const char *name; uint8_t bit; } effects[] =
+{
+    { "smear", EFFECT_SMEAR },
+    { "perturb", EFFECT_PERTURB },
+    { "decay", EFFECT_DECAY },
+    { "mirror", EFFECT_MIRROR },
+    { "reverse", EFFECT_REVERSE },
+};
+
+
+static bool parsePattern( const QString &name, uint8_t *pattern )
+{
+    for ( size_t i = 0; i < sizeof patterns / sizeof patterns[ 0 ]; ++i )
+    {
+        if ( name == patterns[ i ].name )
+        {
+            *pattern = patterns[ i ].id;
+            return true;
+        }
+    }
+    bool ok;
+    uint id( name.toUInt( &ok, 0 ));
+    *pattern = id;
+    return ok && id < 256;
+}
+
+static QString patternName( uint8_t pattern )
+{
+    for ( size_t i = 0; i < sizeof patterns / sizeof patterns[ 0 ]; ++i )
+    {
+        if ( pattern == patterns[ i ].id )
+        {
+            return patterns[ i ].name;
+        }
+    }
+    return QString::number( pattern );
+}
+
+static bool parseEffects( const QString &names, uint8_t *bits )
+{
+    *bits = EFFECT_NONE;
+    foreach ( const QString &name, names.split( '+', SKIP_EMPTY ))
+    {
+        size_t i = 0;
+        while ( i < sizeof effects / sizeof effects[ 0 ] && name != effects[ i ].name )
+        {
+            ++i;
+        }
+        if ( i < sizeof effects / sizeof effects[ 0 ] )
+        {
+            *bits |= effects[ i ].bit;
+        }
+        else if ( name != "none" )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static QString effectNames( uint8_t bits )
+{
+    QStringList names;
+    for ( size_t i = 0; i < sizeof effects / sizeof effects[ 0 ]; ++i )
+    {
+        if ( bits & effects[ i ].bit )
+        {
+            names.append( effects[ i ].name );
+        }
+    }
+    return names.isEmpty( ) ? QString( "none" ) : names.join( '+' );
+}
+
+static QString colorName( uint32_t color )
+{
+    return QString( "%1" ).arg( color & 0xffffff, 6, 16, QChar( '0' ));
+}
+
+// "4000 127 100 Flash ffff00 ffff00 ffff00 255 none"
+static bool parseStep( const QStringList &fields, Step *step )
+{
+    if ( fields.size( ) < 8 || fields.size( ) > 9 )
+    {
+        return false;
+    }
+    bool ok[ 8 ];
+    step->duration = fields[ 0 ].toUInt( &ok[ 0 ] );
+    uint brightness( fields[ 1 ].toUInt( &ok[ 1 ] ));
+    uint speed( fields[ 2 ].toUInt( &ok[ 2 ] ));
+    ok[ 3 ] = parsePattern( fields[ 3 ], &step->pattern );
+    for ( int c = 0; c < 3; ++c )
+    {
+        step->colors[ c ] = fields[ 4 + c ].toUInt( &ok[ 4 + c ], 16 );
+    }
+    uint level( fields[ 7 ].toUInt( &ok[ 7 ] ));
+    step->brightness = brightness;
+    step->speed = speed;
+    step->level = level;
+    if ( !parseEffects( fields.value( 8 ), &step->effects ))
+    {
+        return false;
+    }
+    for ( int i = 0; i < 8; ++i )
+    {
+        if ( !ok[ i ] )
+        {
+            return false;
+        }
+    }
+    return brightness < 256 && speed < 256 && level < 256;
+}
+
+//-------------------------------------------------------------
+
+QByteArray SequenceText::compile( QTextStream &text, QString *error )
+{
+    QStringList names;
+    QList< QVector< Step > > steps;
+    for ( int line = 1; !text.atEnd( ); ++line )
+    {
+        QStringList fields( text.readLine( ).section( '#', 0, 0 ).split( ' ', SKIP_EMPTY ));
+        if ( fields.isEmpty( ))
+        {
+            continue;
+        }
+
+        if ( fields[ 0 ] == "sequence" )
+        {
+            if ( fields.size( ) != 2 || fields[ 1 ].toLatin1( ).size( ) >= LIBRARY_NAME_SIZE ||
+                 names.contains( fields[ 1 ] ))
+            {
+                *error = QString( "line %1: bad or repeated sequence name" ).arg( line );
+                return QByteArray( );
+            }
+            names.append( fields[ 1 ] );
+            steps.append( QVector< Step >( ));
+            continue;
+        }
+
+        Step step;
+        if ( names.isEmpty( ) || !parseStep( fields, &step ))
+        {
+            *error = QString( "line %1: bad step" ).arg( line );
+            return QByteArray( );
+        }
+        steps.last( ).append( step );
+    }
+
+    for ( int i = 0; i < names.size( ); ++i )
+    {
+        if ( steps[ i ].isEmpty( ))
+        {
+            *error = QString( "sequence %1 has no steps" ).arg( names[ i ] );
+            return QByteArray( );
+        }
+    }
+    return SequenceLibrary::build( names, steps );
+}
+
+QString SequenceText::dump( const uchar *data )
+{
+    QString dumped;
+    QTextStream text( &dumped );
+    const LibraryHeader *header( ( const LibraryHeader *)data );
+    const LibraryEntry *entries( ( const LibraryEntry *)( header + 1 ));
+    const Step *steps( ( const Step *)( entries + header->count ));
+    for ( uint32_t i = 0; i < header->count; ++i )
+    {
+        text << "sequence " << entries[ i ].name << "\n";
+        for ( uint32_t s = 0; s < entries[ i ].steps; ++s )
+        {
+            const Step &step( steps[ entries[ i ].first + s ] );
+            text << QString( "%1 %2 %3 %4 %5 %6 %7 %8 %9\n" )
+                        .arg( step.duration ).arg( step.brightness ).arg( step.speed )
+                        .arg( patternName( step.pattern ))
+                        .arg( colorName( step.colors[ 0 ] )).arg( colorName( step.colors[ 1 ] ))
+                        .arg( colorName( step.colors[ 2 ] ))
+                        .arg( step.level ).arg( effectNames( step.effects ));
+        }
+    }
+    return dumped;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QTextStream>
+
+#include "SequenceLibrary.h"
+
+
+// The text form of a sequence library, as seqc.cpp describes it
+class SequenceText
+{
+public:
+    //! returns the library image text describes, empty with what's wrong
+    // and where in error if it doesn't compile
+    static QByteArray compile( QTextStream &text, QString *error );
+
+    //! returns the text of a valid library image
+    static QString dump( const uchar *data );
+};
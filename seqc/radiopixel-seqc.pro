@@ -0,0 +1,19 @@
+QT       = core
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = radiopixel-seqc
+
+PROTOCOL_DIR = $$PWD/../../radiopixel-protocol
+
+INCLUDEPATH += $$PWD/.. $$PROTOCOL_DIR
+
+SOURCES += \
+    seqc.cpp \
+    SequenceText.cpp \
+    ../SequenceLibrary.cpp
+
+HEADERS += \
+    SequenceText.h \
+    ../SequenceLibrary.h
@@ -0,0 +1,86 @@
+// Sequence library compiler. Turns a text description of show sequences
+// into the binary library the desk node maps, and back again.
+//
+//   radiopixel-seqc sequences.txt sequences.rpsl
+//   radiopixel-seqc --dump sequences.rpsl
+//
+// Text, one step per line under each sequence, # to end of line ignored:
+//   sequence alert
+//   # ms   bright speed pattern  color0 color1 color2 level effects
+//   4000   127    100   Flash    ffff00 ffff00 ffff00 255   none
+//   60000  127    40    March    ffff00 ffff00 ffff00 34    smear+decay
+//
+// The library is replaced in one go, so a running node never sees half
+// of it.
+
+#include <stdio.h>
+#include <QFile>
+#include <QSaveFile>
+#include <QTextStream>
+#include "SequenceText.h"
+
+
+static int compile( const QString &in, const QString &out )
+{
+    QFile file( in );
+    if ( !file.open( QIODevice::ReadOnly | QIODevice::Text ))
+    {
+        fprintf( stderr, "can't open %s\n", qPrintable( in ));
+        return 1;
+    }
+
+    QTextStream text( &file );
+    QString error;
+    QByteArray image( SequenceText::compile( text, &error ));
+    if ( image.isEmpty( ))
+    {
+        fprintf( stderr, "%s: %s\n", qPrintable( in ), qPrintable( error ));
+        return 1;
+    }
+
+    // written aside and renamed over, the node keeps the old one mapped
+    QSaveFile save( out );
+    if ( !save.open( QIODevice::WriteOnly ) || save.write( image ) != image.size( ) || !save.commit( ))
+    {
+        fprintf( stderr, "can't write %s: %s\n", qPrintable( out ), qPrintable( save.errorString( )));
+        return 1;
+    }
+    printf( "%u sequences\n", ( ( const LibraryHeader *)image.constData( ))->count );
+    return 0;
+}
+
+static int dump( const QString &in )
+{
+    QFile file( in );
+    if ( !file.open( QIODevice::ReadOnly ))
+    {
+        fprintf( stderr, "can't open %s\n", qPrintable( in ));
+        return 1;
+    }
+    QByteArray image( file.readAll( ));
+    const uchar *data( ( const uchar *)image.constData( ));
+    QString error( SequenceLibrary::validate( data, image.size( )));
+    if ( !error.isEmpty( ))
+    {
+        fprintf( stderr, "%s: %s\n", qPrintable( in ), qPrintable( error ));
+        return 1;
+    }
+
+    printf( "%s", qPrintable( SequenceText::dump( data )));
+    return 0;
+}
+
+int main( int argc, char *argv[] )
+{
+    if ( argc == 3 && QString( argv[ 1 ] ) == "--dump" )
+    {
+        return dump( argv[ 2 ] );
+    }
+    if ( argc == 3 )
+    {
+        return compile( argv[ 1 ], argv[ 2 ] );
+    }
+    fprintf( stderr, "usage: %s sequences.txt library.rpsl\n"
+                     "       %s --dump library.rpsl\n", argv[ 0 ], argv[ 0 ] );
+    return 1;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Arduino.h"
+#include "StripBase.h"
+
+#define NEO_GRB 0x52
+#define NEO_KHZ800 0x0000
+
+
+// NeoPixel driver backed by a StripBase, counting the calls the cost
+// model prices. The methods hide StripBase's, so everything the firmware
+// does through Stripper lands here.
+class Adafruit_NeoPixel : public StripBase
+{
+public:
+    Adafruit_NeoPixel( pixel_t pixels, uint8_t pin, uint8_t type )
+        : StripBase( pixels, pin, type ), m_shows( 0 ), m_sets( 0 ), m_gets( 0 )
+    {
+        setBrightness( 255 );
+    }
+
+    void begin( ) { }
+
+    void show( )
+    {
+        ++m_shows;
+        StripBase::show( );
+    }
+
+    void setPixelColor( pixel_t pixel, uint32_t color )
+    {
+        ++m_sets;
+        StripBase::setPixelColor( pixel, color );
+    }
+
+    uint32_t getPixelColor( pixel_t pixel ) const
+    {
+        ++m_gets;
+        return StripBase::getPixelColor( pixel );
+    }
+
+    // call counts since the last reset
+    uint32_t shows( ) const { return m_shows; }
+    uint32_t sets( ) const { return m_sets; }
+    uint32_t gets( ) const { return m_gets; }
+
+    void resetCounts( ) { m_shows = m_sets = m_gets = 0; }
+
+private:
+    uint32_t m_shows;
+    uint32_t m_sets;
+    mutable uint32_t m_gets;
+};
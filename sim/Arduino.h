@@ -0,0 +1,54 @@
+#pragma once
+
+// Just enough of the Arduino core for radiopixel-node.ino to run on the
+// host. Time comes from the simulator's clock, pins from its timeline.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+
+#define A0 14
+#define A5 19
+
+// strings live in RAM on the host
+class __FlashStringHelper;
+#define F( string ) ( reinterpret_cast< const __FlashStringHelper * >( string ))
+
+uint32_t millis( );
+void delay( uint32_t ms );
+
+void pinMode( uint8_t pin, uint8_t mode );
+void digitalWrite( uint8_t pin, uint8_t value );
+int digitalRead( uint8_t pin );
+int analogRead( uint8_t pin );
+
+void randomSeed( unsigned long seed );
+
+
+class SimSerial
+{
+public:
+    void begin( long baud );
+
+    int available( );
+    int read( );
+    size_t readBytes( char *buffer, size_t length );
+
+    void print( const char *text );
+    void print( const __FlashStringHelper *text );
+    void print( long value );
+    void println( const char *text );
+    void println( const __FlashStringHelper *text );
+    void println( long value );
+};
+
+extern SimSerial Serial;
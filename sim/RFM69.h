@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+
+
+// Radio fed from the simulator timeline, sends are only counted
+class RFM69
+{
+public:
+    RFM69( );
+
+    bool initialize( uint8_t frequency, uint8_t nodeId, uint8_t networkId );
+    void setHighPower( ) { }
+    void encrypt( const char * ) { }
+    void promiscuous( bool ) { }
+
+    //! true when a packet is waiting in DATA
+    bool receiveDone( );
+
+    void send( uint8_t toAddress, const void *buffer, uint8_t size );
+
+    uint8_t DATA[ 61 ];
+    uint8_t DATALEN;
+};
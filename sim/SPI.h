@@ -0,0 +1,3 @@
+#pragma once
+
+// the radio talks SPI on the node, the simulated one doesn't need to
@@ -0,0 +1,32 @@
+QT       = core
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = radiopixel-sim
+
+# build the shared firmware code the way the node does
+DEFINES += ARDUINO
+
+PROTOCOL_DIR = $$PWD/../../radiopixel-protocol
+
+INCLUDEPATH += $$PWD $$PWD/.. $$PROTOCOL_DIR
+
+SOURCES += \
+    simulator.cpp \
+    ../Effects.cpp \
+    ../Gradient.cpp \
+    ../Pattern.cpp \
+    ../Player.cpp \
+    ../Sequence.cpp \
+    ../StripBase.cpp \
+    ../Stripper.cpp \
+    $$PROTOCOL_DIR/radiopixel_protocol.cpp
+
+HEADERS += \
+    Adafruit_NeoPixel.h \
+    Arduino.h \
+    RFM69.h \
+    SPI.h \
+    ../StripBase.h \
+    ../radiopixel-node.ino
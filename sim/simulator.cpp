@@ -0,0 +1,418 @@
+// Host build of radiopixel-node.ino. The sketch is compiled as is against
+// the stubs in this directory, driven by a timeline of radio packets,
+// serial packets and button presses, on a clock that advances by what
+// each loop( ) would have cost on the node.
+//
+//   radiopixel-sim [timeline]
+//
+// Timeline lines, times in ms from power on:
+//   500 radio pattern=Fixed color0=ff0000 level0=255 brightness=64
+//   900 serial pattern=March speed=50
+//   1200 button 4 300        ( pin, held ms )
+//   10000 end
+//
+// Exits 2 if any loop iteration ran over the frame budget.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include "Arduino.h"
+#include "RFM69.h"
+
+// the IDE generates prototypes for the sketch, we have to do it by hand
+void setup( );
+void loop( );
+void Blink( byte pin, int ms );
+
+#include "../radiopixel-node.ino"
+
+
+// cost model, ATmega328 at 16 MHz
+const double CPU_HZ = 16e6;
+const uint32_t LOOP_CYCLES = 400; // serial check, radio poll, buttons, player bookkeeping
+const uint32_t SET_CYCLES = 50; // setPixelColor with the brightness scale
+const uint32_t GET_CYCLES = 30; // getPixelColor
+const uint32_t SHOW_CYCLES = 480; // per pixel, 24 bits at 800 kHz, interrupts off
+const uint32_t BUDGET_CYCLES = FRAME_MS * CPU_HZ / 1000;
+
+const uint32_t DEFAULT_END_MS = 10000;
+
+
+struct Event
+{
+    enum Type { RADIO, SERIAL, PIN, END };
+
+    uint32_t ms;
+    Type type;
+    RadioPixel::Command command;
+    uint8_t pin;
+    uint8_t value;
+
+    bool operator<( const Event &other ) const { return ms < other.ms; }
+};
+
+static double s_micros = 0; // simulated time
+static std::vector< Event > s_timeline; // sorted, consumed from the front
+static size_t s_nextEvent = 0;
+static uint8_t s_pins[ 32 ];
+static std::deque< char > s_serialIn;
+static std::deque< RadioPixel::Command > s_radioIn;
+static uint32_t s_radioSends = 0;
+
+SimSerial Serial;
+
+//-------------------------------------------------------------
+
+uint32_t millis( )
+{
+    return ( uint32_t )( s_micros / 1000 );
+}
+
+void delay( uint32_t ms )
+{
+    s_micros += ms * 1000.0;
+}
+
+void pinMode( uint8_t, uint8_t )
+{
+}
+
+void digitalWrite( uint8_t pin, uint8_t value )
+{
+    // writing HIGH to an input turns on its pull-up, which also reads HIGH
+    s_pins[ pin & 31 ] = value;
+}
+
+int digitalRead( uint8_t pin )
+{
+    return s_pins[ pin & 31 ];
+}
+
+int analogRead( uint8_t )
+{
+    return 0; // a fixed seed keeps runs repeatable
+}
+
+void randomSeed( unsigned long seed )
+{
+    srand( seed );
+}
+
+void SimSerial::begin( long )
+{
+}
+
+int SimSerial::available( )
+{
+    return s_serialIn.size( );
+}
+
+int SimSerial::read( )
+{
+    if ( s_serialIn.empty( ))
+    {
+        return -1;
+    }
+    int c = ( uint8_t )s_serialIn.front( );
+    s_serialIn.pop_front( );
+    return c;
+}
+
+size_t SimSerial::readBytes( char *buffer, size_t length )
+{
+    size_t n = 0;
+    while ( n < length && !s_serialIn.empty( ))
+    {
+        buffer[ n++ ] = read( );
+    }
+    return n;
+}
+
+void SimSerial::print( const char *text ) { fputs( text, stdout ); }
+void SimSerial::print( const __FlashStringHelper *text ) { print( ( const char *)text ); }
+void SimSerial::print( long value ) { printf( "%ld", value ); }
+void SimSerial::println( const char *text ) { puts( text ); }
+void SimSerial::println( const __FlashStringHelper *text ) { println( ( const char *)text ); }
+void SimSerial::println( long value ) { printf( "%ld\n", value ); }
+
+RFM69::RFM69( )
+    : DATALEN( 0 )
+{
+}
+
+bool RFM69::initialize( uint8_t, uint8_t, uint8_t )
+{
+    return true;
+}
+
+bool RFM69::receiveDone( )
+{
+    if ( s_radioIn.empty( ))
+    {
+        return false;
+    }
+    memcpy( DATA, &s_radioIn.front( ), sizeof( RadioPixel::Command ));
+    DATALEN = sizeof( RadioPixel::Command );
+    s_radioIn.pop_front( );
+    return true;
+}
+
+void RFM69::send( uint8_t, const void *, uint8_t )
+{
+    ++s_radioSends;
+}
+
+//-------------------------------------------------------------
+
+static bool parsePattern( const std::string &name, uint8_t *pattern )
+{
+    static const struct { const char *name; uint8_t id; } patterns[] =
+    {
+        { "MiniTwinkle", RadioPixel::Command::MiniTwinkle },
+        { "MiniSparkle", RadioPixel::Command::MiniSparkle },
+        { "Sparkle", RadioPixel::Command::Sparkle },
+        { "Rainbow", RadioPixel::Command::Rainbow },
+        { "Flash", RadioPixel::Command::Flash },
+        { "March", RadioPixel::Command::March },
+        { "Wipe", RadioPixel::Command::Wipe },
+        { "Gradient", RadioPixel::Command::Gradient },
+        { "Fixed", RadioPixel::Command::Fixed },
+        { "Strobe", RadioPixel::Command::Strobe },
+        { "CandyCane", RadioPixel::Command::CandyCane },
+    };
+    for ( size_t i = 0; i < sizeof patterns / sizeof patterns[ 0 ]; ++i )
+    {
+        if ( name == patterns[ i ].name )
+        {
+            *pattern = patterns[ i ].id;
+            return true;
+        }
+    }
+    char *end;
+    *pattern = strtoul( name.c_str( ), &end, 0 );
+    return !*end;
+}
+
+// "key=value ..." after radio or serial
+static bool parseCommand( std::istringstream &in, RadioPixel::Command *command )
+{
+    memset( command, 0, sizeof *command );
+    command->command = HC_PATTERN;
+    command->brightness = 255;
+    command->speed = 100;
+    command->pattern = RadioPixel::Command::Fixed;
+
+    std::string item;
+    while ( in >> item )
+    {
+        size_t eq = item.find( '=' );
+        if ( eq == std::string::npos )
+        {
+            return false;
+        }
+        std::string key( item.substr( 0, eq ));
+        std::string value( item.substr( eq + 1 ));
+        unsigned long number = strtoul( value.c_str( ), NULL, 0 );
+
+        if ( key == "command" )
+        {
+            command->command = number;
+        }
+        else if ( key == "brightness" )
+        {
+            command->brightness = number;
+        }
+        else if ( key == "speed" )
+        {
+            command->speed = number;
+        }
+        else if ( key == "pattern" )
+        {
+            if ( !parsePattern( value, &command->pattern ))
+            {
+                return false;
+            }
+        }
+        else if ( key.size( ) == 6 && key.compare( 0, 5, "color" ) == 0 && key[ 5 ] >= '0' && key[ 5 ] <= '2' )
+        {
+            command->color[ key[ 5 ] - '0' ] = strtoul( value.c_str( ), NULL, 16 );
+        }
+        else if ( key.size( ) == 6 && key.compare( 0, 5, "level" ) == 0 && key[ 5 ] >= '0' && key[ 5 ] <= '2' )
+        {
+            command->level[ key[ 5 ] - '0' ] = number;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool loadTimeline( const char *path )
+{
+    std::ifstream file( path );
+    if ( !file )
+    {
+        fprintf( stderr, "can't open %s\n", path );
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while ( std::getline( file, line ))
+    {
+        ++lineNumber;
+        line = line.substr( 0, line.find( '#' ));
+        std::istringstream in( line );
+        Event event;
+        std::string type;
+        if ( !( in >> event.ms ))
+        {
+            continue; // blank or comment
+        }
+        in >> type;
+
+        bool ok = true;
+        if ( type == "radio" || type == "serial" )
+        {
+            event.type = ( type == "radio" ) ? Event::RADIO : Event::SERIAL;
+            ok = parseCommand( in, &event.command );
+            s_timeline.push_back( event );
+        }
+        else if ( type == "button" )
+        {
+            // pressed pulls the pin low, released lets the pull-up have it
+            int pin, held;
+            ok = ( in >> pin >> held ) && pin >= 0 && pin < 32 && held >= 0;
+            event.type = Event::PIN;
+            event.pin = pin;
+            event.value = LOW;
+            s_timeline.push_back( event );
+            event.ms += held;
+            event.value = HIGH;
+            s_timeline.push_back( event );
+        }
+        else if ( type == "end" )
+        {
+            event.type = Event::END;
+            s_timeline.push_back( event );
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if ( !ok )
+        {
+            fprintf( stderr, "%s:%d: can't parse \"%s\"\n", path, lineNumber, line.c_str( ));
+            return false;
+        }
+    }
+    std::stable_sort( s_timeline.begin( ), s_timeline.end( ));
+    return true;
+}
+
+// apply everything due, returns false at the end
+static bool runTimeline( uint32_t now )
+{
+    while ( s_nextEvent < s_timeline.size( ) && s_timeline[ s_nextEvent ].ms <= now )
+    {
+        const Event &event( s_timeline[ s_nextEvent++ ] );
+        switch ( event.type )
+        {
+        case Event::RADIO:
+            s_radioIn.push_back( event.command );
+            break;
+        case Event::SERIAL:
+            s_serialIn.insert( s_serialIn.end( ), ( const char *)&event.command,
+                               ( const char *)&event.command + sizeof event.command );
+            break;
+        case Event::PIN:
+            s_pins[ event.pin ] = event.value;
+            break;
+        case Event::END:
+            return false;
+        }
+    }
+    return true;
+}
+
+//-------------------------------------------------------------
+
+int main( int argc, char *argv[] )
+{
+    if ( argc > 2 )
+    {
+        fprintf( stderr, "usage: %s [timeline]\n", argv[ 0 ] );
+        return 1;
+    }
+    if ( argc == 2 && !loadTimeline( argv[ 1 ] ))
+    {
+        return 1;
+    }
+    if ( s_timeline.empty( ) || s_timeline.back( ).type != Event::END )
+    {
+        Event end;
+        end.ms = std::max( DEFAULT_END_MS, s_timeline.empty( ) ? 0 : s_timeline.back( ).ms + 1000 );
+        end.type = Event::END;
+        s_timeline.push_back( end );
+    }
+
+    setup( );
+    strip.resetCounts( );
+
+    uint64_t iterations = 0;
+    uint64_t frames = 0;
+    uint64_t totalCycles = 0;
+    uint64_t maxCycles = 0;
+    uint64_t overBudget = 0;
+    double maxShowUs = 0;
+    uint32_t startMs = millis( );
+
+    while ( runTimeline( millis( )))
+    {
+        loop( );
+
+        uint64_t shows = strip.shows( );
+        uint64_t cycles = LOOP_CYCLES +
+            ( uint64_t )strip.sets( ) * SET_CYCLES +
+            ( uint64_t )strip.gets( ) * GET_CYCLES +
+            shows * strip.numPixels( ) * SHOW_CYCLES;
+        strip.resetCounts( );
+
+        if ( shows )
+        {
+            maxShowUs = std::max( maxShowUs, strip.numPixels( ) * SHOW_CYCLES / CPU_HZ * 1e6 );
+        }
+        ++iterations;
+        frames += shows;
+        totalCycles += cycles;
+        maxCycles = std::max( maxCycles, cycles );
+        if ( cycles > BUDGET_CYCLES )
+        {
+            ++overBudget;
+        }
+        s_micros += cycles / CPU_HZ * 1e6;
+    }
+    fflush( stdout );
+
+    double seconds = ( millis( ) - startMs ) / 1000.0;
+    fprintf( stderr, "simulated %.1f s, %llu loop iterations\n",
+             seconds, ( unsigned long long )iterations );
+    fprintf( stderr, "frames shown %llu, %.1f fps\n",
+             ( unsigned long long )frames, seconds ? frames / seconds : 0 );
+    fprintf( stderr, "cycles per iteration avg %.0f max %llu, budget %u ( %u ms at %.0f MHz )\n",
+             iterations ? ( double )totalCycles / iterations : 0,
+             ( unsigned long long )maxCycles, BUDGET_CYCLES, FRAME_MS, CPU_HZ / 1e6 );
+    fprintf( stderr, "iterations over budget %llu\n", ( unsigned long long )overBudget );
+    fprintf( stderr, "longest show with interrupts off %.0f us\n", maxShowUs );
+    fprintf( stderr, "radio sends %u\n", s_radioSends );
+
+    return overBudget ? 2 : 0;
+}
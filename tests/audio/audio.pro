@@ -0,0 +1,19 @@
+QT       = core testlib
+
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+TARGET = tst_audio
+
+PROTOCOL_DIR = $$PWD/../../../radiopixel-protocol
+
+INCLUDEPATH += $$PWD/../.. $$PROTOCOL_DIR
+
+SOURCES += \
+    tst_audio.cpp \
+    ../../Audio.cpp \
+    ../../Latency.cpp
+
+HEADERS += \
+    ../../Audio.h \
+    ../../Latency.h
@@ -0,0 +1,193 @@
+#include <math.h>
+#include <chrono>
+#include <thread>
+#include <QtTest>
+#include "Audio.h"
+
+
+// the analyzer on synthetic input: a tone's energy in its own band, and
+// snapshots taken while the worker publishes as fast as it can
+class TestAudio : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void tone( );
+    void snapshot( );
+};
+
+
+const unsigned RATE = 44100;
+
+// enough to fill the window many times over and settle the band peaks
+const uint32_t TONE_HOPS = 400;
+
+// a second or so of reads against a worker that never waits on its input
+const uint32_t SNAPSHOT_HOPS = 50000;
+
+// hops cycle through this many loudnesses
+const int LOUDNESSES = 8;
+
+
+// A sine, as fast as it's read, that runs out after a number of hops
+class ToneSource : public AudioSource
+{
+public:
+    ToneSource( float hz, uint32_t hops )
+        : m_hz( hz ), m_hops( hops ), m_played( 0 )
+    {
+        m_rate = RATE;
+    }
+
+    virtual int read( int16_t *samples, int count )
+    {
+        if ( !m_hops-- )
+        {
+            return 0;
+        }
+        for ( int i = 0; i < count; ++i, ++m_played )
+        {
+            samples[ i ] = ( int16_t )( 16384 * sinf( 2 * M_PI * m_hz * m_played / RATE ));
+        }
+        return count;
+    }
+
+private:
+    float m_hz;
+    uint32_t m_hops;
+    uint64_t m_played;
+};
+
+// Each hop a flat level, stepping down 6 dB a hop and back round, so
+// every hop's frame has a loudness its hop number gives away
+class StepSource : public AudioSource
+{
+public:
+    StepSource( uint32_t hops )
+        : m_hops( hops ), m_hop( 0 )
+    {
+        m_rate = RATE;
+    }
+
+    virtual int read( int16_t *samples, int count )
+    {
+        if ( m_hop == m_hops )
+        {
+            return 0;
+        }
+        int16_t level( 32767 >> ( m_hop++ % LOUDNESSES ));
+        for ( int i = 0; i < count; ++i )
+        {
+            samples[ i ] = level;
+        }
+        return count;
+    }
+
+private:
+    uint32_t m_hops;
+    uint32_t m_hop;
+};
+
+
+// wait for the worker to analyse every hop of its source
+static AudioFrame last( const AudioAnalyzer &analyzer, uint32_t hops )
+{
+    AudioFrame frame( analyzer.snapshot( ));
+    for ( int tries = 0; frame.hop < hops && tries < 10000; ++tries )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ));
+        frame = analyzer.snapshot( );
+    }
+    return frame;
+}
+
+// the middle of a band, on the log scale it's spaced on
+static float centre( int band )
+{
+    const float low( 40 ), top( RATE / 2.0f );
+    return low * powf( top / low, ( band + 0.5f ) / AUDIO_BANDS );
+}
+
+void TestAudio::tone( )
+{
+    // the low bands are a bin or two of the 512 sample window wide, narrower
+    // than a windowed tone, so start where one fits inside its band
+    for ( int band = 3; band < AUDIO_BANDS; ++band )
+    {
+        AudioAnalyzer analyzer;
+        analyzer.start( new ToneSource( centre( band ), TONE_HOPS ));
+        AudioFrame frame( last( analyzer, TONE_HOPS ));
+        analyzer.stop( );
+        QCOMPARE( frame.hop, TONE_HOPS );
+
+        QString where( QString( "%1 Hz, bands %2 %3 %4 %5 %6 %7 %8 %9" )
+                       .arg( centre( band ))
+                       .arg( frame.bands[ 0 ] ).arg( frame.bands[ 1 ] ).arg( frame.bands[ 2 ] )
+                       .arg( frame.bands[ 3 ] ).arg( frame.bands[ 4 ] ).arg( frame.bands[ 5 ] )
+                       .arg( frame.bands[ 6 ] ).arg( frame.bands[ 7 ] ));
+
+        // a steady tone sits at its band's peak, the bands it doesn't
+        // reach barely off their floor
+        QVERIFY2( frame.bands[ band ] >= 240, qPrintable( where ));
+        for ( int other = 0; other < AUDIO_BANDS; ++other )
+        {
+            if ( other != band )
+            {
+                QVERIFY2( frame.bands[ other ] < 64, qPrintable( where ));
+            }
+        }
+
+        // and a half scale sine is 9 dB under full scale
+        QVERIFY2( qAbs( frame.level - ( 60 - 9 ) * 255 / 60 ) <= 2, qPrintable( where ));
+    }
+}
+
+void TestAudio::snapshot( )
+{
+    AudioAnalyzer analyzer;
+    analyzer.start( new StepSource( SNAPSHOT_HOPS ));
+
+    // a torn copy pairs one hop's count with another's analysis, so every
+    // read of the same step down has to agree on its loudness
+    int levels[ LOUDNESSES ];
+    for ( int i = 0; i < LOUDNESSES; ++i )
+    {
+        levels[ i ] = -1;
+    }
+    uint32_t lastHop( 0 ), changes( 0 );
+    uint64_t lastStamp( 0 );
+    AudioFrame frame;
+    do
+    {
+        frame = analyzer.snapshot( );
+        if ( !frame.hop )
+        {
+            continue;
+        }
+        QVERIFY( frame.hop >= lastHop );
+        QVERIFY( frame.stamp >= lastStamp );
+        changes += frame.hop != lastHop;
+        lastHop = frame.hop;
+        lastStamp = frame.stamp;
+
+        int step( ( frame.hop - 1 ) % LOUDNESSES );
+        if ( levels[ step ] < 0 )
+        {
+            levels[ step ] = frame.level;
+        }
+        QCOMPARE( ( int )frame.level, levels[ step ] );
+    }
+    while ( frame.hop < SNAPSHOT_HOPS );
+    analyzer.stop( );
+
+    // it did race the worker, and every step down was told apart
+    QVERIFY( changes > 10 );
+    for ( int i = 1; i < LOUDNESSES; ++i )
+    {
+        QVERIFY( levels[ i ] < levels[ i - 1 ] );
+    }
+}
+
+QTEST_APPLESS_MAIN( TestAudio )
+
+#include "tst_audio.moc"
@@ -0,0 +1,21 @@
+QT       = core testlib
+
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+TARGET = tst_effects
+
+PROTOCOL_DIR = $$PWD/../../../radiopixel-protocol
+
+INCLUDEPATH += $$PWD/../.. $$PROTOCOL_DIR
+
+SOURCES += \
+    tst_effects.cpp \
+    ../../Effects.cpp \
+    ../../StripBase.cpp \
+    ../../Stripper.cpp
+
+HEADERS += \
+    ../../Effects.h \
+    ../../StripBase.h \
+    ../../Stripper.h
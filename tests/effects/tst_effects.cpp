@@ -0,0 +1,216 @@
+#include <string.h>
+#include <random>
+#include <vector>
+#include <QtTest>
+#include "Effects.h"
+#include "Stripper.h"
+
+
+// every kernel against its scalar loop, and the chain against the strip
+class TestEffects : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void smear( );
+    void perturb( );
+    void decay( );
+    void mirror( );
+    void reverse( );
+    void leavesFrame( );
+    void trailsFade( );
+    void views( );
+};
+
+
+// every remainder of the four pixel SIMD groups, short and long
+const pixel_t LENGTHS[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 15, 16, 17, 1021, 1022, 1023, 1024 };
+const size_t LENGTH_COUNT = sizeof LENGTHS / sizeof LENGTHS[ 0 ];
+
+// frames run through the stateful kernels, so history and seeds carry over
+const int FRAMES = 8;
+
+
+static std::vector< uint32_t > frame( pixel_t count, uint32_t seed )
+{
+    std::mt19937 random( seed );
+    std::vector< uint32_t > pixels( count );
+    for ( pixel_t i = 0; i < count; ++i )
+    {
+        pixels[ i ] = random( );
+    }
+    // saturated and empty channels, where the clamps kick in
+    const uint32_t edges[] = { 0x00000000, 0xffffffff, 0xff00ff00, 0x00ff00ff, 0xfffe0102 };
+    for ( size_t i = 0; i < sizeof edges / sizeof edges[ 0 ] && i < count; ++i )
+    {
+        pixels[ i ] = edges[ i ];
+    }
+    return pixels;
+}
+
+static QByteArray where( pixel_t count, int frame = 0 )
+{
+    return QString( "%1 pixels, frame %2" ).arg( count ).arg( frame ).toLatin1( );
+}
+
+void TestEffects::smear( )
+{
+    for ( size_t l = 0; l < LENGTH_COUNT; ++l )
+    {
+        pixel_t count( LENGTHS[ l ] );
+        std::vector< uint32_t > pixels( frame( count, count ) ), expected( pixels );
+        std::vector< uint32_t > scratch( count + 2 ), reference( count + 2 );
+        EffectChain::Smear( pixels.data( ), scratch.data( ), count );
+        EffectChain::SmearReference( expected.data( ), reference.data( ), count );
+        QVERIFY2( pixels == expected, where( count ).constData( ) );
+    }
+}
+
+void TestEffects::perturb( )
+{
+    const uint8_t AMOUNTS[] = { 1, 12, 100, 255 };
+    for ( size_t a = 0; a < sizeof AMOUNTS; ++a )
+    {
+        for ( size_t l = 0; l < LENGTH_COUNT; ++l )
+        {
+            pixel_t count( LENGTHS[ l ] );
+            uint32_t seeds[ 4 ] = { 1, 0x1234, 0x7fff, 0xdeadbeef };
+            uint32_t expectedSeeds[ 4 ];
+            memcpy( expectedSeeds, seeds, sizeof seeds );
+            std::vector< uint32_t > pixels( frame( count, count ) ), expected( pixels );
+            for ( int f = 0; f < FRAMES; ++f )
+            {
+                EffectChain::Perturb( pixels.data( ), count, seeds, AMOUNTS[ a ] );
+                EffectChain::PerturbReference( expected.data( ), count, expectedSeeds, AMOUNTS[ a ] );
+                QVERIFY2( pixels == expected, where( count, f ).constData( ) );
+                QVERIFY2( memcmp( seeds, expectedSeeds, sizeof seeds ) == 0, where( count, f ).constData( ) );
+            }
+        }
+    }
+}
+
+void TestEffects::decay( )
+{
+    const uint8_t KEEPS[] = { 0, 1, 224, 255 };
+    for ( size_t k = 0; k < sizeof KEEPS; ++k )
+    {
+        for ( size_t l = 0; l < LENGTH_COUNT; ++l )
+        {
+            pixel_t count( LENGTHS[ l ] );
+            std::vector< uint32_t > history( frame( count, ~count ) ), expectedHistory( history );
+            for ( int f = 0; f < FRAMES; ++f )
+            {
+                std::vector< uint32_t > pixels( frame( count, count * FRAMES + f ) ), expected( pixels );
+                EffectChain::Decay( pixels.data( ), history.data( ), count, KEEPS[ k ] );
+                EffectChain::DecayReference( expected.data( ), expectedHistory.data( ), count, KEEPS[ k ] );
+                QVERIFY2( pixels == expected, where( count, f ).constData( ) );
+                QVERIFY2( history == expectedHistory, where( count, f ).constData( ) );
+            }
+        }
+    }
+}
+
+void TestEffects::mirror( )
+{
+    for ( size_t l = 0; l < LENGTH_COUNT; ++l )
+    {
+        pixel_t count( LENGTHS[ l ] );
+        std::vector< uint32_t > pixels( frame( count, count ) ), expected( pixels );
+        EffectChain::Mirror( pixels.data( ), count );
+        EffectChain::MirrorReference( expected.data( ), count );
+        QVERIFY2( pixels == expected, where( count ).constData( ) );
+    }
+}
+
+void TestEffects::reverse( )
+{
+    for ( size_t l = 0; l < LENGTH_COUNT; ++l )
+    {
+        pixel_t count( LENGTHS[ l ] );
+        std::vector< uint32_t > pixels( frame( count, count ) ), expected( pixels );
+        EffectChain::Reverse( pixels.data( ), count );
+        EffectChain::ReverseReference( expected.data( ), count );
+        QVERIFY2( pixels == expected, where( count ).constData( ) );
+    }
+}
+
+void TestEffects::leavesFrame( )
+{
+    const pixel_t count( 37 );
+    std::vector< uint32_t > pixels( frame( count, 1 ) );
+    Stripper strip( count, 0, 0 );
+    memcpy( strip.getPixels( ), pixels.data( ), count * sizeof( uint32_t ) );
+
+    // reversing twice over the same pattern frame still shows it reversed once
+    EffectChain chain;
+    chain.SetEffects( EFFECT_REVERSE );
+    std::vector< uint32_t > scratch( count );
+    for ( int f = 0; f < 2; ++f )
+    {
+        chain.Apply( &strip );
+        QVERIFY( memcmp( strip.getPixels( ), pixels.data( ), count * sizeof( uint32_t ) ) == 0 );
+        const uint32_t *colors( strip.getColors( 0, count, scratch.data( ) ) );
+        for ( pixel_t i = 0; i < count; ++i )
+        {
+            QCOMPARE( colors[ i ], pixels[ count - 1 - i ] );
+        }
+    }
+
+    // and the frame goes out as it is once the effects are off
+    chain.SetEffects( EFFECT_NONE );
+    chain.Apply( &strip );
+    QCOMPARE( strip.getColors( 0, count, scratch.data( ) ), ( const uint32_t * )strip.getPixels( ) );
+}
+
+void TestEffects::trailsFade( )
+{
+    // one pixel lit for a frame, then the pattern leaves it dark
+    const pixel_t count( 9 );
+    Stripper strip( count, 0, 0 );
+    strip.setAllColor( 0 );
+    strip.setPixelColor( 4, 0xffffffff );
+
+    EffectChain chain;
+    chain.SetEffects( EFFECT_DECAY );
+    chain.Apply( &strip );
+    strip.setPixelColor( 4, 0 );
+
+    std::vector< uint32_t > scratch( count );
+    uint32_t last( 0xff );
+    for ( int f = 0; f < 100 && last; ++f )
+    {
+        chain.Apply( &strip );
+        QCOMPARE( strip.getPixelColor( 4 ), 0u );
+        uint32_t red( StripBase::Red( strip.getColors( 0, count, scratch.data( ) )[ 4 ] ) );
+        QVERIFY( red < last );
+        last = red;
+    }
+    QCOMPARE( last, 0u );
+}
+
+void TestEffects::views( )
+{
+    // effects on one zone, the rest of the strip goes out untouched
+    const pixel_t count( 20 );
+    std::vector< uint32_t > pixels( frame( count, 2 ) );
+    Stripper strip( count, 0, 0 );
+    memcpy( strip.getPixels( ), pixels.data( ), count * sizeof( uint32_t ) );
+    Stripper zone( &strip, 5, 10 );
+
+    EffectChain chain;
+    chain.SetEffects( EFFECT_REVERSE );
+    chain.Apply( &zone );
+    QVERIFY( memcmp( strip.getPixels( ), pixels.data( ), count * sizeof( uint32_t ) ) == 0 );
+
+    std::vector< uint32_t > scratch( count );
+    const uint32_t *colors( strip.getColors( 0, count, scratch.data( ) ) );
+    for ( pixel_t i = 0; i < count; ++i )
+    {
+        pixel_t from( ( i >= 5 && i < 15 ) ? 19 - i : i );
+        QCOMPARE( colors[ i ], pixels[ from ] );
+    }
+}
+
+QTEST_APPLESS_MAIN( TestEffects )
+
+#include "tst_effects.moc"
@@ -0,0 +1,18 @@
+QT       = core testlib
+
+CONFIG += console c++11 testcase thread
+CONFIG -= app_bundle
+
+TARGET = tst_framering
+
+# shm_open
+linux: LIBS += -lrt
+
+INCLUDEPATH += $$PWD/../..
+
+SOURCES += \
+    tst_framering.cpp \
+    ../../FrameRing.cpp
+
+HEADERS += \
+    ../../FrameRing.h
@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <QtTest>
+#include "FrameRing.h"
+
+
+// the reader side of FrameRing, as an outside process would use it
+class TestFrameRing : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init( );
+    void cleanup( );
+
+    void readBack( );
+    void overwritten( );
+    void clipped( );
+    void torn( );
+    void restart( );
+    void badSegment( );
+
+private:
+    char m_name[ 64 ];
+};
+
+
+const uint32_t CAPACITY = 300;
+const uint32_t SLOTS = 4;
+
+
+// every pixel of frame n is n, so a torn read shows up as a mix
+static void fill( std::vector< uint32_t > &pixels, uint32_t frame )
+{
+    for ( size_t i = 0; i < pixels.size( ); ++i )
+    {
+        pixels[ i ] = frame;
+    }
+}
+
+void TestFrameRing::init( )
+{
+    snprintf( m_name, sizeof m_name, "/tst_framering.%d", ( int )getpid( ));
+}
+
+void TestFrameRing::cleanup( )
+{
+    shm_unlink( m_name );
+}
+
+void TestFrameRing::readBack( )
+{
+    FrameRing writer, reader;
+    QVERIFY( !reader.open( m_name ));
+    QVERIFY( writer.create( m_name, CAPACITY, SLOTS ));
+    QVERIFY( reader.open( m_name ));
+    QCOMPARE( reader.capacity( ), CAPACITY );
+    QCOMPARE( reader.head( ), 0u );
+
+    std::vector< uint32_t > pixels( CAPACITY ), got( CAPACITY );
+    uint32_t none[ 1 ];
+    QVERIFY( !reader.readLatest( none, 1, NULL ));
+
+    fill( pixels, 0x123456 );
+    writer.publish( pixels.data( ), CAPACITY, 5000, 77 );
+    QCOMPARE( reader.head( ), 1u );
+
+    FrameRing::Info info;
+    QVERIFY( reader.readLatest( got.data( ), CAPACITY, &info ));
+    QCOMPARE( info.frame, 1u );
+    QCOMPARE( info.count, CAPACITY );
+    QCOMPARE( info.time, 5000u );
+    QCOMPARE( info.brightness, uint8_t( 77 ));
+    QVERIFY( got == pixels );
+
+    const uint32_t *in( reader.peek( 1, &info ));
+    QVERIFY( in );
+    QCOMPARE( in[ CAPACITY - 1 ], 0x123456u );
+    QVERIFY( reader.valid( 1 ));
+    QVERIFY( !reader.peek( 2, &info ));
+}
+
+void TestFrameRing::overwritten( )
+{
+    FrameRing writer, reader;
+    QVERIFY( writer.create( m_name, CAPACITY, SLOTS ));
+    QVERIFY( reader.open( m_name ));
+
+    std::vector< uint32_t > pixels( CAPACITY ), got( CAPACITY );
+    for ( uint32_t frame = 1; frame <= SLOTS + 1; ++frame )
+    {
+        fill( pixels, frame );
+        writer.publish( pixels.data( ), CAPACITY, frame, 255 );
+    }
+    // frame 1's slot now holds the newest one
+    QVERIFY( !reader.valid( 1 ));
+    QVERIFY( !reader.read( 1, got.data( ), CAPACITY, NULL ));
+    for ( uint32_t frame = 2; frame <= SLOTS + 1; ++frame )
+    {
+        QVERIFY( reader.read( frame, got.data( ), CAPACITY, NULL ));
+        QCOMPARE( got[ 0 ], frame );
+    }
+}
+
+void TestFrameRing::clipped( )
+{
+    FrameRing writer, reader;
+    QVERIFY( writer.create( m_name, CAPACITY, SLOTS ));
+    QVERIFY( reader.open( m_name ));
+
+    // more than the ring holds is cut to its capacity
+    std::vector< uint32_t > pixels( CAPACITY * 2 );
+    fill( pixels, 9 );
+    writer.publish( pixels.data( ), pixels.size( ), 0, 255 );
+
+    // and less than the frame copies only what fits
+    std::vector< uint32_t > got( 11, 0 );
+    FrameRing::Info info;
+    QVERIFY( reader.read( 1, got.data( ), 10, &info ));
+    QCOMPARE( info.count, 10u );
+    QCOMPARE( got[ 9 ], 9u );
+    QCOMPARE( got[ 10 ], 0u );
+
+    QVERIFY( reader.peek( 1, &info ));
+    QCOMPARE( info.count, CAPACITY );
+}
+
+void TestFrameRing::torn( )
+{
+    // a reader racing a writer that never waits for it only ever gets whole frames
+    FrameRing writer, reader;
+    QVERIFY( writer.create( m_name, CAPACITY, 2 ));
+    QVERIFY( reader.open( m_name ));
+
+    std::atomic< bool > done( false );
+    std::thread publisher( [ & ]( )
+    {
+        std::vector< uint32_t > pixels( CAPACITY );
+        for ( uint32_t frame = 1; frame <= 200000; ++frame )
+        {
+            fill( pixels, frame );
+            writer.publish( pixels.data( ), CAPACITY, frame, 255 );
+        }
+        done = true;
+    });
+
+    std::vector< uint32_t > got( CAPACITY );
+    int reads( 0 ), mixed( 0 );
+    while ( !done )
+    {
+        FrameRing::Info info;
+        if ( !reader.readLatest( got.data( ), CAPACITY, &info ))
+        {
+            continue;
+        }
+        ++reads;
+        for ( uint32_t i = 0; i < info.count; ++i )
+        {
+            if ( got[ i ] != info.frame )
+            {
+                ++mixed;
+                break;
+            }
+        }
+    }
+    publisher.join( );
+    QCOMPARE( mixed, 0 );
+    QVERIFY( reads > 0 );
+}
+
+void TestFrameRing::restart( )
+{
+    // a reader holding a ring whose writer restarts, with another shape,
+    // stays in bounds, notices, and follows it by opening again
+    FrameRing *writer( new FrameRing );
+    FrameRing reader;
+    QVERIFY( writer->create( m_name, CAPACITY, SLOTS ));
+    QVERIFY( reader.open( m_name ));
+    std::vector< uint32_t > pixels( CAPACITY * 4 ), got( CAPACITY * 4 );
+    fill( pixels, 1 );
+    writer->publish( pixels.data( ), CAPACITY, 0, 255 );
+    QVERIFY( !reader.stale( ));
+
+    FrameRing second;
+    QVERIFY( second.create( m_name, CAPACITY * 4, 1 ));
+    delete writer;
+    QVERIFY( reader.stale( ));
+    QCOMPARE( reader.head( ), 0u );
+    QVERIFY( !reader.valid( 1 ));
+    QVERIFY( !reader.peek( 1, NULL ));
+    QVERIFY( !reader.readLatest( got.data( ), got.size( ), NULL ));
+
+    QVERIFY( reader.open( m_name ));
+    QVERIFY( !reader.stale( ));
+    QCOMPARE( reader.capacity( ), CAPACITY * 4 );
+    fill( pixels, 2 );
+    for ( int i = 0; i < 3; ++i )
+    {
+        second.publish( pixels.data( ), pixels.size( ), 0, 255 );
+    }
+    FrameRing::Info info;
+    QVERIFY( reader.readLatest( got.data( ), got.size( ), &info ));
+    QCOMPARE( info.frame, 3u );
+    QCOMPARE( info.count, CAPACITY * 4 );
+    QVERIFY( got == pixels );
+}
+
+void TestFrameRing::badSegment( )
+{
+    // headers that would send a reader out of the mapping are refused
+    struct Bad
+    {
+        uint32_t slotCount;
+        uint32_t capacity;
+        uint32_t slotBytes;
+        off_t size;
+    };
+    const uint32_t fits( 64 * 1024 );
+    const Bad bad[] = {
+        { 0, 10, 128, 4096 }, // no slots
+        { 4, 10, 8, 4096 }, // slots smaller than their pixels
+        { 4, 10, 1024, 4096 }, // past the end of the segment
+        { 1, fits, fits * 4 + 64, 4096 },
+    };
+    for ( size_t b = 0; b < sizeof bad / sizeof bad[ 0 ]; ++b )
+    {
+        shm_unlink( m_name );
+        int fd( shm_open( m_name, O_RDWR | O_CREAT | O_EXCL, 0644 ));
+        QVERIFY( fd >= 0 );
+        QVERIFY( ftruncate( fd, bad[ b ].size ) == 0 );
+        uint32_t header[ 5 ] = { FrameRing::MAGIC, FrameRing::VERSION,
+                                 bad[ b ].slotCount, bad[ b ].capacity, bad[ b ].slotBytes };
+        QVERIFY( write( fd, header, sizeof header ) == sizeof header );
+        close( fd );
+
+        FrameRing reader;
+        QVERIFY2( !reader.open( m_name ), qPrintable( QString( "case %1" ).arg( b )));
+        QVERIFY( !reader.isOpen( ));
+    }
+}
+
+QTEST_APPLESS_MAIN( TestFrameRing )
+
+#include "tst_framering.moc"
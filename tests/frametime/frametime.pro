@@ -0,0 +1,30 @@
+QT       = core testlib
+
+# run by make benchmark, not make check
+CONFIG += console c++11 testcase benchmark
+CONFIG -= app_bundle
+
+TARGET = tst_frametime
+
+PROTOCOL_DIR = $$PWD/../../../radiopixel-protocol
+
+INCLUDEPATH += $$PWD/../.. $$PROTOCOL_DIR
+
+SOURCES += \
+    tst_frametime.cpp \
+    ../../Gradient.cpp \
+    ../../Layout.cpp \
+    ../../Pattern.cpp \
+    ../../StripBase.cpp \
+    ../../Stripper.cpp \
+    ../../Transition.cpp
+
+HEADERS += \
+    ../../Audio.h \
+    ../../Gradient.h \
+    ../../Layout.h \
+    ../../Pattern.h \
+    ../../PatternRegistry.h \
+    ../../StripBase.h \
+    ../../Stripper.h \
+    ../../Transition.h
@@ -0,0 +1,145 @@
+#include <QElapsedTimer>
+#include <QtTest>
+#include <radiopixel_protocol.h>
+#include "Pattern.h"
+#include "Transition.h"
+
+
+// Frame time of every pattern from 1k to 1M pixels, as a table of ns per
+// pixel per frame, and of each transition's blend. Wall clock times depend on the machine and what else
+// it's doing, so this checks nothing and make check leaves it out; make
+// benchmark runs it.
+class BenchFrameTime : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void frameTime( );
+    void transition( );
+};
+
+
+const uint32_t COLORS[ 3 ] = { RED, 0x40c0ff, YELLOW };
+const uint8_t LEVELS[ 3 ] = { 128, 128, 128 };
+
+
+static void draw( Pattern *pattern, Stripper *strip, ms_t offset )
+{
+    pattern->Init( strip, COLORS, LEVELS, offset );
+}
+
+void BenchFrameTime::frameTime( )
+{
+    const uint8_t ids[] = {
+        RadioPixel::Command::MiniTwinkle, RadioPixel::Command::MiniSparkle,
+        RadioPixel::Command::Sparkle, RadioPixel::Command::Rainbow,
+        RadioPixel::Command::Flash, RadioPixel::Command::March,
+        RadioPixel::Command::Wipe, RadioPixel::Command::Gradient,
+        RadioPixel::Command::Fixed, RadioPixel::Command::Strobe,
+        RadioPixel::Command::CandyCane, PATTERN_RADIAL_RAINBOW,
+        PATTERN_PLASMA, PATTERN_SPECTRUM, PATTERN_BEAT
+    };
+    const pixel_t lengths[] = { 1000, 10000, 100000, 1000000 };
+    const size_t LENGTHS = sizeof lengths / sizeof lengths[ 0 ];
+    const int FRAMES = 24; // three loops, so loop-time work is in there too
+    const int RUNS = 3; // best of, against a busy machine
+
+    QString table( "pattern   ns/pixel/frame at" );
+    for ( size_t l = 0; l < LENGTHS; ++l )
+    {
+        table += QString( " %1" ).arg( lengths[ l ], 8 );
+    }
+    table += "   growth";
+    qInfo( ).noquote( ) << table;
+
+    for ( size_t p = 0; p < sizeof ids; ++p )
+    {
+        qint64 best[ LENGTHS ];
+        for ( size_t l = 0; l < LENGTHS; ++l )
+        {
+            Stripper strip( lengths[ l ], 0, 0 );
+            best[ l ] = -1;
+            for ( int run = 0; run < RUNS; ++run )
+            {
+                Pattern *pattern( CreatePattern( ids[ p ] ));
+                ms_t duration( pattern->GetDuration( &strip ));
+                QElapsedTimer timer;
+                timer.start( );
+                draw( pattern, &strip, 0 );
+                for ( int frame = 1; frame < FRAMES; ++frame )
+                {
+                    // the way Player drives it, Loop as each loop comes round
+                    ms_t at( frame * duration / 8 );
+                    if ( at / duration != ( frame - 1 ) * duration / 8 / duration )
+                    {
+                        pattern->Loop( &strip, at % duration );
+                    }
+                    else
+                    {
+                        pattern->Update( &strip, at % duration );
+                    }
+                }
+                qint64 ns( timer.nsecsElapsed( ));
+                delete pattern;
+                best[ l ] = ( best[ l ] < 0 || ns < best[ l ] ) ? ns : best[ l ];
+            }
+        }
+
+        QString row( QString( "%1" ).arg( ids[ p ], 7 ) + QString( 22, ' ' ));
+        for ( size_t l = 0; l < LENGTHS; ++l )
+        {
+            row += QString( " %1" ).arg( ( double )best[ l ] / lengths[ l ] / FRAMES, 8, 'f', 2 );
+        }
+
+        // per pixel cost at 1M over 10k, both past the fixed costs of a
+        // short strip; near 1 grows with the length, much over it faster
+        row += QString( " %1" ).arg( ( double )best[ LENGTHS - 1 ] * lengths[ 1 ] /
+                                     lengths[ LENGTHS - 1 ] / best[ 1 ], 8, 'f', 2 );
+        qInfo( ).noquote( ) << row;
+    }
+}
+
+void BenchFrameTime::transition( )
+{
+    // the blend alone, the outgoing pattern draws nothing
+    const struct { uint8_t kind; const char *name; } kinds[] = {
+        { TRANSITION_CROSSFADE, "crossfade" },
+        { TRANSITION_WIPE, "wipe" },
+        { TRANSITION_DISSOLVE, "dissolve" }
+    };
+    const pixel_t lengths[] = { 1000, 10000, 100000, 1000000 };
+    const size_t LENGTHS = sizeof lengths / sizeof lengths[ 0 ];
+    const ms_t DURATION = 1000;
+    const int FRAMES = 100;
+
+    QString table( "transition  ms/frame at" );
+    for ( size_t l = 0; l < LENGTHS; ++l )
+    {
+        table += QString( " %1" ).arg( lengths[ l ], 8 );
+    }
+    qInfo( ).noquote( ) << table;
+
+    for ( size_t k = 0; k < sizeof kinds / sizeof kinds[ 0 ]; ++k )
+    {
+        QString row( QString( "%1" ).arg( kinds[ k ].name, -23 ));
+        for ( size_t l = 0; l < LENGTHS; ++l )
+        {
+            Stripper strip( lengths[ l ], 0, 0 );
+            Transition transition;
+            transition.Set( kinds[ k ].kind, DURATION );
+            transition.Begin( new Pattern( ), 0, 100, &strip, 0 );
+            QElapsedTimer timer;
+            timer.start( );
+            for ( int frame = 0; frame < FRAMES; ++frame )
+            {
+                transition.Update( &strip, frame * DURATION / FRAMES );
+            }
+            row += QString( " %1" ).arg( timer.nsecsElapsed( ) / 1e6 / FRAMES, 8, 'f', 3 );
+        }
+        qInfo( ).noquote( ) << row;
+    }
+}
+
+QTEST_APPLESS_MAIN( BenchFrameTime )
+
+#include "tst_frametime.moc"
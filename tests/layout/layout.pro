@@ -0,0 +1,27 @@
+QT       = core testlib
+
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+TARGET = tst_layout
+
+PROTOCOL_DIR = $$PWD/../../../radiopixel-protocol
+
+INCLUDEPATH += $$PWD/../.. $$PROTOCOL_DIR
+
+SOURCES += \
+    tst_layout.cpp \
+    ../../Gradient.cpp \
+    ../../Layout.cpp \
+    ../../Pattern.cpp \
+    ../../StripBase.cpp \
+    ../../Stripper.cpp
+
+HEADERS += \
+    ../../Audio.h \
+    ../../Gradient.h \
+    ../../Layout.h \
+    ../../Pattern.h \
+    ../../PatternRegistry.h \
+    ../../StripBase.h \
+    ../../Stripper.h
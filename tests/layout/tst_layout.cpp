@@ -0,0 +1,246 @@
+#include <vector>
+#include <QtTest>
+#include "Layout.h"
+#include "Pattern.h"
+
+
+// forward and inverse maps of each wiring, and layout patterns on strips
+// their layout doesn't cover
+class TestLayout : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void rows( );
+    void serpentine( );
+    void columns( );
+    void serpentineColumns( );
+    void create( );
+    void points( );
+    void line( );
+    void fallback( );
+};
+
+
+const int WIDTH = 5;
+const int HEIGHT = 4;
+
+
+// every pixel's cell holds it, and every cell's pixel sits in it
+static void checkInverse( const Layout *layout )
+{
+    for ( pixel_t p = 0; p < layout->count( ); ++p )
+    {
+        QCOMPARE( layout->pixelAt( layout->x( p ), layout->y( p )), p );
+    }
+    for ( int y = 0; y < layout->height( ); ++y )
+    {
+        for ( int x = 0; x < layout->width( ); ++x )
+        {
+            pixel_t p( layout->pixelAt( x, y ));
+            QVERIFY( p != Layout::NONE );
+            QCOMPARE( layout->x( p ), x );
+            QCOMPARE( layout->y( p ), y );
+            QCOMPARE( layout->grid( )[ y * layout->width( ) + x ], p );
+        }
+    }
+}
+
+void TestLayout::rows( )
+{
+    Layout *layout( Layout::rows( WIDTH, HEIGHT, false ));
+    QVERIFY( layout );
+    QCOMPARE( layout->count( ), ( pixel_t )( WIDTH * HEIGHT ));
+    QCOMPARE( layout->width( ), WIDTH );
+    QCOMPARE( layout->height( ), HEIGHT );
+    for ( int y = 0; y < HEIGHT; ++y )
+    {
+        for ( int x = 0; x < WIDTH; ++x )
+        {
+            QCOMPARE( layout->pixelAt( x, y ), ( pixel_t )( y * WIDTH + x ));
+        }
+    }
+    checkInverse( layout );
+
+    // pattern coordinates run corner to corner
+    pixel_t last( WIDTH * HEIGHT - 1 );
+    QCOMPARE( layout->u( )[ 0 ], ( uint8_t )0 );
+    QCOMPARE( layout->v( )[ 0 ], ( uint8_t )0 );
+    QCOMPARE( layout->u( )[ last ], ( uint8_t )255 );
+    QCOMPARE( layout->v( )[ last ], ( uint8_t )255 );
+    QCOMPARE( layout->radius( )[ last ], ( uint8_t )255 );
+    delete layout;
+}
+
+void TestLayout::serpentine( )
+{
+    Layout *layout( Layout::rows( WIDTH, HEIGHT, true ));
+    QVERIFY( layout );
+    for ( int y = 0; y < HEIGHT; ++y )
+    {
+        for ( int x = 0; x < WIDTH; ++x )
+        {
+            // odd rows run back
+            int along( ( y & 1 ) ? WIDTH - 1 - x : x );
+            QCOMPARE( layout->pixelAt( x, y ), ( pixel_t )( y * WIDTH + along ));
+        }
+    }
+    checkInverse( layout );
+
+    // the end of one row sits above the start of the next
+    QCOMPARE( layout->x( WIDTH - 1 ), layout->x( WIDTH ));
+    QCOMPARE( layout->y( WIDTH ), layout->y( WIDTH - 1 ) + 1 );
+    delete layout;
+}
+
+void TestLayout::columns( )
+{
+    Layout *layout( Layout::columns( WIDTH, HEIGHT, false ));
+    QVERIFY( layout );
+    QCOMPARE( layout->width( ), WIDTH );
+    QCOMPARE( layout->height( ), HEIGHT );
+    for ( int y = 0; y < HEIGHT; ++y )
+    {
+        for ( int x = 0; x < WIDTH; ++x )
+        {
+            QCOMPARE( layout->pixelAt( x, y ), ( pixel_t )( x * HEIGHT + y ));
+        }
+    }
+    checkInverse( layout );
+    delete layout;
+}
+
+void TestLayout::serpentineColumns( )
+{
+    Layout *layout( Layout::columns( WIDTH, HEIGHT, true ));
+    QVERIFY( layout );
+    for ( int y = 0; y < HEIGHT; ++y )
+    {
+        for ( int x = 0; x < WIDTH; ++x )
+        {
+            int along( ( x & 1 ) ? HEIGHT - 1 - y : y );
+            QCOMPARE( layout->pixelAt( x, y ), ( pixel_t )( x * HEIGHT + along ));
+        }
+    }
+    checkInverse( layout );
+    delete layout;
+}
+
+void TestLayout::create( )
+{
+    const struct { const char *spec; bool columns; bool serpentine; } specs[] = {
+        { "rows:5x4", false, false },
+        { "serpentine:5x4", false, true },
+        { "columns:5x4", true, false },
+        { "serpentine-columns:5x4", true, true },
+    };
+    for ( size_t s = 0; s < sizeof specs / sizeof specs[ 0 ]; ++s )
+    {
+        Layout *parsed( Layout::create( specs[ s ].spec ));
+        Layout *built( specs[ s ].columns ?
+                       Layout::columns( WIDTH, HEIGHT, specs[ s ].serpentine ) :
+                       Layout::rows( WIDTH, HEIGHT, specs[ s ].serpentine ));
+        QVERIFY2( parsed, specs[ s ].spec );
+        QCOMPARE( parsed->count( ), built->count( ));
+        for ( pixel_t p = 0; p < built->count( ); ++p )
+        {
+            QCOMPARE( parsed->x( p ), built->x( p ));
+            QCOMPARE( parsed->y( p ), built->y( p ));
+        }
+        delete parsed;
+        delete built;
+    }
+
+    const char *bad[] = { "rows:0x4", "rows:5", "rows:ax4", "hexagon:5x4", "rows:5000x1" };
+    for ( size_t b = 0; b < sizeof bad / sizeof bad[ 0 ]; ++b )
+    {
+        QVERIFY2( !Layout::create( bad[ b ] ), bad[ b ] );
+    }
+}
+
+void TestLayout::points( )
+{
+    // an L, off the origin, with the last pixel on the first's cell
+    std::vector< int > xs, ys;
+    const int cells[][ 2 ] = { { 3, 7 }, { 3, 8 }, { 3, 9 }, { 4, 9 }, { 5, 9 }, { 3, 7 } };
+    for ( size_t i = 0; i < sizeof cells / sizeof cells[ 0 ]; ++i )
+    {
+        xs.push_back( cells[ i ][ 0 ] );
+        ys.push_back( cells[ i ][ 1 ] );
+    }
+    Layout *layout( Layout::points( xs, ys ));
+    QVERIFY( layout );
+    QCOMPARE( layout->count( ), ( pixel_t )6 );
+    QCOMPARE( layout->width( ), 3 );
+    QCOMPARE( layout->height( ), 3 );
+
+    // the first pixel wins a shared cell, the inverse map keeps both
+    QCOMPARE( layout->pixelAt( 0, 0 ), ( pixel_t )0 );
+    QCOMPARE( layout->x( 5 ), 0 );
+    QCOMPARE( layout->y( 5 ), 0 );
+    QCOMPARE( layout->pixelAt( 2, 2 ), ( pixel_t )4 );
+    QCOMPARE( layout->pixelAt( 1, 0 ), Layout::NONE );
+    QCOMPARE( layout->pixelAt( 2, 1 ), Layout::NONE );
+
+    QVERIFY( !Layout::points( std::vector< int >( ), std::vector< int >( )));
+    QVERIFY( !Layout::points( xs, std::vector< int >( 2 )));
+    delete layout;
+}
+
+void TestLayout::line( )
+{
+    // past the widest grid, the line wraps into rows
+    const pixel_t count( 5000 );
+    Layout *layout( Layout::line( count ));
+    QVERIFY( layout );
+    QCOMPARE( layout->count( ), count );
+    QCOMPARE( layout->width( ), 4096 );
+    QCOMPARE( layout->height( ), 2 );
+    QCOMPARE( layout->x( 4095 ), 4095 );
+    QCOMPARE( layout->x( 4096 ), 0 );
+    QCOMPARE( layout->y( 4096 ), 1 );
+    QCOMPARE( layout->pixelAt( 903, 1 ), count - 1 );
+    QCOMPARE( layout->pixelAt( 904, 1 ), Layout::NONE );
+    delete layout;
+}
+
+void TestLayout::fallback( )
+{
+    // a layout short of the strip is passed over for a line of the whole
+    // strip, so a layout pattern draws what it draws with none at all
+    const pixel_t count( 40 );
+    const uint32_t colors[ 3 ] = { RED, GREEN, BLUE };
+    const uint8_t levels[ 3 ] = { 128, 128, 128 };
+    const uint8_t ids[] = { PATTERN_RADIAL_RAINBOW, PATTERN_PLASMA };
+    Layout *small( Layout::rows( 4, 4, true ));
+    Layout *whole( Layout::rows( 8, 5, true ));
+    for ( size_t p = 0; p < sizeof ids; ++p )
+    {
+        Stripper plain( count, 0, 0 ), shortLaid( count, 0, 0 ), laid( count, 0, 0 );
+        shortLaid.setLayout( small );
+        laid.setLayout( whole );
+        Pattern *a( CreatePattern( ids[ p ] ));
+        Pattern *b( CreatePattern( ids[ p ] ));
+        Pattern *c( CreatePattern( ids[ p ] ));
+        a->Init( &plain, colors, levels, 300 );
+        b->Init( &shortLaid, colors, levels, 300 );
+        c->Init( &laid, colors, levels, 300 );
+        bool differs( false );
+        for ( pixel_t i = 0; i < count; ++i )
+        {
+            QCOMPARE( shortLaid.getPixelColor( i ), plain.getPixelColor( i ));
+            differs = differs || laid.getPixelColor( i ) != plain.getPixelColor( i );
+        }
+        // and one that covers it is used
+        QVERIFY( differs );
+        delete a;
+        delete b;
+        delete c;
+    }
+    delete small;
+    delete whole;
+}
+
+QTEST_APPLESS_MAIN( TestLayout )
+
+#include "tst_layout.moc"
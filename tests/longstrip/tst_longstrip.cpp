@@ -0,0 +1,86 @@
+#include <QtTest>
+#include <radiopixel_protocol.h>
+#include "Pattern.h"
+
+
+// strips far past 8 and 16 bit pixel counts draw the same picture at any
+// length; tests/frametime times them
+class TestLongStrip : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void scaleFree( );
+    void random( );
+};
+
+
+const pixel_t SHORT = 1000;
+const pixel_t LONG = 1000000;
+
+const uint32_t COLORS[ 3 ] = { RED, 0x40c0ff, YELLOW };
+const uint8_t LEVELS[ 3 ] = { 128, 128, 128 };
+
+
+static void draw( Pattern *pattern, Stripper *strip, ms_t offset )
+{
+    pattern->Init( strip, COLORS, LEVELS, offset );
+}
+
+void TestLongStrip::scaleFree( )
+{
+    // patterns placing color by relative position must draw pixel i of a
+    // short strip where a long strip has pixel i * LONG / SHORT
+    struct Case
+    {
+        uint8_t id;
+        ms_t offset;
+    };
+    const Case cases[] = {
+        { RadioPixel::Command::Rainbow, 0 },
+        { RadioPixel::Command::Rainbow, 700 },
+        { RadioPixel::Command::Wipe, 0 },
+        { RadioPixel::Command::Gradient, 0 }, // the maps start in order
+    };
+    Stripper small( SHORT, 0, 0 ), large( LONG, 0, 0 );
+    for ( size_t c = 0; c < sizeof cases / sizeof cases[ 0 ]; ++c )
+    {
+        Pattern *a( CreatePattern( cases[ c ].id ));
+        Pattern *b( CreatePattern( cases[ c ].id ));
+        draw( a, &small, cases[ c ].offset );
+        draw( b, &large, cases[ c ].offset );
+        for ( pixel_t i = 0; i < SHORT; ++i )
+        {
+            QVERIFY2( small.getPixelColor( i ) == large.getPixelColor( i * ( LONG / SHORT )),
+                      qPrintable( QString( "pattern %1 at %2 ms, pixel %3" )
+                          .arg( cases[ c ].id ).arg( cases[ c ].offset ).arg( i )));
+        }
+        delete a;
+        delete b;
+    }
+
+    TestPattern test;
+    draw( &test, &small, 0 );
+    draw( &test, &large, 0 );
+    for ( pixel_t i = 0; i < SHORT; ++i )
+    {
+        QCOMPARE( small.getPixelColor( i ), large.getPixelColor( i * ( LONG / SHORT )));
+    }
+}
+
+void TestLongStrip::random( )
+{
+    // pixel picks reach the whole strip, not just the first 2^15 or 2^16
+    pixel_t most( 0 );
+    for ( int i = 0; i < 10000; ++i )
+    {
+        pixel_t pick( ::random( LONG ));
+        QVERIFY( pick < LONG );
+        most = qMax( most, pick );
+    }
+    QVERIFY( most > LONG * 9 / 10 );
+}
+
+QTEST_APPLESS_MAIN( TestLongStrip )
+
+#include "tst_longstrip.moc"
@@ -0,0 +1,21 @@
+QT       = core testlib
+
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+TARGET = tst_pixelformat
+
+PROTOCOL_DIR = $$PWD/../../../radiopixel-protocol
+
+INCLUDEPATH += $$PWD/../.. $$PROTOCOL_DIR
+
+SOURCES += \
+    tst_pixelformat.cpp \
+    ../../PixelFormat.cpp \
+    ../../StripBase.cpp \
+    ../../Stripper.cpp
+
+HEADERS += \
+    ../../PixelFormat.h \
+    ../../StripBase.h \
+    ../../Stripper.h
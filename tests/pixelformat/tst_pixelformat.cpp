@@ -0,0 +1,135 @@
+#include <string.h>
+#include <random>
+#include <vector>
+#include <QtTest>
+#include "PixelFormat.h"
+#include "Stripper.h"
+
+
+// every format packed against the scalar reference and back
+class TestPixelFormat : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void matchesReference( );
+    void roundTrip( );
+    void scale( );
+    void packer( );
+};
+
+
+const PixelFormat FORMATS[] = { FORMAT_RGB, FORMAT_GRB, FORMAT_BGR, FORMAT_RGBW, FORMAT_RGB16 };
+const char *const NAMES[] = { "rgb", "grb", "bgr", "rgbw", "rgb16" };
+const size_t FORMAT_COUNT = sizeof FORMATS / sizeof FORMATS[ 0 ];
+
+// every remainder of the four pixel SIMD groups, short and long
+const pixel_t LENGTHS[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 1021, 1022, 1023, 1024 };
+const size_t LENGTH_COUNT = sizeof LENGTHS / sizeof LENGTHS[ 0 ];
+
+
+// random colors with junk in alpha, which no format carries
+static std::vector< uint32_t > frame( pixel_t count, uint32_t seed )
+{
+    std::mt19937 random( seed );
+    std::vector< uint32_t > pixels( count );
+    for ( pixel_t i = 0; i < count; ++i )
+    {
+        pixels[ i ] = random( );
+    }
+    // grays and primaries, where white extraction takes all or nothing
+    const uint32_t edges[] = { 0x00000000, 0xffffffff, 0x12808080, 0x00ff0000, 0x0000ff00, 0x000000ff };
+    for ( size_t i = 0; i < sizeof edges / sizeof edges[ 0 ] && i < count; ++i )
+    {
+        pixels[ i ] = edges[ i ];
+    }
+    return pixels;
+}
+
+void TestPixelFormat::matchesReference( )
+{
+    for ( size_t f = 0; f < FORMAT_COUNT; ++f )
+    {
+        for ( size_t l = 0; l < LENGTH_COUNT; ++l )
+        {
+            std::vector< uint32_t > pixels( frame( LENGTHS[ l ], LENGTHS[ l ] ));
+            size_t bytes( LENGTHS[ l ] * PixelFormatSize( FORMATS[ f ] ));
+            // one over, to catch writes past the end
+            std::vector< uint8_t > packed( bytes + 1, 0xa5 ), expected( bytes + 1, 0xa5 );
+            PixelPacker::pack( FORMATS[ f ], pixels.data( ), LENGTHS[ l ], packed.data( ));
+            PixelPacker::packReference( FORMATS[ f ], pixels.data( ), LENGTHS[ l ], expected.data( ));
+            QVERIFY2( packed == expected,
+                      qPrintable( QString( "%1, %2 pixels" ).arg( NAMES[ f ] ).arg( LENGTHS[ l ] )));
+        }
+    }
+}
+
+void TestPixelFormat::roundTrip( )
+{
+    for ( size_t f = 0; f < FORMAT_COUNT; ++f )
+    {
+        for ( size_t l = 0; l < LENGTH_COUNT; ++l )
+        {
+            pixel_t count( LENGTHS[ l ] );
+            std::vector< uint32_t > pixels( frame( count, count ));
+            std::vector< uint8_t > packed( count * PixelFormatSize( FORMATS[ f ] ));
+            std::vector< uint32_t > unpacked( count );
+            PixelPacker::pack( FORMATS[ f ], pixels.data( ), count, packed.data( ));
+            PixelPacker::unpack( FORMATS[ f ], packed.data( ), count, unpacked.data( ));
+            for ( pixel_t i = 0; i < count; ++i )
+            {
+                QVERIFY2( ( unpacked[ i ] & 0xffffff ) == ( pixels[ i ] & 0xffffff ),
+                          qPrintable( QString( "%1, %2 pixels, pixel %3" )
+                              .arg( NAMES[ f ] ).arg( count ).arg( i )));
+            }
+        }
+    }
+}
+
+void TestPixelFormat::scale( )
+{
+    std::vector< uint32_t > pixels( frame( 1023, 7 ));
+    std::vector< uint32_t > scaled( pixels.size( ));
+    for ( int bright = 0; bright < 256; ++bright )
+    {
+        PixelPacker::scale( pixels.data( ), pixels.size( ), bright, scaled.data( ));
+        for ( size_t i = 0; i < pixels.size( ); ++i )
+        {
+            uint32_t expected( 0 );
+            for ( int shift = 0; shift < 32; shift += 8 )
+            {
+                expected |= ( ( ( pixels[ i ] >> shift ) & 0xff ) * bright / 255 ) << shift;
+            }
+            QCOMPARE( scaled[ i ], expected );
+        }
+    }
+}
+
+void TestPixelFormat::packer( )
+{
+    // a strip goes out with its brightness applied, in the packer's format
+    Stripper strip( 301, 0, 0 );
+    std::vector< uint32_t > pixels( frame( strip.numPixels( ), 3 ));
+    for ( pixel_t i = 0; i < strip.numPixels( ); ++i )
+    {
+        strip.setPixelColor( i, pixels[ i ] );
+    }
+    strip.setBrightness( 100 );
+    for ( size_t f = 0; f < FORMAT_COUNT; ++f )
+    {
+        PixelPacker packer( FORMATS[ f ] );
+        std::vector< uint8_t > packed( packer.packedSize( strip.numPixels( )));
+        QVERIFY( !packer.pack( &strip, packed.data( ), packed.size( ) - 1 ));
+        QCOMPARE( packer.pack( &strip, packed.data( ), packed.size( )), packed.size( ));
+
+        std::vector< uint32_t > faded( pixels.size( ));
+        PixelPacker::scale( pixels.data( ), pixels.size( ), 100, faded.data( ));
+        std::vector< uint8_t > expected( packed.size( ));
+        PixelPacker::packReference( FORMATS[ f ], faded.data( ), faded.size( ), expected.data( ));
+        QVERIFY2( packed == expected, NAMES[ f ] );
+    }
+}
+
+QTEST_APPLESS_MAIN( TestPixelFormat )
+
+#include "tst_pixelformat.moc"
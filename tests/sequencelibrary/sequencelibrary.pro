@@ -0,0 +1,31 @@
+QT       = core testlib
+
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+TARGET = tst_sequencelibrary
+
+PROTOCOL_DIR = $$PWD/../../../radiopixel-protocol
+
+INCLUDEPATH += $$PWD/../.. $$PROTOCOL_DIR
+
+SOURCES += \
+    tst_sequencelibrary.cpp \
+    ../../seqc/SequenceText.cpp \
+    ../../Effects.cpp \
+    ../../Gradient.cpp \
+    ../../Layout.cpp \
+    ../../Pattern.cpp \
+    ../../Player.cpp \
+    ../../Sequence.cpp \
+    ../../SequenceLibrary.cpp \
+    ../../StripBase.cpp \
+    ../../Stripper.cpp \
+    ../../Transition.cpp \
+    $$PROTOCOL_DIR/radiopixel_protocol.cpp
+
+HEADERS += \
+    ../../seqc/SequenceText.h \
+    ../../Player.h \
+    ../../SequenceLibrary.h \
+    ../../StripBase.h
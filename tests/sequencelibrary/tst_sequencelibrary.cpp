@@ -0,0 +1,285 @@
+#include <string.h>
+#include <QtTest>
+#include <QSaveFile>
+#include <QTemporaryDir>
+#include "Player.h"
+#include "SequenceLibrary.h"
+#include "seqc/SequenceText.h"
+
+
+// sequence text compiled by seqc, mapped by the library and played, the
+// library following its file as it's replaced, and what neither accepts
+class TestSequenceLibrary : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void compile( );
+    void play( );
+    void reload( );
+    void badText( );
+    void badImage( );
+};
+
+
+const char SHOW[] =
+    "# a comment, and a blank line\n"
+    "\n"
+    "sequence alert\n"
+    "4000   127 100 Flash   ffff00 ffff00 ffff00 255\n"
+    "60000  127 40  March   ff0000 00ff00 0000ff 34  smear+decay # trailing\n"
+    "0      63  75  Plasma  ff0000 ff4040 ff0000 75  none\n"
+    "sequence idle\n"
+    "0      20  35  Gradient ff0000 ffffff 00ff00 17 mirror\n";
+
+// alert down to one step, idle gone, a new one in
+const char CHANGED[] =
+    "sequence alert\n"
+    "1000   200 100 Strobe  ffffff 000000 ffffff 128\n"
+    "sequence spare\n"
+    "0      20  35  Fixed   0000ff 0000ff 0000ff 255\n"
+    "0      20  35  Fixed   00ff00 00ff00 00ff00 255\n";
+
+
+static QByteArray compiled( const char *source, QString *error )
+{
+    QString copy( source );
+    QTextStream text( &copy, QIODevice::ReadOnly );
+    return SequenceText::compile( text, error );
+}
+
+// the way seqc writes it, aside and renamed over
+static bool replace( const QString &path, const QByteArray &image )
+{
+    QSaveFile save( path );
+    return save.open( QIODevice::WriteOnly ) && save.write( image ) == image.size( ) && save.commit( );
+}
+
+void TestSequenceLibrary::compile( )
+{
+    QString error;
+    QByteArray image( compiled( SHOW, &error ));
+    QVERIFY2( !image.isEmpty( ), qPrintable( error ));
+    const uchar *data( ( const uchar *)image.constData( ));
+    QCOMPARE( SequenceLibrary::validate( data, image.size( )), QString( ));
+
+    const LibraryHeader *header( ( const LibraryHeader *)data );
+    const LibraryEntry *entries( ( const LibraryEntry *)( header + 1 ));
+    const Step *steps( ( const Step *)( entries + header->count ));
+    QCOMPARE( header->count, ( uint32_t )2 );
+    QCOMPARE( QString( entries[ 0 ].name ), QString( "alert" ));
+    QCOMPARE( entries[ 0 ].steps, ( uint32_t )3 );
+    QCOMPARE( QString( entries[ 1 ].name ), QString( "idle" ));
+    QCOMPARE( entries[ 1 ].first, ( uint32_t )3 );
+
+    const Step &march( steps[ 1 ] );
+    QCOMPARE( march.duration, ( ms_t )60000 );
+    QCOMPARE( march.brightness, ( uint8_t )127 );
+    QCOMPARE( march.speed, ( uint8_t )40 );
+    QCOMPARE( march.pattern, ( uint8_t )RadioPixel::Command::March );
+    QCOMPARE( march.colors[ 0 ], ( uint32_t )0xff0000 );
+    QCOMPARE( march.colors[ 2 ], ( uint32_t )0x0000ff );
+    QCOMPARE( march.level, ( uint8_t )34 );
+    QCOMPARE( march.effects, ( uint8_t )( EFFECT_SMEAR | EFFECT_DECAY ));
+    QCOMPARE( steps[ 0 ].effects, ( uint8_t )EFFECT_NONE );
+    QCOMPARE( steps[ 2 ].pattern, ( uint8_t )PATTERN_PLASMA );
+
+    // the dump compiles back to the same library
+    QString dumped( SequenceText::dump( data ));
+    QCOMPARE( compiled( qPrintable( dumped ), &error ), image );
+}
+
+void TestSequenceLibrary::play( )
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid( ));
+    QString path( dir.path( ) + "/show.rpsl" );
+    QString error;
+    QVERIFY( replace( path, compiled( SHOW, &error )));
+
+    SequenceLibrary library;
+    QVERIFY( library.open( path ));
+    QCOMPARE( library.names( ), QStringList( ) << "alert" << "idle" );
+    QVERIFY( !library.sequence( "missing" ));
+    Sequence *alert( library.sequence( "alert" ));
+    QVERIFY( alert );
+    QCOMPARE( library.sequence( "alert" ), alert );
+    QCOMPARE( alert->GetStepCount( ), 3 );
+
+    Player player;
+    Stripper strip( 30, 0, 0 );
+    player.SetSequence( alert, 0 );
+    QVERIFY( player.UpdatePattern( 0, &strip ));
+    RadioPixel::Command command;
+    QVERIFY( player.GetCommand( &command ));
+    QCOMPARE( command.pattern, ( uint8_t )RadioPixel::Command::Flash );
+    QCOMPARE( command.color[ 0 ], ( uint32_t )0xffff00 );
+    QCOMPARE( command.level[ 0 ], ( uint8_t )255 );
+
+    // on to the second step when the first one's time is up
+    QVERIFY( player.UpdatePattern( 4000, &strip ));
+    QCOMPARE( player.GetStep( ), 1 );
+    QVERIFY( player.GetCommand( &command ));
+    QCOMPARE( command.pattern, ( uint8_t )RadioPixel::Command::March );
+    QCOMPARE( command.color[ 1 ], ( uint32_t )0x00ff00 );
+    QCOMPARE( command.level[ 0 ], ( uint8_t )34 );
+}
+
+void TestSequenceLibrary::reload( )
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid( ));
+    QString path( dir.path( ) + "/show.rpsl" );
+    QString error;
+    QVERIFY( replace( path, compiled( SHOW, &error )));
+
+    SequenceLibrary library;
+    QVERIFY( library.open( path ));
+    Sequence *alert( library.sequence( "alert" ));
+    Sequence *idle( library.sequence( "idle" ));
+    Player player;
+    Stripper strip( 30, 0, 0 );
+    player.SetSequence( alert, 0 );
+    player.UpdatePattern( 0, &strip );
+    player.UpdatePattern( 60000, &strip );
+    player.UpdatePattern( 120000, &strip );
+    QCOMPARE( player.GetStep( ), 2 );
+
+    // a replaced file is picked up, and the sequences handed out follow it
+    QSignalSpy spy( &library, SIGNAL( reloaded()));
+    QVERIFY( replace( path, compiled( CHANGED, &error )));
+    QVERIFY( spy.wait( 5000 ));
+    QCOMPARE( library.names( ), QStringList( ) << "alert" << "spare" );
+    QCOMPARE( library.sequence( "alert" ), alert );
+    QCOMPARE( alert->GetStepCount( ), 1 );
+    QCOMPARE( alert->GetPatternId( 0 ), ( int )RadioPixel::Command::Strobe );
+    QCOMPARE( alert->GetBrightness( 0 ), 200 );
+    player.SequenceChanged( );
+    QCOMPARE( player.GetStep( ), 0 );
+
+    // one whose name went goes dark rather than dangling
+    QCOMPARE( idle->GetStepCount( ), 1 );
+    QCOMPARE( idle->GetBrightness( 0 ), 0 );
+    QCOMPARE( idle->GetPatternId( 0 ), ( int )RadioPixel::Command::Fixed );
+
+    // a broken file is passed over, the last good one keeps playing
+    QVERIFY( replace( path, QByteArray( "not a library at all" )));
+    QVERIFY( !spy.wait( 1000 ));
+    QCOMPARE( spy.count( ), 1 );
+    QCOMPARE( library.names( ), QStringList( ) << "alert" << "spare" );
+    QCOMPARE( alert->GetPatternId( 0 ), ( int )RadioPixel::Command::Strobe );
+
+    // and a good one after it is picked up again
+    QVERIFY( replace( path, compiled( SHOW, &error )));
+    QVERIFY( spy.wait( 5000 ));
+    QCOMPARE( alert->GetStepCount( ), 3 );
+    QCOMPARE( idle->GetPatternId( 0 ), ( int )RadioPixel::Command::Gradient );
+}
+
+void TestSequenceLibrary::badText( )
+{
+    const char *bad[] = {
+        // a step before any sequence
+        "4000 127 100 Flash ffff00 ffff00 ffff00 255\n",
+        // names repeated, missing, spaced or too long
+        "sequence a\n0 1 1 Fixed 0 0 0 0\nsequence a\n0 1 1 Fixed 0 0 0 0\n",
+        "sequence\n0 1 1 Fixed 0 0 0 0\n",
+        "sequence a b\n0 1 1 Fixed 0 0 0 0\n",
+        "sequence abcdefghijklmnopqrstuvwx\n0 1 1 Fixed 0 0 0 0\n",
+        // a sequence with nothing to play
+        "sequence a\nsequence b\n0 1 1 Fixed 0 0 0 0\n",
+        // steps short, long, out of range or unknown
+        "sequence a\n0 1 1 Fixed 0 0 0\n",
+        "sequence a\n0 1 1 Fixed 0 0 0 0 none extra\n",
+        "sequence a\n0 256 1 Fixed 0 0 0 0\n",
+        "sequence a\n0 1 256 Fixed 0 0 0 0\n",
+        "sequence a\n0 1 1 Fixed 0 0 0 256\n",
+        "sequence a\n0 1 1 256 0 0 0 0\n",
+        "sequence a\n1.5 1 1 Fixed 0 0 0 0\n",
+        "sequence a\n0 1 1 Nothing 0 0 0 0\n",
+        "sequence a\n0 1 1 Fixed 0 0 red 0\n",
+        "sequence a\n0 1 1 Fixed 0 0 0 0 smear+glow\n",
+    };
+    for ( size_t b = 0; b < sizeof bad / sizeof bad[ 0 ]; ++b )
+    {
+        QString error;
+        QVERIFY2( compiled( bad[ b ], &error ).isEmpty( ), bad[ b ] );
+        QVERIFY2( !error.isEmpty( ), bad[ b ] );
+    }
+
+    // and the line is in the error
+    QString error;
+    compiled( "sequence a\n0 1 1 Fixed 0 0 0 0\n\n0 1 1 Fixed 0 0\n", &error );
+    QVERIFY2( error.startsWith( "line 4:" ), qPrintable( error ));
+}
+
+// a good image with something wrong done to it
+typedef void ( *Damage )( QByteArray *image );
+
+static LibraryHeader *header( QByteArray *image )
+{
+    return ( LibraryHeader *)image->data( );
+}
+
+static LibraryEntry *entry( QByteArray *image, int i )
+{
+    return ( LibraryEntry *)( image->data( ) + sizeof( LibraryHeader )) + i;
+}
+
+static void shortened( QByteArray *image ) { image->resize( sizeof( LibraryHeader ) - 1 ); }
+static void magic( QByteArray *image ) { header( image )->magic ^= 1; }
+static void version( QByteArray *image ) { header( image )->version = LIBRARY_VERSION + 1; }
+static void stepSize( QByteArray *image ) { header( image )->stepSize = sizeof( Step ) + 1; }
+static void truncated( QByteArray *image ) { image->chop( 1 ); }
+static void stepless( QByteArray *image ) { image->resize( sizeof( LibraryHeader ) + 2 * sizeof( LibraryEntry )); }
+static void counted( QByteArray *image ) { header( image )->count = 1000; }
+static void unnamed( QByteArray *image ) { memset( entry( image, 1 )->name, 'x', LIBRARY_NAME_SIZE ); }
+static void empty( QByteArray *image ) { entry( image, 0 )->steps = 0; }
+static void overrun( QByteArray *image ) { entry( image, 1 )->first = 3; entry( image, 1 )->steps = 2; }
+
+void TestSequenceLibrary::badImage( )
+{
+    QString error;
+    const QByteArray good( compiled( SHOW, &error ));
+    const struct { const char *name; Damage damage; } damages[] = {
+        { "shortened", shortened },
+        { "magic", magic },
+        { "version", version },
+        { "stepSize", stepSize },
+        { "truncated", truncated },
+        { "stepless", stepless },
+        { "counted", counted },
+        { "unnamed", unnamed },
+        { "empty", empty },
+        { "overrun", overrun },
+    };
+
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid( ));
+    for ( size_t d = 0; d < sizeof damages / sizeof damages[ 0 ]; ++d )
+    {
+        QByteArray image( good );
+        damages[ d ].damage( &image );
+        QVERIFY2( !SequenceLibrary::validate( ( const uchar *)image.constData( ), image.size( )).isEmpty( ),
+                  damages[ d ].name );
+
+        // a library that opens on one has nothing to hand out
+        QString path( dir.path( ) + "/" + damages[ d ].name + ".rpsl" );
+        QVERIFY( replace( path, image ));
+        SequenceLibrary library;
+        QVERIFY2( !library.open( path ), damages[ d ].name );
+        QVERIFY( library.names( ).isEmpty( ));
+        QVERIFY( !library.sequence( "alert" ));
+    }
+
+    // nor does one whose file isn't there yet, or is empty
+    SequenceLibrary missing;
+    QVERIFY( !missing.open( dir.path( ) + "/missing.rpsl" ));
+    QVERIFY( replace( dir.path( ) + "/empty.rpsl", QByteArray( )));
+    SequenceLibrary blank;
+    QVERIFY( !blank.open( dir.path( ) + "/empty.rpsl" ));
+}
+
+QTEST_GUILESS_MAIN( TestSequenceLibrary )
+
+#include "tst_sequencelibrary.moc"
@@ -0,0 +1,15 @@
+TEMPLATE = subdirs
+
+# each one a QtTest executable, make check runs them all but frametime,
+# which make benchmark runs
+SUBDIRS += \
+    audio \
+    effects \
+    framering \
+    frametime \
+    layout \
+    longstrip \
+    pixelformat \
+    sequencelibrary \
+    transition \
+    ws2812
@@ -0,0 +1,195 @@
+#include <string.h>
+#include <random>
+#include <vector>
+#include <QtTest>
+#include "Pattern.h"
+#include "Transition.h"
+
+
+// the blend kernels against their scalar loops, and a blend over a strip
+// that was indexed when the change came
+class TestTransition : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void crossfade( );
+    void dissolve( );
+    void wipe( );
+    void indexed( );
+    void indexedDissolve( );
+};
+
+
+// every remainder of the four pixel SIMD groups, short and long
+const pixel_t LENGTHS[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 15, 16, 17, 1021, 1022, 1023, 1024 };
+const size_t LENGTH_COUNT = sizeof LENGTHS / sizeof LENGTHS[ 0 ];
+
+// the ends, either side of the half way rounding, and a few between
+const uint8_t MIXES[] = { 0, 1, 2, 64, 127, 128, 129, 200, 254, 255 };
+
+const ms_t DURATION = 1000;
+
+
+static std::vector< uint32_t > frame( pixel_t count, uint32_t seed )
+{
+    std::mt19937 random( seed );
+    std::vector< uint32_t > pixels( count );
+    for ( pixel_t i = 0; i < count; ++i )
+    {
+        pixels[ i ] = random( );
+    }
+    // saturated and empty channels, where the 16 bit lanes could wrap
+    const uint32_t edges[] = { 0x00000000, 0xffffffff, 0xff00ff00, 0x00ff00ff, 0xfffe0102 };
+    for ( size_t i = 0; i < sizeof edges / sizeof edges[ 0 ] && i < count; ++i )
+    {
+        pixels[ i ] = edges[ i ];
+    }
+    return pixels;
+}
+
+static QByteArray where( pixel_t count, uint8_t mix )
+{
+    return QString( "%1 pixels, mix %2" ).arg( count ).arg( mix ).toLatin1( );
+}
+
+void TestTransition::crossfade( )
+{
+    for ( size_t l = 0; l < LENGTH_COUNT; ++l )
+    {
+        pixel_t count( LENGTHS[ l ] );
+        std::vector< uint32_t > from( frame( count, count ) ), to( frame( count, ~count ) );
+        for ( size_t m = 0; m < sizeof MIXES; ++m )
+        {
+            std::vector< uint32_t > out( count ), expected( count );
+            Transition::Crossfade( from.data( ), to.data( ), out.data( ), count, MIXES[ m ] );
+            Transition::CrossfadeReference( from.data( ), to.data( ), expected.data( ), count, MIXES[ m ] );
+            QVERIFY2( out == expected, where( count, MIXES[ m ] ).constData( ) );
+        }
+
+        // and the ends are the frames themselves
+        std::vector< uint32_t > out( count );
+        Transition::Crossfade( from.data( ), to.data( ), out.data( ), count, 0 );
+        QVERIFY( out == from );
+        Transition::Crossfade( from.data( ), to.data( ), out.data( ), count, 255 );
+        QVERIFY( out == to );
+    }
+}
+
+void TestTransition::dissolve( )
+{
+    for ( size_t l = 0; l < LENGTH_COUNT; ++l )
+    {
+        pixel_t count( LENGTHS[ l ] );
+        std::vector< uint32_t > from( frame( count, count ) ), to( frame( count, ~count ) );
+
+        // every threshold, including the ones past the signed byte range
+        std::vector< uint8_t > order( count );
+        for ( pixel_t i = 0; i < count; ++i )
+        {
+            order[ i ] = ( i * 97 ) & 0xff;
+        }
+        for ( size_t m = 0; m < sizeof MIXES; ++m )
+        {
+            std::vector< uint32_t > out( count ), expected( count );
+            Transition::Dissolve( from.data( ), to.data( ), order.data( ), out.data( ), count, MIXES[ m ] );
+            Transition::DissolveReference( from.data( ), to.data( ), order.data( ), expected.data( ), count, MIXES[ m ] );
+            QVERIFY2( out == expected, where( count, MIXES[ m ] ).constData( ) );
+        }
+    }
+}
+
+void TestTransition::wipe( )
+{
+    for ( size_t l = 0; l < LENGTH_COUNT; ++l )
+    {
+        pixel_t count( LENGTHS[ l ] );
+        std::vector< uint32_t > from( frame( count, count ) ), to( frame( count, ~count ) );
+        for ( size_t m = 0; m < sizeof MIXES; ++m )
+        {
+            std::vector< uint32_t > out( count );
+            Transition::Wipe( from.data( ), to.data( ), out.data( ), count, MIXES[ m ] );
+            pixel_t edge( ( uint64_t )count * MIXES[ m ] / 255 );
+            for ( pixel_t i = 0; i < count; ++i )
+            {
+                QCOMPARE( out[ i ], i < edge ? to[ i ] : from[ i ] );
+            }
+        }
+    }
+}
+
+// an indexed strip showing a few palette colors, odd so the scalar tail runs
+static void paint( Stripper *strip, std::vector< uint32_t > *colors )
+{
+    const uint32_t palette[] = { 0xff0000, 0x00ff00, 0x0000ff, 0xffffff, 0x123456 };
+    strip->setIndexed( true );
+    colors->resize( strip->numPixels( ) );
+    for ( pixel_t i = 0; i < strip->numPixels( ); ++i )
+    {
+        ( *colors )[ i ] = palette[ i % 5 ];
+        strip->setPixelColor( i, ( *colors )[ i ] );
+    }
+}
+
+void TestTransition::indexed( )
+{
+    const pixel_t count( 37 );
+    Stripper strip( count, 0, 0 );
+    std::vector< uint32_t > colors;
+    paint( &strip, &colors );
+    QVERIFY( strip.isIndexed( ));
+
+    // the base pattern draws nothing, so the outgoing frame holds still
+    Transition transition;
+    transition.Set( TRANSITION_CROSSFADE, DURATION );
+    QVERIFY( transition.Begin( new Pattern( ), 0, 100, &strip, 0 ));
+    QVERIFY( !strip.isIndexed( ));
+    std::vector< uint32_t > to( frame( count, 3 ));
+    memcpy( transition.Target( )->getPixels( ), to.data( ), count * sizeof( uint32_t ));
+
+    // halfway the blend is of the colors the indices stood for
+    QVERIFY( transition.Update( &strip, DURATION / 2 ));
+    uint8_t mix( ( uint64_t )( DURATION / 2 ) * 255 / DURATION );
+    std::vector< uint32_t > expected( count );
+    Transition::CrossfadeReference( colors.data( ), to.data( ), expected.data( ), count, mix );
+    QVERIFY( memcmp( strip.getPixels( ), expected.data( ), count * sizeof( uint32_t )) == 0 );
+
+    // and it ends on the incoming frame
+    QVERIFY( !transition.Update( &strip, DURATION ));
+    QVERIFY( memcmp( strip.getPixels( ), to.data( ), count * sizeof( uint32_t )) == 0 );
+}
+
+void TestTransition::indexedDissolve( )
+{
+    const pixel_t count( 37 );
+    Stripper strip( count, 0, 0 );
+    std::vector< uint32_t > colors;
+    paint( &strip, &colors );
+
+    Transition transition;
+    transition.Set( TRANSITION_DISSOLVE, DURATION );
+    QVERIFY( transition.Begin( new Pattern( ), 0, 100, &strip, 0 ));
+    std::vector< uint32_t > to( frame( count, 4 ));
+    memcpy( transition.Target( )->getPixels( ), to.data( ), count * sizeof( uint32_t ));
+
+    // every pixel is one side or the other, and only ever goes from to to
+    std::vector< bool > switched( count, false );
+    for ( ms_t now = 0; now < DURATION; now += DURATION / 20 )
+    {
+        QVERIFY( transition.Update( &strip, now ));
+        for ( pixel_t i = 0; i < count; ++i )
+        {
+            uint32_t pixel( strip.getPixels( )[ i ] );
+            QVERIFY( pixel == colors[ i ] || pixel == to[ i ] );
+            if ( pixel == to[ i ] && pixel != colors[ i ] )
+            {
+                switched[ i ] = true;
+            }
+            QVERIFY( !switched[ i ] || pixel == to[ i ] );
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN( TestTransition )
+
+#include "tst_transition.moc"
@@ -0,0 +1,108 @@
+#include <string.h>
+#include <random>
+#include <vector>
+#include <QtTest>
+#include "Stripper.h"
+#include "Ws2812Encoder.h"
+
+
+// encode( ) against the bit at a time reference, byte for byte
+class TestWs2812 : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void direct( );
+    void indexed( );
+    void maxFps( );
+
+private:
+    void check( Stripper *strip, Ws2812Encoder::Symbol symbol );
+};
+
+
+// lengths with every remainder mod 4, short and across the encoder's
+// 256 pixel chunks
+const pixel_t LENGTHS[] = { 1, 2, 3, 4, 5, 6, 7, 8, 256, 257, 258, 259, 1021, 1022, 1023, 1024 };
+const uint8_t BRIGHTS[] = { 255, 77, 1, 0 };
+
+
+static void fill( Stripper *strip, uint32_t seed )
+{
+    std::mt19937 random( seed );
+    for ( pixel_t i = 0; i < strip->numPixels( ); ++i )
+    {
+        strip->setPixelColor( i, random( ) & 0xffffff );
+    }
+}
+
+void TestWs2812::check( Stripper *strip, Ws2812Encoder::Symbol symbol )
+{
+    Ws2812Encoder encoder( symbol );
+    const uint8_t *stream( encoder.encode( strip ));
+    QVERIFY( stream );
+    QCOMPARE( encoder.size( ), encoder.streamSize( strip->numPixels( )));
+
+    // what the wire should carry, GRB after brightness, then the low gap
+    std::vector< uint8_t > grb;
+    for ( pixel_t i = 0; i < strip->numPixels( ); ++i )
+    {
+        uint32_t c( Stripper::ColorFade( strip->getPixelColor( i ), strip->getBrightness( )));
+        grb.push_back( c >> 8 );
+        grb.push_back( c >> 16 );
+        grb.push_back( c );
+    }
+    std::vector< uint8_t > expected( encoder.size( ), 0xff );
+    Ws2812Encoder::encodeReference( grb.data( ), grb.size( ), symbol, expected.data( ));
+    memset( expected.data( ) + grb.size( ) * symbol, 0, expected.size( ) - grb.size( ) * symbol );
+
+    size_t at( 0 );
+    while ( at < expected.size( ) && stream[ at ] == expected[ at ] )
+    {
+        ++at;
+    }
+    QVERIFY2( at == expected.size( ),
+              qPrintable( QString( "%1 pixels, %2 bit symbols, brightness %3: byte %4 differs" )
+                  .arg( strip->numPixels( )).arg( symbol ).arg( strip->getBrightness( )).arg( at )));
+    QVERIFY( encoder.verify( strip ));
+}
+
+void TestWs2812::direct( )
+{
+    for ( size_t l = 0; l < sizeof LENGTHS / sizeof LENGTHS[ 0 ]; ++l )
+    {
+        Stripper strip( LENGTHS[ l ], 0, 0 );
+        fill( &strip, LENGTHS[ l ] );
+        for ( size_t b = 0; b < sizeof BRIGHTS; ++b )
+        {
+            strip.setBrightness( BRIGHTS[ b ] );
+            check( &strip, Ws2812Encoder::SYMBOL_3BIT );
+            check( &strip, Ws2812Encoder::SYMBOL_4BIT );
+        }
+    }
+}
+
+void TestWs2812::indexed( )
+{
+    for ( size_t l = 0; l < sizeof LENGTHS / sizeof LENGTHS[ 0 ]; ++l )
+    {
+        Stripper strip( LENGTHS[ l ], 0, 0 );
+        strip.setIndexed( true );
+        fill( &strip, LENGTHS[ l ] );
+        strip.setBrightness( 200 );
+        check( &strip, Ws2812Encoder::SYMBOL_3BIT );
+        check( &strip, Ws2812Encoder::SYMBOL_4BIT );
+    }
+}
+
+void TestWs2812::maxFps( )
+{
+    // 300 pixels of 3 bit symbols at 2.4 MHz: 2700 bytes plus a 90 byte gap
+    Ws2812Encoder encoder( Ws2812Encoder::SYMBOL_3BIT );
+    QCOMPARE( encoder.streamSize( 300 ), size_t( 2790 ));
+    QVERIFY( qAbs( encoder.maxFps( 300 ) - 2400000.0 / ( 2790 * 8 )) < 1e-6 );
+}
+
+QTEST_APPLESS_MAIN( TestWs2812 )
+
+#include "tst_ws2812.moc"
@@ -0,0 +1,21 @@
+QT       = core testlib
+
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+TARGET = tst_ws2812
+
+PROTOCOL_DIR = $$PWD/../../../radiopixel-protocol
+
+INCLUDEPATH += $$PWD/../.. $$PROTOCOL_DIR
+
+SOURCES += \
+    tst_ws2812.cpp \
+    ../../StripBase.cpp \
+    ../../Stripper.cpp \
+    ../../Ws2812Encoder.cpp
+
+HEADERS += \
+    ../../StripBase.h \
+    ../../Stripper.h \
+    ../../Ws2812Encoder.h